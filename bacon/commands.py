@@ -66,6 +66,27 @@ def FillRect(x1, y1, x2, y2):
     _commands.append(native.Commands.fill_rect)
     _data.extend((x1, y1, x2, y2))
 
+def DrawSprites(image, sprites, count):
+    _commands.extend((native.Commands.draw_sprites, image, count))
+    _data.extend(sprites[:count * native.sprite_float_count])
+
+def DrawText(font, size, content_scale, flags, text, x, y, width, height, align, vertical_align, overflow):
+    characters = [ord(c) for c in text.decode('utf-8')]
+    _commands.extend((native.Commands.draw_text, font, flags, align, vertical_align, overflow, len(characters)))
+    _commands.extend(characters)
+    _data.extend((size, content_scale, x, y, width, height))
+
+def SetTextBlockGlyphs(block, images, glyphs, count):
+    _commands.extend((native.Commands.set_text_block_glyphs, block, count))
+    _commands.extend(images[:count])
+    _data.extend(glyphs[:count * native.text_block_glyph_float_count])
+
+def DrawTextBlock(block):
+    _commands.extend((native.Commands.draw_text_block, block))
+
+def DestroyTextBlock(block):
+    _commands.extend((native.Commands.destroy_text_block, block))
+
 def SetShaderUniformFloats(handle, uniform, values):
     _commands.extend((native.Commands.set_shader_uniform_floats, handle, uniform, len(values)))
     _data.extend(values)
@@ -125,6 +146,11 @@ def init():
     lib.DrawLine = DrawLine
     lib.DrawRect = DrawRect
     lib.FillRect = FillRect
+    lib.DrawSprites = DrawSprites
+    lib.DrawText = DrawText
+    lib.SetTextBlockGlyphs = SetTextBlockGlyphs
+    lib.DrawTextBlock = DrawTextBlock
+    lib.DestroyTextBlock = DestroyTextBlock
     lib.SetShaderUniformFloats = SetShaderUniformFloats
     lib.SetShaderUniformInts = SetShaderUniformInts
     lib.SetSharedShaderUniformFloats = SetSharedShaderUniformFloats
@@ -1,4 +1,5 @@
 from ctypes import *
+import os
 
 from bacon.core import lib
 from bacon import native
@@ -6,6 +7,34 @@ from bacon import resource
 import bacon.image
 import bacon.text
 
+def set_font_cache_dir(path):
+    '''Set a directory in which to keep the decompressed default font, so that it is only decompressed the first
+    time the game is run and is memory-mapped thereafter.  The directory is created if it does not exist.
+
+    Caching is disabled by default.  Only takes effect if called before the default font is first used; pass
+    ``None`` to disable.
+
+    :param path: path to the cache directory, or ``None``
+    '''
+    if path is None:
+        lib.SetFontCacheDirectory(None)
+        return
+    if not os.path.isdir(path):
+        os.makedirs(path)
+    lib.SetFontCacheDirectory(path.encode('utf-8'))
+
+def set_font_cache_budget(max_faces, max_bytes):
+    '''Limit the memory used by loaded fonts.  Each font file's face is opened when it is first needed, and the
+    least recently used faces are closed once more than ``max_faces`` are open.  Rasterized glyphs small enough to
+    cache are kept until they exceed ``max_bytes``.
+
+    The defaults are 8 faces and 1MB.  Changing the budget empties the cache.
+
+    :param max_faces: maximum number of font faces kept open, at least 1
+    :param max_bytes: maximum size of cached glyph bitmaps, in bytes
+    '''
+    lib.SetFontCacheBudget(max_faces, max_bytes)
+
 class FontMetrics(object):
     '''Aggregates pixel metrics for a font loaded at a particular size.  See :attr:`Font.metrics`
 
@@ -68,6 +97,11 @@ class Glyph(object):
         '''Horizontal advance, in pixels'''
         return self._advance
 
+class _GlyphImage(bacon.image.Image):
+    '''Image of a glyph returned by :meth:`_FontFile.get_glyphs`; owned by the native font, so never unloaded here.'''
+    def unload(self):
+        self._handle = -1
+
 class _FontFile(object):
     _font_files = {}
     _default_font_file = None
@@ -121,6 +155,34 @@ class _FontFile(object):
                      round(offset_y.value) / content_scale, 
                      round(advance.value) / content_scale)
 
+    def get_glyphs(self, size, content_scale, chars, flags):
+        count = len(chars)
+        characters = (c_int * count)(*[ord(c) for c in chars])
+        values = (c_int * (count * native.glyph_int_count))()
+        lib.GetGlyphs(self._handle, size * content_scale, flags, characters, count, values)
+
+        # Distance field glyphs are rasterized at a fixed size, whatever size was requested
+        scale = 1.0 / content_scale
+        if flags & native.FontFlags.distance_field:
+            scale = size / native.distance_field_size
+
+        glyphs = []
+        for i, char in enumerate(chars):
+            image_handle, width, height, offset_x, offset_y, advance = values[i * native.glyph_int_count:(i + 1) * native.glyph_int_count]
+            if image_handle:
+                image = _GlyphImage(width = width * scale,
+                                    height = height * scale,
+                                    content_scale = 1.0 / scale,
+                                    handle = image_handle)
+            else:
+                image = None
+            glyphs.append(Glyph(char, image, offset_x * scale, offset_y * scale, advance * scale))
+        return glyphs
+
+    def prewarm(self, size, content_scale, ranges, flags):
+        flat_ranges = [c for r in ranges for c in r]
+        lib.PrewarmFont(self._handle, size * content_scale, flags, (c_int * len(flat_ranges))(*flat_ranges), len(ranges))
+
     @classmethod
     def get_font_file(cls, file):
         try:
@@ -135,7 +197,7 @@ class _FontFile(object):
         if not cls._default_font_file:
             handle = c_int()
             lib.GetDefaultFont(byref(handle))
-            cls._default_font_file = _FontFile(file=None, handle=handle)
+            cls._default_font_file = _FontFile(file=None, handle=handle.value)
         return cls._default_font_file
 
 class Font(object):
@@ -156,8 +218,10 @@ class Font(object):
         for OS X
     :param float content_scale: optional scaling factor for backing textures of glyphs.  Defaults to
         to :attr:`Window.content_scale`.
+    :param bool distance_field: render glyphs from signed distance fields, which are rasterized once and
+        shared by every size of the font file, so text can be scaled or animated cheaply.
     '''
-    def __init__(self, file, size, light_hinting=False, content_scale=None):
+    def __init__(self, file, size, light_hinting=False, content_scale=None, distance_field=False):
         if type(file) is _FontFile:
             self._font_file = file
         elif file is None:
@@ -176,6 +240,8 @@ class Font(object):
 
         if light_hinting:
             self._flags |= native.FontFlags.light_hinting
+        if distance_field:
+            self._flags |= native.FontFlags.distance_field
 
         self._metrics = self._font_file.get_metrics(size)
 
@@ -205,7 +271,7 @@ class Font(object):
         try:
             return self._glyphs[char]
         except KeyError:
-            glyph = self._font_file.get_glyph(self._size, self._content_scale, char, self._flags)
+            glyph = self._font_file.get_glyphs(self._size, self._content_scale, [char], self._flags)[0]
             self._glyphs[char] = glyph
             return glyph
 
@@ -214,7 +280,46 @@ class Font(object):
 
         :param str: the string to render
         '''
-        return [self.get_glyph(c) for c in str]
+        missing = [c for c in set(str) if c not in self._glyphs]
+        if missing:
+            glyphs = self._font_file.get_glyphs(self._size, self._content_scale, missing, self._flags)
+            self._glyphs.update(zip(missing, glyphs))
+        return [self._glyphs[c] for c in str]
+
+    def prewarm(self, chars):
+        '''Rasterizes glyphs for the given characters on background threads, so that the first frame drawing them
+        does not stall.  The glyphs become available over the following frames; any drawn before then are rasterized
+        immediately as usual.
+
+        :param chars: a string of characters, or a sequence of ``(first, last)`` inclusive character ranges, for
+            example ``[('a', 'z'), ('0', '9')]``
+        '''
+        if isinstance(chars, str):
+            codes = sorted(set(ord(c) for c in chars))
+            ranges = []
+            for code in codes:
+                if ranges and ranges[-1][1] == code - 1:
+                    ranges[-1][1] = code
+                else:
+                    ranges.append([code, code])
+        else:
+            ranges = [(ord(first), ord(last)) for first, last in chars]
+        self._font_file.prewarm(self._size, self._content_scale, ranges, self._flags)
+
+    def save_cache(self, path):
+        '''Writes the glyphs rasterized so far from this font's file, at every size, to a glyph cache file.  Loading
+        it with :func:`load_cache` on a later run restores them without rasterizing.
+
+        :param path: path of the cache file to write
+        '''
+        lib.SaveFontCache(self._font_file._handle, path.encode('utf-8'))
+
+    def load_cache(self, path):
+        '''Adds the glyphs in a cache file written by :func:`save_cache` for the same font file.
+
+        :param path: path of the cache file to read
+        '''
+        lib.LoadFontCache(self._font_file._handle, path.encode('utf-8'))
 
     def measure_string(self, str):
         '''Calculates the width of the given string in this font.
@@ -222,7 +327,10 @@ class Font(object):
         :param str: the string to measure
         :return float: width of the string, in pixels
         '''
-        style = bacon.text.Style(self)
-        run = bacon.text.GlyphRun(style, str)
-        glyph_layout = bacon.text.GlyphLayout([run], 0, 0)
-        return glyph_layout.content_width
\ No newline at end of file
+        content_width = c_float()
+        content_height = c_float()
+        line_count = c_int()
+        lib.LayoutText(self._font_file._handle, self._size, self._content_scale, self._flags, str.encode('utf-8'),
+                       0, 0, -1, -1, bacon.text.Alignment.left, bacon.text.VerticalAlignment.baseline, bacon.text.Overflow.none,
+                       byref(content_width), byref(content_height), byref(line_count))
+        return content_width.value
\ No newline at end of file
@@ -239,3 +239,25 @@ fill_rect.__doc__ = '''Fill a rectangle bounding coordinates ``(x1, y1)`` to ``(
 
 No texture is applied.
 '''
+
+def draw_sprites(image, sprites):
+    '''Draw many copies of regions of an image in a single call, for example the particles of a particle system.
+
+    ``sprites`` is a flat sequence of floats (or a ``ctypes`` float array), with 13 floats per sprite::
+
+        x, y, width, height, rotation, u1, v1, u2, v2, r, g, b, a
+
+    ``(x, y)`` is the center of the sprite and ``rotation`` is in radians about that center.  ``(u1, v1)`` to ``(u2, v2)``
+    is the region of the image to draw, in normalized coordinates with ``(0, 0)`` at the upper-left corner.  The color
+    is multiplied with the current color.
+
+    Where supported, sprites drawn with the default shader are rendered with hardware instancing; otherwise they are
+    drawn as individual quads.
+
+    :param image: an :class:`Image` to draw
+    :param sprites: sequence of sprite floats; its length must be a multiple of 13
+    '''
+    count = len(sprites) // native.sprite_float_count
+    if not isinstance(sprites, Array):
+        sprites = (c_float * len(sprites))(*sprites)
+    lib.DrawSprites(image._handle, sprites, count)
@@ -136,4 +136,34 @@ class Image(object):
         '''
         handle = c_int()
         lib.GetImageRegion(byref(handle), self._handle, x1, y1, x2, y2)
-        return Image(width = x2 - x1, height = y2 - y1, content_scale = self._content_scale, handle = handle)
\ No newline at end of file
+        return Image(width = x2 - x1, height = y2 - y1, content_scale = self._content_scale, handle = handle)
+
+def acquire_transient_image(width, height, sample_nearest=False, content_scale=None):
+    '''Get a temporary render target from a pool of targets shared by the whole game, for example for the intermediate
+    passes of a blur or bloom effect.
+
+    The image is only valid until the end of the current frame, or until it is given to :func:`release_transient_image`;
+    after that it may be returned again by a later call, so it must not be drawn or rendered to.  Its contents are
+    undefined when acquired, so it should be cleared or completely overwritten.  Pooled targets not used for a number of
+    frames are released automatically.
+
+    :param width: width of the image, in texels
+    :param height: height of the image, in texels
+    :param bool sample_nearest: if ``True``, the image is sampled with nearest (point) filtering
+    :param float content_scale: optional scale factor for backing texture, defaults to :attr:`Window.content_scale`
+    :return: :class:`Image`
+    '''
+    if not content_scale:
+        content_scale = bacon.window.content_scale
+    flags = native.ImageFlags.sample_nearest if sample_nearest else 0
+    handle = c_int()
+    lib.AcquireTransientImage(byref(handle), int(width * content_scale), int(height * content_scale), flags)
+    return Image(width = width, height = height, content_scale = content_scale, handle = handle.value)
+
+def release_transient_image(image):
+    '''Return an image acquired with :func:`acquire_transient_image` to the pool before the end of the frame, so that
+    later passes in the same frame can reuse it.
+
+    :param image: an :class:`Image` returned by :func:`acquire_transient_image`
+    '''
+    lib.ReleaseTransientImage(image._handle)
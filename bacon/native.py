@@ -125,6 +125,23 @@ class Commands(object):
     clear = 22
     set_frame_buffer = 23
     set_viewport = 24
+    draw_sprites = 25
+    draw_text = 26
+    set_text_block_glyphs = 27
+    draw_text_block = 28
+    destroy_text_block = 29
+
+# Number of floats per sprite passed to DrawSprites; matches BACON_SPRITE_FLOAT_COUNT
+sprite_float_count = 13
+
+# Number of ints per glyph returned by GetGlyphs; matches BACON_GLYPH_INT_COUNT
+glyph_int_count = 6
+
+# Number of floats per glyph passed to SetTextBlockGlyphs; matches BACON_TEXT_BLOCK_GLYPH_FLOAT_COUNT
+text_block_glyph_float_count = 9
+
+# Size at which distance field glyphs are rasterized; matches BACON_DISTANCE_FIELD_SIZE
+distance_field_size = 48.0
 
 '''Blend values that can be passed to set_blending'''
 @enum
@@ -154,6 +171,7 @@ class ImageFlags(object):
 @flags
 class FontFlags(object):
     light_hinting = 1 << 0
+    distance_field = 1 << 1
 
 @enum
 class ShaderUniformType(object):
@@ -178,6 +196,10 @@ class ShaderUniformType(object):
     sampler2DRect   = 0x8B63
     samplerExternal = 0x8D66
 
+@flags
+class ShaderFlags(object):
+    hot_reload = 1 << 0
+
 @flags
 class SoundFlags(object):
     stream = 1 << 0
@@ -189,6 +211,22 @@ class SoundFlags(object):
 class VoiceFlags(object):
     loop = 1 << 0
 
+@flags
+class AudioOutputFlags(object):
+    unthrottled = 1 << 0
+
+@enum
+class AudioResampleQuality(object):
+    linear = 0
+    cubic = 1
+    polyphase = 2
+
+@enum
+class AudioFilterType(object):
+    none = 0
+    low_pass = 1
+    high_pass = 2
+
 @enum
 class ControllerProfiles(object):
     generic = 0
@@ -527,6 +565,9 @@ def load(function_wrapper = None):
     SetWindowFullscreen = fn(_lib.Bacon_SetWindowFullscreen, c_int)
 
     CreateShader = fn(_lib.Bacon_CreateShader, POINTER(c_int), c_char_p, c_char_p)
+    LoadShader = fn(_lib.Bacon_LoadShader, POINTER(c_int), c_char_p, c_char_p, c_int)
+    CreateShaderFamily = fn(_lib.Bacon_CreateShaderFamily, POINTER(c_int), c_char_p, c_char_p, POINTER(c_char_p), c_int)
+    GetShaderVariant = fn(_lib.Bacon_GetShaderVariant, POINTER(c_int), c_int, c_int)
     EnumShaderUniforms = fn(_lib.Bacon_EnumShaderUniforms, c_int, EnumShaderUniformsCallback, c_void_p)
     SetShaderUniform = fn(_lib.Bacon_SetShaderUniform, c_int, c_int, c_void_p, c_int)
     CreateSharedShaderUniform = fn(_lib.Bacon_CreateSharedShaderUniform, POINTER(c_int), c_char_p, c_int, c_int)
@@ -538,6 +579,8 @@ def load(function_wrapper = None):
 
     UnloadImage = fn(_lib.Bacon_UnloadImage, c_int)
     GetImageSize = fn(_lib.Bacon_GetImageSize, c_int, POINTER(c_int))
+    AcquireTransientImage = fn(_lib.Bacon_AcquireTransientImage, POINTER(c_int), c_int, c_int, c_int)
+    ReleaseTransientImage = fn(_lib.Bacon_ReleaseTransientImage, c_int)
 
     PushTransform = fn(_lib.Bacon_PushTransform)
     PopTransform = fn(_lib.Bacon_PopTransform)
@@ -561,12 +604,25 @@ def load(function_wrapper = None):
     DrawLine = fn(_lib.Bacon_DrawLine, c_float, c_float, c_float, c_float)
     DrawRect = fn(_lib.Bacon_DrawRect, c_float, c_float, c_float, c_float)
     FillRect = fn(_lib.Bacon_FillRect, c_float, c_float, c_float, c_float)
+    DrawSprites = fn(_lib.Bacon_DrawSprites, c_int, POINTER(c_float), c_int)
 
+    SetFontCacheDirectory = fn(_lib.Bacon_SetFontCacheDirectory, c_char_p)
+    SetFontCacheBudget = fn(_lib.Bacon_SetFontCacheBudget, c_int, c_int)
     LoadFont = fn(_lib.Bacon_LoadFont, POINTER(c_int), c_char_p)
     UnloadFont = fn(_lib.Bacon_UnloadFont, c_int)
     GetDefaultFont = fn(_lib.Bacon_GetDefaultFont, POINTER(c_int))
     GetFontMetrics = fn(_lib.Bacon_GetFontMetrics, c_int, c_float, POINTER(c_int), POINTER(c_int))
     GetGlyph = fn(_lib.Bacon_GetGlyph, c_int, c_float, c_int, c_int, POINTER(c_int), POINTER(c_int), POINTER(c_int), POINTER(c_int))
+    GetGlyphs = fn(_lib.Bacon_GetGlyphs, c_int, c_float, c_int, POINTER(c_int), c_int, POINTER(c_int))
+    PrewarmFont = fn(_lib.Bacon_PrewarmFont, c_int, c_float, c_int, POINTER(c_int), c_int)
+    SaveFontCache = fn(_lib.Bacon_SaveFontCache, c_int, c_char_p)
+    LoadFontCache = fn(_lib.Bacon_LoadFontCache, c_int, c_char_p)
+    LayoutText = fn(_lib.Bacon_LayoutText, c_int, c_float, c_float, c_int, c_char_p, c_float, c_float, c_float, c_float, c_int, c_int, c_int, POINTER(c_float), POINTER(c_float), POINTER(c_int))
+    DrawText = fn(_lib.Bacon_DrawText, c_int, c_float, c_float, c_int, c_char_p, c_float, c_float, c_float, c_float, c_int, c_int, c_int)
+    CreateTextBlock = fn(_lib.Bacon_CreateTextBlock, POINTER(c_int))
+    DestroyTextBlock = fn(_lib.Bacon_DestroyTextBlock, c_int)
+    SetTextBlockGlyphs = fn(_lib.Bacon_SetTextBlockGlyphs, c_int, POINTER(c_int), POINTER(c_float), c_int)
+    DrawTextBlock = fn(_lib.Bacon_DrawTextBlock, c_int)
 
     GetKeyState = fn(_lib.Bacon_GetKeyState, c_int, POINTER(c_int))
     SetKeyEventHandler = fn(_lib.Bacon_SetKeyEventHandler, KeyEventHandler)
@@ -581,9 +637,23 @@ def load(function_wrapper = None):
     GetControllerPropertyInt = fn(_lib.Bacon_GetControllerPropertyInt, c_int, c_int, POINTER(c_int))
     GetControllerPropertyString = fn(_lib.Bacon_GetControllerPropertyString, c_int, c_int, POINTER(c_char), POINTER(c_int))
 
+    SetAudioOutputFile = fn(_lib.Bacon_SetAudioOutputFile, c_char_p, c_int)
+    SetAudioResampleQuality = fn(_lib.Bacon_SetAudioResampleQuality, c_int)
+    SetAudioMaxVoices = fn(_lib.Bacon_SetAudioMaxVoices, c_int)
+    SetAudioCacheDirectory = fn(_lib.Bacon_SetAudioCacheDirectory, c_char_p)
     LoadSound = fn(_lib.Bacon_LoadSound, POINTER(c_int), c_char_p, c_int)
+    LoadSoundRegion = fn(_lib.Bacon_LoadSoundRegion, POINTER(c_int), c_char_p, c_int, c_int, c_int)
     UnloadSound = fn(_lib.Bacon_UnloadSound, c_int)
     PlaySound = fn(_lib.Bacon_PlaySound, c_int)
+    PlaySoundEx = fn(_lib.Bacon_PlaySoundEx, c_int, c_float, c_float, c_float)
+    SetSoundMaxVoices = fn(_lib.Bacon_SetSoundMaxVoices, c_int, c_int)
+    SetSoundPriority = fn(_lib.Bacon_SetSoundPriority, c_int, c_int)
+    SetSoundBus = fn(_lib.Bacon_SetSoundBus, c_int, c_int)
+
+    CreateAudioBus = fn(_lib.Bacon_CreateAudioBus, POINTER(c_int), c_int)
+    SetAudioBusGain = fn(_lib.Bacon_SetAudioBusGain, c_int, c_float)
+    SetAudioBusFilter = fn(_lib.Bacon_SetAudioBusFilter, c_int, c_int, c_float, c_float)
+    SetAudioBusDucking = fn(_lib.Bacon_SetAudioBusDucking, c_int, c_int, c_float)
 
     CreateVoice = fn(_lib.Bacon_CreateVoice, POINTER(c_int), c_int)
     DestroyVoice = fn(_lib.Bacon_DestroyVoice, c_int)
@@ -592,6 +662,7 @@ def load(function_wrapper = None):
     SetVoiceGain = fn(_lib.Bacon_SetVoiceGain, c_int, c_float)
     SetVoicePitch = fn(_lib.Bacon_SetVoicePitch, c_int, c_float)
     SetVoicePan = fn(_lib.Bacon_SetVoicePan, c_int, c_float)
+    SetVoiceBus = fn(_lib.Bacon_SetVoiceBus, c_int, c_int)
     SetVoiceLoopPoints = fn(_lib.Bacon_SetVoiceLoopPoints, c_int, c_int, c_int)
     SetVoiceCallback = fn(_lib.Bacon_SetVoiceCallback, c_int, VoiceCallback)
     IsVoicePlaying = fn(_lib.Bacon_IsVoicePlaying, c_int, POINTER(c_int))
@@ -4,6 +4,7 @@ from bacon.core import lib
 from bacon.readonly_collections import ReadOnlyDict
 from bacon import native
 from bacon import commands
+from bacon import resource
 
 ShaderUniformType = native.ShaderUniformType
 
@@ -36,33 +37,71 @@ class Shader(object):
                                 """
                                 precision highp float;
                                 uniform sampler2D g_Texture0;
+                                uniform float g_Texture0Alpha;
                                 varying vec2 v_TexCoord0;
                                 varying vec4 v_Color;
                                 
                                 void main()
                                 {
-                                    gl_FragColor = v_Color * texture2D(g_Texture0, v_TexCoord0);
+                                    vec4 texel = texture2D(g_Texture0, v_TexCoord0);
+                                    gl_FragColor = v_Color * mix(texel, texel.aaaa, g_Texture0Alpha);
                                 }
                                 """)
 
+    Font glyph images are stored with a single (alpha) channel, which ``texture2D`` returns as ``(0, 0, 0, a)``.
+    ``g_Texture0Alpha`` is ``1.0`` while such an image is bound to ``g_Texture0`` and ``0.0`` otherwise; a custom
+    shader that samples glyph images must expand the texel as above, or text drawn with it appears black.
+
     The shading language is OpenGL-ES SL 2.  The shader will be translated automatically into
     HLSL on Windows, and into GLSL on other desktop platforms.
 
+    Alternatively the shader source can be loaded from files::
+
+        Shader(vertex_file='blur.vert', fragment_file='blur.frag', hot_reload=True)
+
+    With ``hot_reload``, the files are checked for changes while the game is running and the shader is
+    recompiled at the start of the next frame.  Uniform values that have already been set are kept.  If the
+    new source fails to compile the error is logged and the previous version continues to be used.
+
     :param vertex_source: string of source code for the vertex shader
     :param fragment_source: string of source code for the fragment shader
+    :param vertex_file: path to a file containing the vertex shader source
+    :param fragment_file: path to a file containing the fragment shader source
+    :param bool hot_reload: if ``True``, reload the shader when ``vertex_file`` or ``fragment_file`` is modified
     '''
-    def __init__(self, vertex_source, fragment_source):
+    def __init__(self, vertex_source=None, fragment_source=None, vertex_file=None, fragment_file=None, hot_reload=False):
+        handle = c_int()
+        if vertex_file and fragment_file:
+            if vertex_source or fragment_source:
+                raise ValueError('`vertex_source` and `fragment_source` are not valid arguments if files are given')
+
+            vertex_file = resource.get_resource_path(vertex_file)
+            fragment_file = resource.get_resource_path(fragment_file)
+            with open(vertex_file, 'r') as f:
+                vertex_source = f.read()
+            with open(fragment_file, 'r') as f:
+                fragment_source = f.read()
+
+            flags = 0
+            if hot_reload:
+                flags |= native.ShaderFlags.hot_reload
+            lib.LoadShader(byref(handle), vertex_file.encode('utf-8'), fragment_file.encode('utf-8'), flags)
+        elif vertex_source and fragment_source:
+            lib.CreateShader(byref(handle), vertex_source.encode('utf-8'), fragment_source.encode('utf-8'))
+        else:
+            raise ValueError('invalid arguments to Shader, must specify either source or files for both stages')
+
+        self._init(handle.value, vertex_source, fragment_source)
+
+    def _init(self, handle, vertex_source, fragment_source):
         self._vertex_source = vertex_source
         self._fragment_source = fragment_source
-
-        handle = c_int()
-        lib.CreateShader(byref(handle), vertex_source.encode('utf-8'), fragment_source.encode('utf-8'))
-        self._handle = handle.value
+        self._handle = handle
 
         self._uniforms = {}
 
         enum_uniform_callback = lib.EnumShaderUniformsCallback(self._on_enum_uniform)
-        lib.EnumShaderUniforms(handle, enum_uniform_callback, None)
+        lib.EnumShaderUniforms(self._handle, enum_uniform_callback, None)
 
         self._uniforms = ReadOnlyDict(self.uniforms)
 
@@ -89,7 +128,7 @@ class Shader(object):
 
     @property
     def vertex_source(self):
-        '''Get the vertex shader source
+        '''Get the vertex shader source, as it was when the shader was created
 
         :type: ``str``
         '''
@@ -97,12 +136,73 @@ class Shader(object):
 
     @property
     def fragment_source(self):
-        '''Get the fragment shader source
+        '''Get the fragment shader source, as it was when the shader was created
 
         :type: ``str``
         '''
         return self._fragment_source
 
+class ShaderFamily(object):
+    '''A set of shader variants compiled from the same source, each with a different combination of
+    preprocessor ``#define`` keys enabled.  This allows branches that are constant for a draw call to be
+    resolved at compile time instead of with a uniform::
+
+        blur = ShaderFamily(vertex_source, fragment_source, defines=['HORIZONTAL', 'HIGH_QUALITY'])
+        bacon.set_shader(blur.get_variant('HORIZONTAL'))
+
+    Each variant is compiled the first time it is requested and cached thereafter.  Enabled keys are defined to
+    ``1`` at the top of both the vertex and fragment source (after ``#version``, if present).  Variants are
+    independent :class:`Shader` objects, so non-shared uniform values must be set on each variant separately.
+
+    :param vertex_source: string of source code for the vertex shader
+    :param fragment_source: string of source code for the fragment shader
+    :param defines: sequence of up to 32 preprocessor keys that variants may enable
+    '''
+    def __init__(self, vertex_source, fragment_source, defines):
+        self._vertex_source = vertex_source
+        self._fragment_source = fragment_source
+        self._defines = list(defines)
+        self._variants = {}
+
+        encoded_defines = [define.encode('utf-8') for define in self._defines]
+        native_defines = (c_char_p * len(encoded_defines))(*encoded_defines)
+        handle = c_int()
+        lib.CreateShaderFamily(byref(handle), vertex_source.encode('utf-8'), fragment_source.encode('utf-8'), native_defines, len(encoded_defines))
+        self._handle = handle.value
+
+    @property
+    def defines(self):
+        '''The preprocessor keys that variants of this family may enable.
+
+        :type: ``list`` of ``str``
+        '''
+        return list(self._defines)
+
+    def get_variant(self, *defines):
+        '''Get the shader variant with the given keys enabled, compiling it if necessary.
+
+        :param defines: keys to enable; each must be one of :attr:`defines`
+        :return: :class:`Shader`
+        '''
+        mask = 0
+        for define in defines:
+            try:
+                mask |= 1 << self._defines.index(define)
+            except ValueError:
+                raise ValueError('Unknown shader define %s' % define)
+
+        try:
+            return self._variants[mask]
+        except KeyError:
+            pass
+
+        handle = c_int()
+        lib.GetShaderVariant(byref(handle), self._handle, mask)
+        shader = Shader.__new__(Shader)
+        shader._init(handle.value, self._vertex_source, self._fragment_source)
+        self._variants[mask] = shader
+        return shader
+
 class _ShaderUniformNativeType(object):
     def __init__(self, ctype, converter=None):
         self.ctype = ctype
@@ -1,3 +1,4 @@
+import os
 from ctypes import *
 
 from bacon.core import lib
@@ -5,6 +6,9 @@ from bacon import native
 from bacon import resource
 import bacon.core
 
+AudioResampleQuality = native.AudioResampleQuality
+AudioFilterType = native.AudioFilterType
+
 class Sound(object):
     '''Loads a sound from disk.  Supported formats are WAV (``.wav``) and Ogg Vorbis (``.ogg``).
 
@@ -13,28 +17,60 @@ class Sound(object):
 
     Sounds can be streamed by specifying ``stream=True``; this causes them to load faster but incur a small
     latency on playback.  Background music should always be streamed.  Sound effects should not be streamed.
+    Streamed files are memory-mapped once when loaded, and shared by every voice playing them.
+
+    Sounds can also be loaded from part of a larger packed archive file by giving the ``offset`` and ``size`` of the
+    sound data within it, along with its ``format``.
+
+    Sounds are kept in memory until explicitly unloaded, see :func:`unload`.  Loading the same file more than once
+    (without ``stream=True``) shares the decoded sound rather than decoding it again; see also :func:`set_audio_cache_dir`.
 
-    Sounds are kept in memory until explicitly unloaded, see :func:`unload`.
+    Sounds played with :func:`play` share a pool of voices, see :func:`set_audio_max_voices`.  Rapidly repeated
+    sound effects can be limited with ``max_voices``; once that many instances are playing, the weakest instance is
+    restarted instead of adding another.
+
+    Sounds are mixed directly into the output unless routed to an :class:`AudioBus` with :attr:`bus`.
 
     :param file: path to the sound file to load.  The sound format is deduced from the file extension.
     :param stream: if ``True``, the sound is streamed from disk; otherwise it is fully cached in memory.
+    :param max_voices: maximum number of instances of the sound played with :func:`play` at once, or ``0`` for no limit
+    :param priority: instances of sounds with a lower priority are stopped first when the voice pool is full
+    :param offset: byte offset of the sound data within ``file``, if it is an archive
+    :param size: size in bytes of the sound data within ``file``; if ``None``, the whole file is loaded
+    :param format: ``'wav'`` or ``'ogg'``; required if ``size`` is given, otherwise deduced from the file extension
     '''
     _handle = -1
+    _max_voices = 0
+    _priority = 0
+    _bus = None
 
-    def __init__(self, file, stream=False):
+    def __init__(self, file, stream=False, max_voices=0, priority=0, offset=0, size=None, format=None):
         flags = 0
         if stream:
             flags |= native.SoundFlags.stream
 
-        if file.lower().endswith('.wav'):
+        if format is None:
+            format = os.path.splitext(file)[1][1:]
+        if format.lower() == 'wav':
             flags |= native.SoundFlags.format_wav
-        elif file.lower().endswith('.ogg'):
+        elif format.lower() == 'ogg':
             flags |= native.SoundFlags.format_ogg
 
         handle = c_int()
-        lib.LoadSound(byref(handle), resource.get_resource_path(file).encode('utf-8'), flags)
+        path = resource.get_resource_path(file).encode('utf-8')
+        if size is None and not offset:
+            lib.LoadSound(byref(handle), path, flags)
+        else:
+            if size is None:
+                size = os.path.getsize(resource.get_resource_path(file)) - offset
+            lib.LoadSoundRegion(byref(handle), path, offset, size, flags)
         self._handle = handle.value
 
+        if max_voices:
+            self.max_voices = max_voices
+        if priority:
+            self.priority = priority
+
     def __del__(self):
         self.unload()
 
@@ -44,12 +80,34 @@ class Sound(object):
             lib.UnloadSound(self._handle)
             self._handle = -1
 
+    def _get_max_voices(self):
+        return self._max_voices
+    def _set_max_voices(self, max_voices):
+        self._max_voices = max_voices
+        lib.SetSoundMaxVoices(self._handle, max_voices)
+    max_voices = property(_get_max_voices, _set_max_voices, doc='''Get or set the maximum number of instances of the sound played with :func:`play` at once, or ``0`` for no limit (the default).''')
+
+    def _get_priority(self):
+        return self._priority
+    def _set_priority(self, priority):
+        self._priority = priority
+        lib.SetSoundPriority(self._handle, priority)
+    priority = property(_get_priority, _set_priority, doc='''Get or set the priority of the sound when the voice pool is full; the quietest, then oldest, instance of the lowest priority is stopped to make room.  Defaults to 0.''')
+
+    def _get_bus(self):
+        return self._bus
+    def _set_bus(self, bus):
+        self._bus = bus
+        lib.SetSoundBus(self._handle, bus._handle if bus else 0)
+    bus = property(_get_bus, _set_bus, doc='''Get or set the :class:`AudioBus` that the sound is mixed into when played with :func:`play`, and that new :class:`Voice` instances of it start on.  ``None`` (the default) mixes directly into the output.''')
+
     def play(self, gain=None, pan=None, pitch=None):
         '''Play the sound as a `one-shot`.
 
         The sound will be played to completion.  If the sound is played more than once at a time, it will mix
-        with all previous instances of itself.  If you need more control over the playback of sounds, see
-        :class:`Voice`.
+        with all previous instances of itself, up to :attr:`max_voices`.  If the voice pool is full, the new
+        instance replaces a playing instance of equal or lower :attr:`priority`, or is not played at all.  If you need
+        more control over the playback of sounds, see :class:`Voice`.
 
         :param gain: optional volume level to play the sound back at, between 0.0 and 1.0 (defaults to 1.0)
         :param pan: optional stereo pan, between -1.0 (left) and 1.0 (right)
@@ -58,14 +116,97 @@ class Sound(object):
         if gain is None and pan is None and pitch is None:
             lib.PlaySound(self._handle)
         else:
-            voice = Voice(self)
-            if gain is not None:
-                voice.gain = gain
-            if pan is not None:
-                voice.pan = pan
-            if pitch is not None:
-                voice.pitch = pitch
-            voice.play()
+            lib.PlaySoundEx(self._handle,
+                            1.0 if gain is None else gain,
+                            0.0 if pan is None else pan,
+                            1.0 if pitch is None else pitch)
+
+def set_audio_resample_quality(quality):
+    '''Set the interpolation used when a voice is played at a pitch other than ``1.0``, or when a sound's sample rate
+    differs from the output rate.  Voices playing at their native rate are unaffected.  Higher qualities reduce
+    aliasing and muffling of pitched sounds, at a greater CPU cost per voice.
+
+    :param quality: a value from the :class:`AudioResampleQuality` enumeration; the default is ``linear``
+    '''
+    lib.SetAudioResampleQuality(quality)
+
+def set_audio_max_voices(max_voices):
+    '''Set the size of the voice pool shared by sounds played with :func:`Sound.play`.  When this many are playing,
+    further sounds stop a playing sound of equal or lower :attr:`Sound.priority`.  Voices created with :class:`Voice`
+    are not affected.
+
+    :param max_voices: maximum number of pooled voices playing at once; the default is 32
+    '''
+    lib.SetAudioMaxVoices(max_voices)
+
+def set_audio_cache_dir(path):
+    '''Set a directory in which to cache decoded Ogg Vorbis sounds, so that sounds loaded without ``stream=True``
+    are only decoded the first time the game is run.  Cached sounds are memory-mapped rather than read, and are
+    decoded again if the original file changes.  The directory is created if it does not exist.
+
+    Caching is disabled by default.  Only sounds loaded after this call are affected; pass ``None`` to disable.
+
+    :param path: path to the cache directory, or ``None``
+    '''
+    if path is None:
+        lib.SetAudioCacheDirectory(None)
+        return
+    if not os.path.isdir(path):
+        os.makedirs(path)
+    lib.SetAudioCacheDirectory(path.encode('utf-8'))
+
+class AudioBus(object):
+    '''A submix that sounds and voices can be routed to, for example to control the volume of all music or all sound
+    effects together.  Each bus sums everything routed to it, applies its :func:`filter <set_filter>`, :attr:`gain` and
+    :func:`ducking <duck>` once per audio buffer, then mixes the result into its parent bus, or the output::
+
+        music_bus = bacon.AudioBus('music')
+        sfx_bus = bacon.AudioBus('sfx')
+        music_bus.duck(sfx_bus, 0.5)
+        music_voice.bus = music_bus
+        explosion_sound.bus = sfx_bus
+
+    Buses remain in use until the game exits.
+
+    :param name: name of the bus, for debugging
+    :param parent: :class:`AudioBus` to mix into, or ``None`` to mix into the output
+    '''
+    _gain = 1.0
+
+    def __init__(self, name=None, parent=None):
+        self.name = name
+        self.parent = parent
+        handle = c_int()
+        lib.CreateAudioBus(byref(handle), parent._handle if parent else 0)
+        self._handle = handle.value
+
+    def __repr__(self):
+        return 'AudioBus(%r)' % self.name
+
+    def _get_gain(self):
+        return self._gain
+    def _set_gain(self, gain):
+        self._gain = gain
+        lib.SetAudioBusGain(self._handle, gain)
+    gain = property(_get_gain, _set_gain, doc='''Get or set the gain (volume) applied to everything mixed into the bus.  Changes are smoothed over one audio buffer.  Defaults to 1.0''')
+
+    def set_filter(self, filter_type, cutoff=1000.0, q=0.7071):
+        '''Filter everything mixed into the bus.
+
+        :param filter_type: a value from the :class:`AudioFilterType` enumeration; ``none`` removes the filter
+        :param cutoff: cutoff frequency, in Hz
+        :param q: resonance of the filter at the cutoff; the default gives a flat response without a peak
+        '''
+        lib.SetAudioBusFilter(self._handle, filter_type, cutoff, q)
+
+    def duck(self, sidechain, gain=0.3):
+        '''Reduce the volume of the bus while another bus is audible; for example, to lower music under dialogue.
+        The volume fades down over about 20 milliseconds and recovers over about 300 milliseconds.
+
+        :param sidechain: the :class:`AudioBus` that triggers ducking, or ``None`` to stop ducking
+        :param gain: gain multiplier applied while ducked
+        '''
+        lib.SetAudioBusDucking(self._handle, sidechain._handle if sidechain else 0, gain)
 
 class Voice(object):
     '''Handle to a single instance of a sound.  Voices can be used to:
@@ -108,6 +249,7 @@ class Voice(object):
 
     def __init__(self, sound, loop=False):
         self._sound = sound
+        self._bus = sound.bus
         
         flags = 0
         if loop:
@@ -152,6 +294,13 @@ class Voice(object):
         lib.SetVoicePan(self._handle, pan)
     pan = property(_get_pan, _set_pan, doc='''Get or set the stereo pan of the sound, between -1.0 and 1.0.''')
 
+    def _get_bus(self):
+        return self._bus
+    def _set_bus(self, bus):
+        self._bus = bus
+        lib.SetVoiceBus(self._handle, bus._handle if bus else 0)
+    bus = property(_get_bus, _set_bus, doc='''Get or set the :class:`AudioBus` the voice is mixed into, or ``None`` to mix directly into the output.  Defaults to the :attr:`Sound.bus` of its sound.''')
+
     def _is_playing(self):
         playing = c_int()
         try:
@@ -1,7 +1,9 @@
 import collections
+from ctypes import *
 
 import bacon
 from bacon import native
+from bacon.core import lib
 
 class Style(object):
     def __init__(self, font, color=None, background_color=None):
@@ -54,6 +56,56 @@ class Overflow(object):
     wrap = 1
     wrap_characters = 2
 
+class _TextBlock(object):
+    '''Native glyph quads of a laid out :class:`GlyphLayout`, drawn in one call under the current transform and color.
+    '''
+    _handle = -1
+
+    def __init__(self):
+        handle = c_int()
+        lib.CreateTextBlock(byref(handle))
+        self._handle = handle.value
+
+    def __del__(self):
+        if self._handle != -1:
+            lib.DestroyTextBlock(self._handle)
+        self._handle = -1
+
+    def set_lines(self, lines):
+        images = []
+        glyphs = []
+        for line in lines:
+            x = line.x
+            y = line.y
+            for run in line.runs:
+                color = run.style.color
+                if color is None:
+                    color = (1, 1, 1, 1)
+
+                # Target pixels per texel of the run's distance field glyphs, so they are drawn with the distance
+                # field shader at the right smoothing; 0 for ordinary glyphs
+                font = run.style.font
+                scale = 0
+                if font._flags & native.FontFlags.distance_field:
+                    scale = font._size / native.distance_field_size * font._content_scale
+
+                for glyph in run.glyphs:
+                    image = glyph.image
+                    if image:
+                        x1 = x + glyph.offset_x
+                        y1 = y - glyph.offset_y
+                        images.append(image._handle)
+                        glyphs.extend((x1, y1, x1 + image.width, y1 + image.height))
+                        glyphs.extend(color)
+                        glyphs.append(scale)
+                    x += glyph.advance
+
+        count = len(images)
+        lib.SetTextBlockGlyphs(self._handle, (c_int * count)(*images), (c_float * len(glyphs))(*glyphs), count)
+
+    def draw(self):
+        lib.DrawTextBlock(self._handle)
+
 class GlyphLayout(object):
     '''Caches a layout of glyphs rendering a given string with bounding rectangle, layout metrics.
     '''
@@ -72,6 +124,9 @@ class GlyphLayout(object):
         self._content_height = None
         self._lines = None
 
+        self._text_block = None
+        self._text_block_colors = None
+
     def _get_runs(self):
         return self._runs
     def _set_runs(self, runs):
@@ -153,8 +208,20 @@ class GlyphLayout(object):
             self._update()
         return self._content_height
 
+    def _get_text_block(self):
+        # Built on first draw, and rebuilt when the layout changes (see _update) or a run's color does
+        lines = self.lines
+        colors = [tuple(run.style.color) if run.style.color is not None else None for line in lines for run in line.runs]
+        if self._text_block is None:
+            self._text_block = _TextBlock()
+        if colors != self._text_block_colors:
+            self._text_block.set_lines(lines)
+            self._text_block_colors = colors
+        return self._text_block
+
     def _update(self):
         self._dirty = False
+        self._text_block_colors = None
 
         content_width = sum(run.advance for run in self._runs)
         if (self._width is None or 
@@ -298,46 +365,34 @@ class GlyphLayout(object):
 
 
 
-def draw_string(font, text, x, y, width=None, height=None, align=Alignment.left, vertical_align=VerticalAlignment.baseline):
+def draw_string(font, text, x, y, width=None, height=None, align=Alignment.left, vertical_align=VerticalAlignment.baseline, overflow=Overflow.wrap):
     '''Draw a string with the given font.
 
-    :note: Text alignment and word-wrapping is not yet implemented.  The text is rendered with the left edge and
-        baseline at ``(x, y)``.
+    The string is laid out and drawn natively; use :class:`GlyphLayout` directly to mix styles within a block of text.
 
     :param font: the :class:`Font` to render text with
     :param text: a string of text to render.
+    :param x: left edge of the text, or of the bounding box if ``width`` is given
+    :param y: baseline of the first line, or top of the bounding box if ``height`` is given
+    :param width: optional width of the bounding box; text is aligned within it and wrapped according to ``overflow``
+    :param height: optional height of the bounding box; text is aligned vertically within it
+    :param align: an :class:`Alignment` enumerator
+    :param vertical_align: a :class:`VerticalAlignment` enumerator
+    :param overflow: an :class:`Overflow` enumerator, specifying how lines longer than ``width`` are broken
     '''
-    style = Style(font)
-    run = GlyphRun(style, text)
-    glyph_layout = GlyphLayout([run], x, y, width, height, align, vertical_align)
-    draw_glyph_layout(glyph_layout)
+    if width is None:
+        width = -1
+    if height is None:
+        height = -1
+    lib.DrawText(font._font_file._handle, font._size, font._content_scale, font._flags, text.encode('utf-8'),
+               x, y, width, height, align, vertical_align, overflow)
 
 
 def draw_glyph_layout(glyph_layout):
-    '''Draw a prepared :class:`GlyphLayout`
-    '''
-    pushed_color = False
+    '''Draw a prepared :class:`GlyphLayout`.
 
-    # Draw lines
-    for line in glyph_layout.lines:
-        x = line.x
-        y = line.y
-        
-        for run in line.runs:
-            style = run.style
-            if style.color is not None:
-                if not pushed_color:
-                    bacon.push_color()
-                    pushed_color = True
-                bacon.set_color(*style.color)
-            elif pushed_color:
-                bacon.pop_color()
-                pushed_color = False
-
-            for glyph in run.glyphs:
-                if glyph.image:
-                    bacon.draw_image(glyph.image, x + glyph.offset_x, y - glyph.offset_y)
-                x += glyph.advance
-
-    if pushed_color:
-        bacon.pop_color()
+    The layout's glyphs are kept natively and drawn in one call under the current transform and color, so a layout
+    that does not change is cheap to draw every frame.  The glyphs are rebuilt after the layout's runs, position, box
+    or alignment change, or the color of a run's style does.  A run's color is multiplied with the current color.
+    '''
+    glyph_layout._get_text_block().draw()
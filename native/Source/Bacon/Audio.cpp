@@ -4,18 +4,75 @@
 using namespace Bacon;
 
 #include <string>
+#include <unordered_map>
+#include <vector>
 using namespace std;
 
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
 #include <gorilla/ga.h>
 #include <gorilla/gau.h>
 
 namespace {
 	
+	// Device buffers; the mix thread refills each as soon as the device frees it, so latency is
+	// roughly AudioBufferCount * AudioBufferSamples (~23 ms at 44.1 kHz)
+	const int AudioBufferCount = 4;
+	const int AudioBufferSamples = 256;
+	
+	// One-shot voice pool; idle handles are kept for reuse up to this multiple of the voice limit
+	const int DefaultMaxVoices = 32;
+	const int MaxPooledVoicesPerVoice = 2;
+	
+	// Decoded PCM cache file: header, then the source path, then the samples at DataOffset
+	const unsigned int PcmCacheMagic = 0x4d435042; // "BPCM"
+	const unsigned int PcmCacheVersion = 1;
+	const unsigned int PcmCacheDataAlignment = 16;
+	
+	struct PcmCacheHeader
+	{
+		unsigned int m_Magic;
+		unsigned int m_Version;
+		long long m_SourceSize;
+		long long m_SourceModifiedTime;
+		int m_SampleRate;
+		int m_BitsPerSample;
+		int m_NumChannels;
+		unsigned int m_PathLength;
+		unsigned int m_DataOffset;
+		unsigned int m_DataSize;
+	};
+	
+	struct FileMapping
+	{
+		const void* m_Base;
+		size_t m_Size;
+	};
+	
+	// Memory-mapped file shared by every sound loaded from it
+	struct MappedFile
+	{
+		ga_Memory* m_Memory;
+		int m_RefCount;
+	};
+	
 	struct Sound
 	{
 		int m_Flags;
-		string m_Path;
+		string m_Path; // Includes the region for archived sounds; also the key into the decoded sound cache
+		string m_File;
 		ga_Sound* m_Sound;
+		ga_Memory* m_StreamData; // Region of the mapped file, for streamed sounds
+		int m_MaxVoices;
+		int m_Priority;
+		int m_Bus;
+	};
+	
+	struct AudioBus
+	{
+		ga_Bus* m_Bus;
 	};
 	
 	struct Voice
@@ -25,6 +82,23 @@ namespace {
 		Bacon_VoiceCallback m_Callback;
 	};
 	
+	// Decoded sound shared by every Sound loaded from the same path
+	struct CachedSound
+	{
+		ga_Sound* m_Sound;
+		int m_RefCount;
+	};
+	
+	// Handle owned by the one-shot voice pool; restarted rather than recreated once idle
+	struct PooledVoice
+	{
+		ga_Handle* m_Handle;
+		int m_Sound; // 0 once the sound has been unloaded
+		int m_Priority;
+		float m_Gain;
+		unsigned int m_StartOrder;
+	};
+	
 	struct Impl
 	{
 		gau_Manager* m_Manager;
@@ -33,12 +107,29 @@ namespace {
 		
 		HandleArray<Sound> m_Sounds;
 		HandleArray<Voice> m_Voices;
+		HandleArray<AudioBus> m_AudioBuses;
+		vector<PooledVoice> m_PooledVoices;
+		unordered_map<string, CachedSound> m_SoundCache;
+		unordered_map<string, MappedFile> m_MappedFiles;
+		unsigned int m_NextStartOrder;
 
         int m_DebugCounter_Sounds;
         int m_DebugCounter_Voices;
+        int m_DebugCounter_PooledVoices;
 	};
 	static Impl* s_Impl;
 	
+	// Set before Audio_Init to render to a WAV file
+	static string s_OutputFile;
+	static int s_OutputFileFlags;
+	
+	static int s_ResampleQuality = GA_RESAMPLE_QUALITY_LINEAR;
+	
+	static int s_MaxVoices = DefaultMaxVoices;
+	
+	// Directory for decoded PCM of non-streamed Ogg sounds; empty to disable
+	static string s_CacheDirectory;
+	
 }
 
 static int ConvertGAError(int error)
@@ -66,12 +157,81 @@ void Audio_Init()
 {
 	gc_initialize(0);
 	s_Impl = new Impl;
-	s_Impl->m_Manager = gau_manager_create_custom(GA_DEVICE_TYPE_DEFAULT, GAU_THREAD_POLICY_MULTI, 4, 512);
+	if (!s_OutputFile.empty())
+	{
+		s_Impl->m_Manager = gau_manager_create_file(s_OutputFile.c_str(), s_OutputFileFlags, GAU_THREAD_POLICY_MULTI, AudioBufferCount, AudioBufferSamples);
+		if (!s_Impl->m_Manager)
+			Bacon_Log(Bacon_LogLevel_Error, "Audio: Failed to create output file %s", s_OutputFile.c_str());
+	}
+	else
+		s_Impl->m_Manager = gau_manager_create_custom(GA_DEVICE_TYPE_DEFAULT, GAU_THREAD_POLICY_MULTI, AudioBufferCount, AudioBufferSamples);
+	
+	if (!s_Impl->m_Manager)
+	{
+		// No usable audio device; keep mixing in real time so sounds still play and finish
+		Bacon_Log(Bacon_LogLevel_Warning, "Audio: No audio device available, output is disabled");
+		s_Impl->m_Manager = gau_manager_create_custom(GA_DEVICE_TYPE_NULL, GAU_THREAD_POLICY_MULTI, AudioBufferCount, AudioBufferSamples);
+	}
 	s_Impl->m_Mixer = gau_manager_mixer(s_Impl->m_Manager);
+	ga_mixer_setResampleQuality(s_Impl->m_Mixer, s_ResampleQuality);
 	s_Impl->m_StreamManager = gau_manager_streamManager(s_Impl->m_Manager);
+	s_Impl->m_NextStartOrder = 0;
 
     s_Impl->m_DebugCounter_Sounds = DebugOverlay_CreateCounter("Sounds");
     s_Impl->m_DebugCounter_Voices = DebugOverlay_CreateCounter("Voices");
+    s_Impl->m_DebugCounter_PooledVoices = DebugOverlay_CreateCounter("Pooled voices");
+}
+
+int Bacon_SetAudioOutputFile(const char* path, int flags)
+{
+	if (s_Impl)
+		return Bacon_Error_Running;
+	
+	if (flags & ~Bacon_AudioOutputFlags_Unthrottled)
+		return Bacon_Error_InvalidArgument;
+	
+	s_OutputFile = path ? path : "";
+	s_OutputFileFlags = (flags & Bacon_AudioOutputFlags_Unthrottled) ? GA_DEVICE_FILE_FLAG_UNTHROTTLED : 0;
+	return Bacon_Error_None;
+}
+
+int Bacon_SetAudioResampleQuality(int quality)
+{
+	int resampleQuality;
+	switch (quality)
+	{
+		case Bacon_AudioResampleQuality_Linear:
+			resampleQuality = GA_RESAMPLE_QUALITY_LINEAR;
+			break;
+		case Bacon_AudioResampleQuality_Cubic:
+			resampleQuality = GA_RESAMPLE_QUALITY_CUBIC;
+			break;
+		case Bacon_AudioResampleQuality_Polyphase:
+			resampleQuality = GA_RESAMPLE_QUALITY_POLYPHASE;
+			break;
+		default:
+			return Bacon_Error_InvalidArgument;
+	}
+	
+	s_ResampleQuality = resampleQuality;
+	if (s_Impl)
+		ga_mixer_setResampleQuality(s_Impl->m_Mixer, s_ResampleQuality);
+	return Bacon_Error_None;
+}
+
+int Bacon_SetAudioMaxVoices(int maxVoices)
+{
+	if (maxVoices < 1)
+		return Bacon_Error_InvalidArgument;
+	
+	s_MaxVoices = maxVoices;
+	return Bacon_Error_None;
+}
+
+int Bacon_SetAudioCacheDirectory(const char* path)
+{
+	s_CacheDirectory = path ? path : "";
+	return Bacon_Error_None;
 }
 
 void Audio_Shutdown()
@@ -95,9 +255,221 @@ static const char* GetSoundFormat(int flags)
 	return "???";
 }
 
-int Bacon_LoadSound(int* outHandle, const char* path, int flags)
+static string GetPcmCachePath(const string& path)
+{
+	// FNV-1a
+	unsigned int hash = 2166136261u;
+	for (size_t i = 0; i < path.size(); ++i)
+		hash = (hash ^ (unsigned char)path[i]) * 16777619u;
+	
+	char name[16];
+	sprintf(name, "%08x.pcm", hash);
+	return s_CacheDirectory + "/" + name;
+}
+
+static void UnmapFileMapping(void* data, void* context)
 {
-	if (!outHandle || !path)
+	FileMapping* mapping = (FileMapping*)context;
+	Platform_UnmapFile(mapping->m_Base, mapping->m_Size);
+	delete mapping;
+}
+
+static ga_Memory* CreateFileMappingMemory(const void* base, size_t size, size_t offset, size_t dataSize)
+{
+	FileMapping* mapping = new FileMapping;
+	mapping->m_Base = base;
+	mapping->m_Size = size;
+	return ga_memory_create_external((char*)base + offset, (gc_int32)dataSize, UnmapFileMapping, mapping);
+}
+
+static void ReleaseParentMemory(void* data, void* context)
+{
+	ga_memory_release((ga_Memory*)context);
+}
+
+// Returns memory over [offset, offset + size) of the file, or to the end if size is negative.  The file is mapped
+// once and shared by all of its regions; release with ReleaseFileRegion.
+static ga_Memory* AcquireFileRegion(const string& file, int offset, int size)
+{
+	auto it = s_Impl->m_MappedFiles.find(file);
+	if (it == s_Impl->m_MappedFiles.end())
+	{
+		size_t fileSize;
+		const void* data = Platform_MapFile(file.c_str(), &fileSize);
+		if (!data)
+			return nullptr;
+		if (fileSize > 0x7fffffff)
+		{
+			Platform_UnmapFile(data, fileSize);
+			return nullptr;
+		}
+		
+		MappedFile& mapped = s_Impl->m_MappedFiles[file];
+		mapped.m_Memory = CreateFileMappingMemory(data, fileSize, 0, fileSize);
+		mapped.m_RefCount = 0;
+		it = s_Impl->m_MappedFiles.find(file);
+	}
+	
+	ga_Memory* fileMemory = it->second.m_Memory;
+	int fileSize = ga_memory_size(fileMemory);
+	if (size < 0)
+		size = fileSize - offset;
+	if (offset < 0 || offset > fileSize || size < 0 || size > fileSize - offset)
+	{
+		if (it->second.m_RefCount == 0)
+		{
+			ga_memory_release(fileMemory);
+			s_Impl->m_MappedFiles.erase(it);
+		}
+		return nullptr;
+	}
+	
+	// Regions keep the whole mapping alive until every stream reading them has been destroyed
+	++it->second.m_RefCount;
+	ga_memory_acquire(fileMemory);
+	if (offset == 0 && size == fileSize)
+		return fileMemory;
+	return ga_memory_create_external((char*)ga_memory_data(fileMemory) + offset, size, ReleaseParentMemory, fileMemory);
+}
+
+static void ReleaseFileRegion(const string& file, ga_Memory* region)
+{
+	ga_memory_release(region);
+	auto it = s_Impl->m_MappedFiles.find(file);
+	if (--it->second.m_RefCount == 0)
+	{
+		ga_memory_release(it->second.m_Memory);
+		s_Impl->m_MappedFiles.erase(it);
+	}
+}
+
+// Maps previously decoded samples for the file at path; returns nullptr if there are none or they are stale
+static ga_Sound* LoadPcmCache(const string& path, const struct stat& sourceStat)
+{
+	size_t size;
+	const void* data = Platform_MapFile(GetPcmCachePath(path).c_str(), &size);
+	if (!data)
+		return nullptr;
+	
+	const PcmCacheHeader* header = (const PcmCacheHeader*)data;
+	if (size < sizeof(PcmCacheHeader) ||
+		header->m_Magic != PcmCacheMagic ||
+		header->m_Version != PcmCacheVersion ||
+		header->m_SourceSize != (long long)sourceStat.st_size ||
+		header->m_SourceModifiedTime != (long long)sourceStat.st_mtime ||
+		header->m_PathLength != path.size() ||
+		header->m_DataOffset < sizeof(PcmCacheHeader) + header->m_PathLength ||
+		header->m_DataOffset > size ||
+		header->m_DataSize > size - header->m_DataOffset ||
+		header->m_BitsPerSample != 16 ||
+		header->m_NumChannels < 1 || header->m_NumChannels > 2 ||
+		header->m_SampleRate <= 0 ||
+		header->m_DataSize % (header->m_NumChannels * 2) != 0 ||
+		memcmp(header + 1, path.data(), path.size()) != 0)
+	{
+		Platform_UnmapFile(data, size);
+		return nullptr;
+	}
+	
+	ga_Format format;
+	format.sampleRate = header->m_SampleRate;
+	format.bitsPerSample = header->m_BitsPerSample;
+	format.numChannels = header->m_NumChannels;
+	
+	ga_Memory* memory = CreateFileMappingMemory(data, size, header->m_DataOffset, header->m_DataSize);
+	ga_Sound* sound = ga_sound_create(memory, &format);
+	ga_memory_release(memory);
+	return sound;
+}
+
+static void SavePcmCache(const string& path, const struct stat& sourceStat, ga_Sound* sound)
+{
+	ga_Format format;
+	ga_sound_format(sound, &format);
+	
+	PcmCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	header.m_Magic = PcmCacheMagic;
+	header.m_Version = PcmCacheVersion;
+	header.m_SourceSize = (long long)sourceStat.st_size;
+	header.m_SourceModifiedTime = (long long)sourceStat.st_mtime;
+	header.m_SampleRate = format.sampleRate;
+	header.m_BitsPerSample = format.bitsPerSample;
+	header.m_NumChannels = format.numChannels;
+	header.m_PathLength = (unsigned int)path.size();
+	header.m_DataOffset = (sizeof(header) + header.m_PathLength + PcmCacheDataAlignment - 1) & ~(PcmCacheDataAlignment - 1);
+	header.m_DataSize = ga_sound_size(sound);
+	
+	// Written under a temporary name so a partial file is never mapped
+	string cachePath = GetPcmCachePath(path);
+	string tempPath = cachePath + ".tmp";
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (!file)
+		return;
+	
+	char padding[PcmCacheDataAlignment] = { 0 };
+	size_t paddingSize = header.m_DataOffset - sizeof(header) - header.m_PathLength;
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(path.data(), 1, path.size(), file) == path.size() &&
+		fwrite(padding, 1, paddingSize, file) == paddingSize &&
+		fwrite(ga_sound_data(sound), 1, header.m_DataSize, file) == header.m_DataSize;
+	written = fclose(file) == 0 && written;
+	
+	remove(cachePath.c_str());
+	if (!written || rename(tempPath.c_str(), cachePath.c_str()) != 0)
+	{
+		Bacon_Log(Bacon_LogLevel_Warning, "Audio: Failed to write sound cache %s", cachePath.c_str());
+		remove(tempPath.c_str());
+	}
+}
+
+static ga_Sound* DecodeSound(const string& file, int offset, int size, int flags)
+{
+	if (offset == 0 && size < 0)
+		return gau_load_sound_file(file.c_str(), GetSoundFormat(flags));
+	
+	ga_Memory* region = AcquireFileRegion(file, offset, size);
+	if (!region)
+		return nullptr;
+	
+	ga_DataSource* dataSrc = gau_data_source_create_memory(region);
+	ga_SampleSource* sampleSrc;
+	if ((flags & Bacon_SoundFlags_FormatMask) == Bacon_SoundFlags_FormatOgg)
+		sampleSrc = gau_sample_source_create_ogg(dataSrc);
+	else
+		sampleSrc = gau_sample_source_create_wav(dataSrc);
+	ga_data_source_release(dataSrc);
+	ReleaseFileRegion(file, region);
+	
+	ga_Sound* sound = nullptr;
+	if (sampleSrc)
+	{
+		sound = ga_sound_create_sample_source(sampleSrc);
+		ga_sample_source_release(sampleSrc);
+	}
+	return sound;
+}
+
+static ga_Sound* LoadSoundData(Sound* sound, int offset, int size)
+{
+	// Ogg decoding is slow enough to be worth caching; WAV data is already PCM
+	struct stat sourceStat;
+	if (s_CacheDirectory.empty() || (sound->m_Flags & Bacon_SoundFlags_FormatMask) != Bacon_SoundFlags_FormatOgg || stat(sound->m_File.c_str(), &sourceStat) != 0)
+		return DecodeSound(sound->m_File, offset, size, sound->m_Flags);
+	
+	ga_Sound* data = LoadPcmCache(sound->m_Path, sourceStat);
+	if (data)
+		return data;
+	
+	data = DecodeSound(sound->m_File, offset, size, sound->m_Flags);
+	if (data)
+		SavePcmCache(sound->m_Path, sourceStat, data);
+	return data;
+}
+
+static int LoadSound(int* outHandle, const char* path, int offset, int size, int flags)
+{
+	if (!outHandle || !path || offset < 0)
 		return Bacon_Error_InvalidArgument;
 	
 	if (!GetSoundFormat(flags))
@@ -106,20 +478,54 @@ int Bacon_LoadSound(int* outHandle, const char* path, int flags)
 	*outHandle = s_Impl->m_Sounds.Alloc();
 	Sound* sound = s_Impl->m_Sounds.Get(*outHandle);
 	
-	sound->m_Path = "";
+	sound->m_Path = path;
+	sound->m_File = path;
+	if (offset != 0 || size >= 0)
+	{
+		char region[32];
+		sprintf(region, ":%d:%d", offset, size);
+		sound->m_Path += region;
+	}
 	sound->m_Sound = nullptr;
+	sound->m_StreamData = nullptr;
 	sound->m_Flags = flags;
+	sound->m_MaxVoices = 0;
+	sound->m_Priority = 0;
+	sound->m_Bus = 0;
 	if (flags & Bacon_SoundFlags_Stream)
 	{
-		sound->m_Path = path;
+		// Every play of the stream reads from the one mapping instead of reopening the file
+		sound->m_StreamData = AcquireFileRegion(sound->m_File, offset, size);
+		if (!sound->m_StreamData)
+		{
+			Bacon_Log(Bacon_LogLevel_Error, "Audio: Failed to load sound at %s", sound->m_Path.c_str());
+			s_Impl->m_Sounds.Free(*outHandle);
+			return Bacon_Error_IOError;
+		}
 	}
 	else
 	{
-		sound->m_Sound = gau_load_sound_file(path, GetSoundFormat(flags));
-		if (!sound->m_Sound)
+		// Sounds loaded from the same path share their decoded samples
+		auto it = s_Impl->m_SoundCache.find(sound->m_Path);
+		if (it != s_Impl->m_SoundCache.end())
 		{
-			Bacon_Log(Bacon_LogLevel_Error, "Audio: Failed to load sound at %s", path);
-			return Bacon_Error_IOError;
+			ga_sound_acquire(it->second.m_Sound);
+			++it->second.m_RefCount;
+			sound->m_Sound = it->second.m_Sound;
+		}
+		else
+		{
+			sound->m_Sound = LoadSoundData(sound, offset, size);
+			if (!sound->m_Sound)
+			{
+				Bacon_Log(Bacon_LogLevel_Error, "Audio: Failed to load sound at %s", sound->m_Path.c_str());
+				s_Impl->m_Sounds.Free(*outHandle);
+				return Bacon_Error_IOError;
+			}
+			
+			CachedSound& cached = s_Impl->m_SoundCache[sound->m_Path];
+			cached.m_Sound = sound->m_Sound;
+			cached.m_RefCount = 1;
 		}
 	}
 
@@ -128,6 +534,18 @@ int Bacon_LoadSound(int* outHandle, const char* path, int flags)
 	return Bacon_Error_None;
 }
 
+int Bacon_LoadSound(int* outHandle, const char* path, int flags)
+{
+	return LoadSound(outHandle, path, 0, -1, flags);
+}
+
+int Bacon_LoadSoundRegion(int* outHandle, const char* path, int offset, int size, int flags)
+{
+	if (size < 0)
+		return Bacon_Error_InvalidArgument;
+	return LoadSound(outHandle, path, offset, size, flags);
+}
+
 int Bacon_UnloadSound(int soundHandle)
 {
 	Sound* sound = s_Impl->m_Sounds.Get(soundHandle);
@@ -136,38 +554,315 @@ int Bacon_UnloadSound(int soundHandle)
 
     DebugOverlay_AddCounter(s_Impl->m_DebugCounter_Sounds, -1);
 
+	// Idle pooled handles are discarded now; playing ones finish first, as they hold their own reference to the data
+	vector<PooledVoice>& pool = s_Impl->m_PooledVoices;
+	for (size_t i = 0; i < pool.size(); )
+	{
+		if (pool[i].m_Sound != soundHandle)
+		{
+			++i;
+			continue;
+		}
+		
+		if (ga_handle_playing(pool[i].m_Handle))
+		{
+			pool[i].m_Sound = 0;
+			++i;
+			continue;
+		}
+		
+		ga_handle_destroy(pool[i].m_Handle);
+		pool[i] = pool.back();
+		pool.pop_back();
+		DebugOverlay_AddCounter(s_Impl->m_DebugCounter_PooledVoices, -1);
+	}
+
     if (sound->m_Sound)
+	{
+		auto it = s_Impl->m_SoundCache.find(sound->m_Path);
+		if (--it->second.m_RefCount == 0)
+			s_Impl->m_SoundCache.erase(it);
 	    ga_sound_release(sound->m_Sound);
+	}
+	if (sound->m_StreamData)
+		ReleaseFileRegion(sound->m_File, sound->m_StreamData);
+	s_Impl->m_Sounds.Free(soundHandle);
+	return Bacon_Error_None;
+}
+
+int Bacon_SetSoundMaxVoices(int soundHandle, int maxVoices)
+{
+	Sound* sound = s_Impl->m_Sounds.Get(soundHandle);
+	if (!sound)
+		return Bacon_Error_InvalidHandle;
+	if (maxVoices < 0)
+		return Bacon_Error_InvalidArgument;
+	
+	sound->m_MaxVoices = maxVoices;
+	return Bacon_Error_None;
+}
+
+int Bacon_SetSoundPriority(int soundHandle, int priority)
+{
+	Sound* sound = s_Impl->m_Sounds.Get(soundHandle);
+	if (!sound)
+		return Bacon_Error_InvalidHandle;
+	
+	sound->m_Priority = priority;
+	return Bacon_Error_None;
+}
+
+// Bus handle 0 is the mixer's output
+static bool GetAudioBus(int busHandle, ga_Bus** outBus)
+{
+	*outBus = nullptr;
+	if (busHandle == 0)
+		return true;
+	AudioBus* bus = s_Impl->m_AudioBuses.Get(busHandle);
+	if (!bus)
+		return false;
+	*outBus = bus->m_Bus;
+	return true;
+}
+
+int Bacon_SetSoundBus(int soundHandle, int busHandle)
+{
+	Sound* sound = s_Impl->m_Sounds.Get(soundHandle);
+	ga_Bus* bus;
+	if (!sound || !GetAudioBus(busHandle, &bus))
+		return Bacon_Error_InvalidHandle;
+	
+	sound->m_Bus = busHandle;
+	return Bacon_Error_None;
+}
+
+int Bacon_CreateAudioBus(int* outHandle, int parentBusHandle)
+{
+	ga_Bus* parent;
+	if (!GetAudioBus(parentBusHandle, &parent))
+		return Bacon_Error_InvalidHandle;
+	
+	ga_Bus* bus = ga_bus_create(s_Impl->m_Mixer, parent);
+	if (!bus)
+		return Bacon_Error_Unknown;
+	
+	*outHandle = s_Impl->m_AudioBuses.Alloc();
+	s_Impl->m_AudioBuses.Get(*outHandle)->m_Bus = bus;
 	return Bacon_Error_None;
 }
 
+int Bacon_SetAudioBusGain(int busHandle, float gain)
+{
+	AudioBus* bus = s_Impl->m_AudioBuses.Get(busHandle);
+	if (!bus)
+		return Bacon_Error_InvalidHandle;
+	
+	return ConvertGAError(ga_bus_setParamf(bus->m_Bus, GA_BUS_PARAM_GAIN, gain));
+}
+
+int Bacon_SetAudioBusFilter(int busHandle, int filterType, float cutoff, float q)
+{
+	AudioBus* bus = s_Impl->m_AudioBuses.Get(busHandle);
+	if (!bus)
+		return Bacon_Error_InvalidHandle;
+	
+	int gaFilterType;
+	switch (filterType)
+	{
+		case Bacon_AudioFilterType_None:
+			gaFilterType = GA_BUS_FILTER_NONE;
+			break;
+		case Bacon_AudioFilterType_LowPass:
+			gaFilterType = GA_BUS_FILTER_LOWPASS;
+			break;
+		case Bacon_AudioFilterType_HighPass:
+			gaFilterType = GA_BUS_FILTER_HIGHPASS;
+			break;
+		default:
+			return Bacon_Error_InvalidArgument;
+	}
+	if (cutoff <= 0.f || q <= 0.f)
+		return Bacon_Error_InvalidArgument;
+	
+	// Coefficients are computed on the mix thread, once per change
+	ga_bus_setParamf(bus->m_Bus, GA_BUS_PARAM_FILTER_CUTOFF, cutoff);
+	ga_bus_setParamf(bus->m_Bus, GA_BUS_PARAM_FILTER_Q, q);
+	return ConvertGAError(ga_bus_setFilter(bus->m_Bus, gaFilterType));
+}
+
+int Bacon_SetAudioBusDucking(int busHandle, int sidechainBusHandle, float gain)
+{
+	AudioBus* bus = s_Impl->m_AudioBuses.Get(busHandle);
+	ga_Bus* sidechain;
+	if (!bus || !GetAudioBus(sidechainBusHandle, &sidechain))
+		return Bacon_Error_InvalidHandle;
+	if (sidechain == bus->m_Bus)
+		return Bacon_Error_InvalidArgument;
+	
+	ga_bus_setParamf(bus->m_Bus, GA_BUS_PARAM_DUCK_GAIN, gain);
+	return ConvertGAError(ga_bus_setDuckSource(bus->m_Bus, sidechain));
+}
+
 static ga_Handle* CreateHandle(Sound* sound, ga_FinishCallback callback, void* context, gau_SampleSourceLoop** loop)
 {
 	if (sound->m_Sound)
 		return gau_create_handle_sound(s_Impl->m_Mixer, sound->m_Sound, callback, context, loop);
-	else
-		return gau_create_handle_buffered_file(s_Impl->m_Mixer, s_Impl->m_StreamManager, sound->m_Path.c_str(), GetSoundFormat(sound->m_Flags), callback, context, loop);
+	
+	ga_DataSource* dataSrc = gau_data_source_create_memory(sound->m_StreamData);
+	ga_Handle* handle = gau_create_handle_buffered_data(s_Impl->m_Mixer, s_Impl->m_StreamManager, dataSrc, GetSoundFormat(sound->m_Flags), callback, context, loop);
+	ga_data_source_release(dataSrc);
+	return handle;
+}
+
+static ga_Handle* CreatePooledHandle(Sound* sound)
+{
+	ga_Handle* handle = CreateHandle(sound, nullptr, nullptr, nullptr);
+	if (!handle && (sound->m_Flags & Bacon_SoundFlags_Stream))
+		Bacon_Log(Bacon_LogLevel_Error, "Audio: Failed to load sound at %s", sound->m_Path.c_str());
+	return handle;
+}
+
+static void SetHandleParams(ga_Handle* handle, Sound* sound, float gain, float pan, float pitch)
+{
+	ga_Bus* bus;
+	if (!GetAudioBus(sound->m_Bus, &bus))
+		bus = nullptr;
+	ga_handle_setBus(handle, bus);
+	ga_handle_setParamf(handle, GA_HANDLE_PARAM_GAIN, gain);
+	ga_handle_setParamf(handle, GA_HANDLE_PARAM_PAN, pan);
+	ga_handle_setParamf(handle, GA_HANDLE_PARAM_PITCH, pitch);
+}
+
+// Whether pooled voice a should be stolen in preference to b: lowest priority, then quietest, then oldest
+static bool IsBetterVictim(const PooledVoice& a, const PooledVoice& b)
+{
+	if (a.m_Priority != b.m_Priority)
+		return a.m_Priority < b.m_Priority;
+	if (a.m_Gain != b.m_Gain)
+		return a.m_Gain < b.m_Gain;
+	return (int)(a.m_StartOrder - b.m_StartOrder) < 0;
 }
 
 int Bacon_PlaySound(int soundHandle)
+{
+	return Bacon_PlaySoundEx(soundHandle, 1.f, 0.f, 1.f);
+}
+
+int Bacon_PlaySoundEx(int soundHandle, float gain, float pan, float pitch)
 {
 	Sound* sound = s_Impl->m_Sounds.Get(soundHandle);
 	if (!sound)
 		return Bacon_Error_InvalidHandle;
 	
-	ga_Handle* handle = CreateHandle(sound, gau_on_finish_destroy, nullptr, nullptr);
-	if (!handle)
+	// Find an idle handle of this sound to reuse, and the voices to steal if a limit has been reached
+	vector<PooledVoice>& pool = s_Impl->m_PooledVoices;
+	int idle = -1;
+	int discard = -1;
+	int soundVictim = -1;
+	int globalVictim = -1;
+	int soundActive = 0;
+	int totalActive = 0;
+	for (int i = 0; i < (int)pool.size(); )
 	{
-		if (!sound->m_Path.empty())
+		PooledVoice& voice = pool[i];
+		if (ga_handle_playing(voice.m_Handle))
 		{
-			Bacon_Log(Bacon_LogLevel_Error, "Audio: Failed to load sound at %s", sound->m_Path.c_str());
-			return Bacon_Error_IOError;
+			++totalActive;
+			if (voice.m_Sound == soundHandle)
+			{
+				++soundActive;
+				if (soundVictim < 0 || IsBetterVictim(voice, pool[soundVictim]))
+					soundVictim = i;
+			}
+			if (voice.m_Priority <= sound->m_Priority && (globalVictim < 0 || IsBetterVictim(voice, pool[globalVictim])))
+				globalVictim = i;
+		}
+		else if (voice.m_Sound == 0)
+		{
+			// Finished after its sound was unloaded
+			ga_handle_destroy(voice.m_Handle);
+			voice = pool.back();
+			pool.pop_back();
+			DebugOverlay_AddCounter(s_Impl->m_DebugCounter_PooledVoices, -1);
+			continue;
 		}
+		else if (voice.m_Sound == soundHandle)
+		{
+			if (idle < 0)
+				idle = i;
+		}
+		else if (discard < 0 || (int)(voice.m_StartOrder - pool[discard].m_StartOrder) < 0)
+			discard = i;
+		++i;
+	}
+	
+	int index = idle;
+	if (sound->m_MaxVoices > 0 && soundActive >= sound->m_MaxVoices)
+	{
+		// Retrigger the sound's own weakest voice
+		index = soundVictim;
+	}
+	else if (totalActive >= s_MaxVoices)
+	{
+		// Every playing voice outranks this sound; drop it
+		if (globalVictim < 0)
+			return Bacon_Error_None;
+		
+		if (pool[globalVictim].m_Sound == soundHandle)
+			index = globalVictim;
 		else
-			return Bacon_Error_Unknown;
+			ga_handle_stop(pool[globalVictim].m_Handle);
 	}
 	
-	return ConvertGAError(ga_handle_play(handle));
+	// Parameters go ahead of play/restart in the mixer's command queue so the first buffer uses them
+	if (index >= 0)
+	{
+		SetHandleParams(pool[index].m_Handle, sound, gain, pan, pitch);
+		if (ga_handle_restart(pool[index].m_Handle) != GC_SUCCESS)
+		{
+			// Source can't be rewound; replace the handle
+			ga_handle_destroy(pool[index].m_Handle);
+			pool[index].m_Handle = CreatePooledHandle(sound);
+			if (!pool[index].m_Handle)
+			{
+				pool[index] = pool.back();
+				pool.pop_back();
+				DebugOverlay_AddCounter(s_Impl->m_DebugCounter_PooledVoices, -1);
+				return (sound->m_Flags & Bacon_SoundFlags_Stream) ? Bacon_Error_IOError : Bacon_Error_Unknown;
+			}
+			SetHandleParams(pool[index].m_Handle, sound, gain, pan, pitch);
+			ga_handle_play(pool[index].m_Handle);
+		}
+	}
+	else
+	{
+		ga_Handle* handle = CreatePooledHandle(sound);
+		if (!handle)
+			return (sound->m_Flags & Bacon_SoundFlags_Stream) ? Bacon_Error_IOError : Bacon_Error_Unknown;
+		
+		// Keep the pool bounded by replacing the oldest idle handle of another sound
+		if ((int)pool.size() >= s_MaxVoices * MaxPooledVoicesPerVoice && discard >= 0)
+		{
+			ga_handle_destroy(pool[discard].m_Handle);
+			index = discard;
+		}
+		else
+		{
+			index = (int)pool.size();
+			pool.push_back(PooledVoice());
+			DebugOverlay_AddCounter(s_Impl->m_DebugCounter_PooledVoices, 1);
+		}
+		pool[index].m_Handle = handle;
+		SetHandleParams(handle, sound, gain, pan, pitch);
+		ga_handle_play(handle);
+	}
+	
+	PooledVoice& voice = pool[index];
+	voice.m_Sound = soundHandle;
+	voice.m_Priority = sound->m_Priority;
+	voice.m_Gain = gain;
+	voice.m_StartOrder = s_Impl->m_NextStartOrder++;
+	return Bacon_Error_None;
 }
 
 int Bacon_CreateVoice(int* outHandle, int soundHandle, int voiceFlags)
@@ -184,7 +879,7 @@ int Bacon_CreateVoice(int* outHandle, int soundHandle, int voiceFlags)
 	voice->m_Handle = CreateHandle(sound, VoiceCallback, (void*)(size_t)*outHandle, loop);
 	if (!voice->m_Handle)
 	{
-		if (!sound->m_Path.empty())
+		if (sound->m_Flags & Bacon_SoundFlags_Stream)
 		{
 			Bacon_Log(Bacon_LogLevel_Error, "Audio: Failed to load sound at %s", sound->m_Path.c_str());
 			return Bacon_Error_IOError;
@@ -193,6 +888,10 @@ int Bacon_CreateVoice(int* outHandle, int soundHandle, int voiceFlags)
 			return Bacon_Error_Unknown;
 	}
 	
+	ga_Bus* bus;
+	if (GetAudioBus(sound->m_Bus, &bus) && bus)
+		ga_handle_setBus(voice->m_Handle, bus);
+	
     DebugOverlay_AddCounter(s_Impl->m_DebugCounter_Voices, 1);
 
 	return Bacon_Error_None;
@@ -257,6 +956,16 @@ int Bacon_SetVoicePan(int voiceHandle, float pan)
 	return ConvertGAError(ga_handle_setParamf(voice->m_Handle, GA_HANDLE_PARAM_PAN, pan));
 }
 
+int Bacon_SetVoiceBus(int voiceHandle, int busHandle)
+{
+	Voice* voice = s_Impl->m_Voices.Get(voiceHandle);
+	ga_Bus* bus;
+	if (!voice || !GetAudioBus(busHandle, &bus))
+		return Bacon_Error_InvalidHandle;
+	
+	return ConvertGAError(ga_handle_setBus(voice->m_Handle, bus));
+}
+
 int Bacon_SetVoiceLoopPoints(int voiceHandle, int startSample, int endSample)
 {
 	Voice* voice = s_Impl->m_Voices.Get(voiceHandle);
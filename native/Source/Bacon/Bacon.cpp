@@ -79,6 +79,7 @@ int Bacon_InternalTick()
 
 	Audio_Update();
     Controller_Update();
+	Fonts_Update();
 	
 	if (s_TickCallback)
 		s_TickCallback();
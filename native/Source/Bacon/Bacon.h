@@ -153,7 +153,35 @@ enum Bacon_ImageFlags
 
 enum Bacon_FontFlags
 {
-	Bacon_FontFlags_LightHinting = 1 << 0
+	Bacon_FontFlags_LightHinting = 1 << 0,
+	
+	// Glyph images are signed distance fields, which Bacon_DrawText scales to any size with a built-in
+	// shader.  The glyph cache (Bacon_GetGlyphs) rasterizes them once, at a reference size.
+	Bacon_FontFlags_DistanceField = 1 << 1
+};
+
+enum Bacon_TextAlignment
+{
+	Bacon_TextAlignment_Left,
+	Bacon_TextAlignment_Center,
+	Bacon_TextAlignment_Right
+};
+
+enum Bacon_TextVerticalAlignment
+{
+	Bacon_TextVerticalAlignment_Baseline,
+	Bacon_TextVerticalAlignment_Top,
+	Bacon_TextVerticalAlignment_Center,
+	Bacon_TextVerticalAlignment_Bottom
+};
+
+enum Bacon_TextOverflow
+{
+	Bacon_TextOverflow_None,
+	// Break lines at spaces, or between characters if a word does not fit
+	Bacon_TextOverflow_Wrap,
+	// Break lines between any characters
+	Bacon_TextOverflow_WrapCharacters
 };
 
 enum Bacon_ShaderUniformTypes
@@ -181,6 +209,12 @@ enum Bacon_ShaderUniformTypes
 	Bacon_ShaderUniformType_Sampler_External = 0x8D66
 };
 
+enum Bacon_ShaderFlags
+{
+	// Watch the source files and reload the shader when they change
+	Bacon_ShaderFlags_HotReload = 1 << 0
+};
+
 enum Bacon_SoundFlags
 {
 	Bacon_SoundFlags_Stream = 1 << 0,
@@ -195,6 +229,26 @@ enum Bacon_VoiceFlags
 	Bacon_VoiceFlags_Loop = 1 << 0,
 };
 
+enum Bacon_AudioOutputFlags
+{
+	// Mix as fast as possible instead of in real time (offline rendering, benchmarks)
+	Bacon_AudioOutputFlags_Unthrottled = 1 << 0,
+};
+
+enum Bacon_AudioResampleQuality
+{
+	Bacon_AudioResampleQuality_Linear,
+	Bacon_AudioResampleQuality_Cubic,
+	Bacon_AudioResampleQuality_Polyphase,
+};
+
+enum Bacon_AudioFilterType
+{
+	Bacon_AudioFilterType_None,
+	Bacon_AudioFilterType_LowPass,
+	Bacon_AudioFilterType_HighPass,
+};
+
 enum Bacon_Commands
 {
 	Bacon_Command_PushTransform,
@@ -221,9 +275,39 @@ enum Bacon_Commands
 	Bacon_Command_SetShader,
 	Bacon_Command_Clear,
 	Bacon_Command_SetFrameBuffer,
-	Bacon_Command_SetViewport
+	Bacon_Command_SetViewport,
+	Bacon_Command_DrawSprites,
+	Bacon_Command_DrawText,
+	Bacon_Command_SetTextBlockGlyphs,
+	Bacon_Command_DrawTextBlock,
+	Bacon_Command_DestroyTextBlock
 };
 
+// Number of floats per sprite passed to Bacon_DrawSprites:
+//   x, y           center position
+//   width, height  size
+//   rotation       radians, about the center
+//   u1, v1, u2, v2 region of the image, normalized with (0, 0) at the upper-left
+//   r, g, b, a     color
+#define BACON_SPRITE_FLOAT_COUNT 13
+
+// Number of ints per glyph written by Bacon_GetGlyphs:
+//   image                  owned by the font; valid until it is unloaded
+//   width, height          size of the image in pixels
+//   offsetX, offsetY       image offset from the pen position on the baseline
+//   advance                horizontal advance in pixels
+#define BACON_GLYPH_INT_COUNT 6
+
+// Number of floats per glyph passed to Bacon_SetTextBlockGlyphs:
+//   x1, y1, x2, y2 rectangle covered by the glyph's image
+//   r, g, b, a     color, multiplied with the current color when the block is drawn
+//   scale          target pixels per image texel for Bacon_FontFlags_DistanceField glyphs, or 0
+#define BACON_TEXT_BLOCK_GLYPH_FLOAT_COUNT 9
+
+// Size (in points) at which Bacon_GetGlyphs rasterizes Bacon_FontFlags_DistanceField glyphs, whatever
+// size is requested; scale their metrics by size / BACON_DISTANCE_FIELD_SIZE
+#define BACON_DISTANCE_FIELD_SIZE 48
+
 enum Keys
 {
 	Key_None,
@@ -359,6 +443,9 @@ extern "C" {
 	BACON_API int Bacon_SetWindowContentScale(float contentScale);
 	
 	BACON_API int Bacon_CreateShader(int* outHandle, const char* vertexSource, const char* fragmentSource);
+	BACON_API int Bacon_LoadShader(int* outHandle, const char* vertexPath, const char* fragmentPath, int flags);
+	BACON_API int Bacon_CreateShaderFamily(int* outHandle, const char* vertexSource, const char* fragmentSource, const char** defines, int defineCount);
+	BACON_API int Bacon_GetShaderVariant(int* outShader, int family, int defineMask);
 	BACON_API int Bacon_EnumShaderUniforms(int handle, Bacon_EnumShaderUniformsCallback callback, void* arg);
 	BACON_API int Bacon_SetShaderUniform(int handle, int uniform, const void* value, int size);
 	BACON_API int Bacon_CreateSharedShaderUniform(int* outHandle, const char* name, int type, int arrayCount);
@@ -370,6 +457,12 @@ extern "C" {
 	BACON_API int Bacon_UnloadImage(int image);
 	BACON_API int Bacon_GetImageSize(int image, int* width, int* height);
 
+	// Render targets pooled by size and sampling flags.  An acquired image is valid until the end of the
+	// current frame (or until Bacon_ReleaseTransientImage), after which it may be handed out again; its
+	// contents are undefined on acquire.  The caller must still Bacon_UnloadImage its handle.
+	BACON_API int Bacon_AcquireTransientImage(int* outImage, int width, int height, int flags);
+	BACON_API int Bacon_ReleaseTransientImage(int image);
+
     BACON_API int Bacon_DebugGetTextureAtlasImage(int* outImage, int atlas);
 	
 	BACON_API int Bacon_PushTransform();
@@ -397,14 +490,38 @@ extern "C" {
 	BACON_API int Bacon_DrawLine(float x1, float y1, float x2, float y2);
 	BACON_API int Bacon_DrawRect(float x1, float y1, float x2, float y2);
 	BACON_API int Bacon_FillRect(float x1, float y1, float x2, float y2);
+	BACON_API int Bacon_DrawSprites(int image, const float* sprites, int count);
 	
-	// Fonts
+	// Fonts.  Font files are memory mapped; the built-in font is decompressed into the cache directory, if set.
+	BACON_API int Bacon_SetFontCacheDirectory(const char* path);
+	// Faces of loaded fonts are opened on demand and closed in LRU order beyond maxFaces.  Small glyph bitmaps
+	// are cached up to maxBytes.
+	BACON_API int Bacon_SetFontCacheBudget(int maxFaces, int maxBytes);
 	BACON_API int Bacon_LoadFont(int* outHandle, const char* path);
 	BACON_API int Bacon_UnloadFont(int font);
     BACON_API int Bacon_GetDefaultFont(int* outHandle);
 	BACON_API int Bacon_GetFontMetrics(int font, float size, int* outAscent, int* outDescent);
 	BACON_API int Bacon_GetGlyph(int font, float size, int character, int flags, int* outImage,
 					             int* outOffsetX, int* outOffsetY, int* outAdvance);
+	BACON_API int Bacon_GetGlyphs(int font, float size, int flags, const int* characters, int count, int* outGlyphs);
+	// Rasterizes the characters in each inclusive [first, last] pair of ranges on background threads, adding
+	// them to the glyph cache over the following frames.  Glyph cache files restore a font's cached glyphs.
+	BACON_API int Bacon_PrewarmFont(int font, float size, int flags, const int* ranges, int rangeCount);
+	BACON_API int Bacon_SaveFontCache(int font, const char* path);
+	BACON_API int Bacon_LoadFontCache(int font, const char* path);
+	
+	// Text.  width and height < 0 for an unbounded box; contentScale is the backing scale of the target
+	BACON_API int Bacon_LayoutText(int font, float size, float contentScale, int fontFlags, const char* text,
+								   float x, float y, float width, float height, int align, int verticalAlign, int overflow,
+								   float* outContentWidth, float* outContentHeight, int* outLineCount);
+	BACON_API int Bacon_DrawText(int font, float size, float contentScale, int fontFlags, const char* text,
+								 float x, float y, float width, float height, int align, int verticalAlign, int overflow);
+	// Text blocks keep the glyph quads of text laid out once, and draw all of them in one call under the current
+	// transform and color.  Glyph images are not owned by the block, and must outlive it or be replaced.
+	BACON_API int Bacon_CreateTextBlock(int* outHandle);
+	BACON_API int Bacon_DestroyTextBlock(int block);
+	BACON_API int Bacon_SetTextBlockGlyphs(int block, const int* images, const float* glyphs, int count);
+	BACON_API int Bacon_DrawTextBlock(int block);
 
 	
 	// Keyboard
@@ -424,9 +541,34 @@ extern "C" {
 	BACON_API int Bacon_GetControllerPropertyString(int controller, int property, char* outBuffer, int* inOutBufferSize);
 	
 	// Audio
+	
+	// Write mixed audio to a WAV file instead of the audio device; must be called before Bacon_Init
+	BACON_API int Bacon_SetAudioOutputFile(const char* path, int flags);
+	// Interpolation used for pitched or rate-converted voices; may be changed at any time
+	BACON_API int Bacon_SetAudioResampleQuality(int quality);
+	// Maximum number of one-shot voices (Bacon_PlaySound) playing at once; further plays steal the weakest voice
+	BACON_API int Bacon_SetAudioMaxVoices(int maxVoices);
+	// Directory in which decoded Ogg sounds are cached between runs; null or empty to disable (the default)
+	BACON_API int Bacon_SetAudioCacheDirectory(const char* path);
 	BACON_API int Bacon_LoadSound(int* outHandle, const char* path, int flags);
+	// Load a sound stored at [offset, offset + size) of a packed archive; the format must be given in flags
+	BACON_API int Bacon_LoadSoundRegion(int* outHandle, const char* path, int offset, int size, int flags);
 	BACON_API int Bacon_UnloadSound(int sound);
 	BACON_API int Bacon_PlaySound(int soundHandle);
+	BACON_API int Bacon_PlaySoundEx(int soundHandle, float gain, float pan, float pitch);
+	// Maximum one-shot voices of this sound at once (0 for no limit); further plays retrigger its weakest voice
+	BACON_API int Bacon_SetSoundMaxVoices(int sound, int maxVoices);
+	// One-shot voices of lower priority are stolen first when the global voice limit is reached
+	BACON_API int Bacon_SetSoundPriority(int sound, int priority);
+	// Bus that one-shot plays and new voices of this sound are mixed into (0 for the output)
+	BACON_API int Bacon_SetSoundBus(int sound, int bus);
+	
+	// Submix bus, mixed into parentBus (0 for the output); buses last until shutdown
+	BACON_API int Bacon_CreateAudioBus(int* outHandle, int parentBus);
+	BACON_API int Bacon_SetAudioBusGain(int bus, float gain);
+	BACON_API int Bacon_SetAudioBusFilter(int bus, int filterType, float cutoff, float q);
+	// Attenuate the bus to gain while sidechainBus is audible (0 to stop ducking)
+	BACON_API int Bacon_SetAudioBusDucking(int bus, int sidechainBus, float gain);
 	 
 	BACON_API int Bacon_CreateVoice(int* outHandle, int sound, int voiceFlags);
 	BACON_API int Bacon_DestroyVoice(int voice);
@@ -435,6 +577,7 @@ extern "C" {
 	BACON_API int Bacon_SetVoiceGain(int voice, float gain);
 	BACON_API int Bacon_SetVoicePitch(int voice, float pitch);
 	BACON_API int Bacon_SetVoicePan(int voice, float pan);
+	BACON_API int Bacon_SetVoiceBus(int voice, int bus);
 	BACON_API int Bacon_SetVoiceLoopPoints(int voice, int startSample, int endSample);
 	BACON_API int Bacon_SetVoiceCallback(int voice, Bacon_VoiceCallback callback);
 	BACON_API int Bacon_IsVoicePlaying(int voice, int* playing);
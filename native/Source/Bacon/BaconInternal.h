@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stddef.h>
+
 #define BACON_ARRAY_COUNT(x) \
     (sizeof(x) / sizeof(x[0]))
 
@@ -23,6 +25,38 @@ void Controller_Update();
 
 void Fonts_Init();
 void Fonts_Shutdown();
+// Adds glyphs rasterized by the raster workers (for Bacon_PrewarmFont) to their fonts' caches
+void Fonts_Update();
+// Fonts_GetGlyph ignores the size of Bacon_FontFlags_DistanceField glyphs and rasterizes them once
+// at Fonts_DistanceFieldSize.  Texels hold signed distance to the outline: 0.5 on the edge, and
+// 1 or 0 at Fonts_DistanceFieldSpread pixels inside or outside it.
+const float Fonts_DistanceFieldSize = BACON_DISTANCE_FIELD_SIZE;
+const int Fonts_DistanceFieldSpread = 8;
+
+// Glyph rasterized at size * contentScale; metrics are in pixels at that scale
+struct Fonts_Glyph
+{
+    int m_Image; // Zero for glyphs with no bitmap (e.g. space)
+    int m_Width;
+    int m_Height;
+    int m_OffsetX;
+    int m_OffsetY;
+    int m_Advance;
+};
+// Returns a glyph from the font's cache, rasterizing it on first use.  The glyph may move once
+// another font is loaded, so copy it to keep it; its image remains valid until the font is unloaded.
+int Fonts_GetGlyph(int font, float size, int flags, unsigned int character, const Fonts_Glyph** outGlyph);
+// Rasterizes the characters missing from the font's cache on the raster workers, if there are enough of
+// them to be worth it; otherwise leaves them to Fonts_GetGlyph
+int Fonts_PrefetchGlyphs(int font, float size, int flags, const unsigned int* characters, int count);
+// Kerning between each character and the next, in pixels at size; the last entry is zero
+int Fonts_GetKerning(int font, float size, int flags, const unsigned int* characters, int count, int* outKerning);
+
+// As Bacon_DrawText, for text already decoded to characters (from the command list)
+int Text_DrawCharacters(int font, float size, float contentScale, int fontFlags, const unsigned int* characters, int count,
+						float x, float y, float width, float height, int align, int verticalAlign, int overflow);
+// Forgets cached shaping results that reference the font's glyphs
+void Text_OnFontUnloaded(int font);
 
 struct FIBITMAP;
 void Graphics_Init();
@@ -33,6 +67,13 @@ void Graphics_BeginFrame(int width, int height);
 void Graphics_EndFrame();
 int Graphics_GetImageBitmap(int handle, FIBITMAP** bitmap);
 int Graphics_SetImageBitmap(int handle, FIBITMAP* bitmap);
+// As Bacon_CreateImage, for a single channel image (glyph coverage or distance field).  Sampled by the
+// built-in shaders as premultiplied white; custom shaders see (0, 0, 0, a) unless they use g_Texture0Alpha.
+int Graphics_CreateAlphaImage(int* outHandle, int width, int height, int flags);
+// Draws subsequent quads with the built-in distance field shader until Graphics_EndDistanceField,
+// which restores the previous shader.  smoothing is half a target pixel in distance field units.
+int Graphics_BeginDistanceField(float smoothing);
+int Graphics_EndDistanceField();
 
 void Keyboard_Init();
 void Keyboard_Shutdown();
@@ -50,6 +91,9 @@ void Platform_Shutdown();
 int Platform_Run();
 void Platform_Stop();
 void Platform_GetPerformanceTime(float& time);
+// Maps a file read-only into memory; returns nullptr on failure.  Release with Platform_UnmapFile.
+const void* Platform_MapFile(const char* path, size_t* outSize);
+void Platform_UnmapFile(const void* data, size_t size);
 
 void Window_Init();
 void Window_Shutdown();
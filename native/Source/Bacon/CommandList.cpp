@@ -204,6 +204,54 @@ int Bacon_ExecuteCommands(int* commands, int commandCount, float* data, int data
 				Bacon_SetViewport(x, y, width, height, contentScale);
 				break;
 			}
+			case Bacon_Command_DrawSprites:
+			{
+				int handle = *commands++;
+				int count = *commands++;
+				Bacon_DrawSprites(handle, data, count);
+				data += count * BACON_SPRITE_FLOAT_COUNT;
+				break;
+			}
+			case Bacon_Command_DrawText:
+			{
+				int font = *commands++;
+				int fontFlags = *commands++;
+				int align = *commands++;
+				int verticalAlign = *commands++;
+				int overflow = *commands++;
+				int count = *commands++;
+				float size = *data++;
+				float contentScale = *data++;
+				float x = *data++;
+				float y = *data++;
+				float width = *data++;
+				float height = *data++;
+				Text_DrawCharacters(font, size, contentScale, fontFlags, (const unsigned int*)commands, count,
+									x, y, width, height, align, verticalAlign, overflow);
+				commands += count;
+				break;
+			}
+			case Bacon_Command_SetTextBlockGlyphs:
+			{
+				int block = *commands++;
+				int count = *commands++;
+				Bacon_SetTextBlockGlyphs(block, commands, data, count);
+				commands += count;
+				data += count * BACON_TEXT_BLOCK_GLYPH_FLOAT_COUNT;
+				break;
+			}
+			case Bacon_Command_DrawTextBlock:
+			{
+				int block = *commands++;
+				Bacon_DrawTextBlock(block);
+				break;
+			}
+			case Bacon_Command_DestroyTextBlock:
+			{
+				int block = *commands++;
+				Bacon_DestroyTextBlock(block);
+				break;
+			}
 			default:
 				return Bacon_Error_InvalidArgument;
 		}
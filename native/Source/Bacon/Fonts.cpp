@@ -3,14 +3,24 @@
 #include "HandleArray.h"
 using namespace Bacon;
 
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
 #include <string.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_CACHE_H
 
 #include <FreeImage/FreeImage.h>
 #include <FreeImage/ZLib/zlib.h>
 
+#include <gorilla/common/gc_thread.h>
+
 #include "Resources/SourceCodePro_otf.h"
 
 using namespace std;
@@ -18,70 +28,234 @@ using namespace std;
 namespace {
 	
 	const int Dpi = 96;
+	
+	// Default limits of the font cache (see Bacon_SetFontCacheBudget).  Sizes are shared between all faces.
+	const int DefaultMaxCachedFaces = 8;
+	const int DefaultMaxCachedBytes = 1024 * 1024;
+	const int MaxCachedSizes = 32;
+	
+	// Name of the decompressed built-in font in the cache directory
+	const char* const BuiltinFontCacheName = "SourceCodePro.otf";
+	
+	// Identifies a glyph cache file written by Bacon_SaveFontCache
+	const char GlyphCacheMagic[4] = { 'B', 'G', 'C', '1' };
+	
+	// Characters per raster job, and the number of missing glyphs from which a bulk lookup
+	// (Fonts_PrefetchGlyphs) is rasterized by the workers rather than one by one on the main thread
+	const int RasterBatchSize = 32;
+	const size_t ParallelRasterMinGlyphs = 64;
+	const unsigned int MaxRasterWorkers = 8;
 
 	struct Font
 	{
-		FT_Face m_Face;
-        void* m_FaceData;
+		// The font's face is opened on demand by the cache manager, and may be closed again to keep within
+		// the cache budget; look it up (with LookupSize) for each use
+		FTC_FaceID m_FaceID;
+		FT_Long m_NumGlyphs;
+		
+		// Font file mapped into memory (or the built-in font decompressed into an allocation), over which
+		// the cache manager and the raster workers open faces
+		const void* m_FaceData;
+		size_t m_FaceDataSize;
+		bool m_FaceDataMapped;
+		
+		// Glyphs requested through Fonts_GetGlyph, keyed by GetGlyphKey
+		unordered_map<unsigned long long, Fonts_Glyph> m_Glyphs;
+	};
+	
+	struct RasterGlyph
+	{
+		unsigned long long m_Key;
+		Fonts_Glyph m_Glyph;
+		FIBITMAP* m_Bitmap;
+	};
+	
+	// Characters to rasterize on a raster worker.  Images can only be created on the main thread,
+	// so rendered bitmaps are handed back to IntegrateRasterJobs.
+	struct RasterJob
+	{
+		int m_Font;
+		const void* m_FaceData;
+		size_t m_FaceDataSize;
+		float m_Size;
+		int m_Flags;
+		vector<unsigned int> m_Characters;
+		vector<RasterGlyph> m_Glyphs;
+		bool m_Cancelled;
+		bool m_Finished;
+	};
+	
+	// Each worker has its own FreeType library and face, and keeps the face open between jobs for the same font
+	struct RasterWorker
+	{
+		gc_Thread* m_Thread;
+		gc_Event* m_Event;
+		RasterJob* m_Job;
+		int m_Font;
 	};
 	
 	struct Impl
 	{
 		FT_Library m_Library;
+		
+		// Faces, sizes, character maps and small glyph bitmaps, recycled in LRU order within the budget
+		FTC_Manager m_CacheManager;
+		FTC_CMapCache m_CMapCache;
+		FTC_SBitCache m_SBitCache;
+		
 		HandleArray<Font> m_Fonts;
         int m_DefaultFont;
+		
+		// Raster workers, started on first use.  m_RasterMutex guards the job lists, m_RasterQuit and the
+		// workers' m_Job and m_Font; each worker's m_Event wakes it, and workers signal m_RasterDoneEvent
+		// after each job and when closing a face.
+		vector<RasterWorker*> m_RasterWorkers;
+		gc_Mutex* m_RasterMutex;
+		gc_Event* m_RasterDoneEvent;
+		vector<RasterJob*> m_RasterQueue;
+		vector<RasterJob*> m_RasterFinished;
+		bool m_RasterQuit;
 	};
 	static Impl* s_Impl = nullptr;
 	
+	static string s_CacheDirectory;
+	static int s_MaxCachedFaces = DefaultMaxCachedFaces;
+	static int s_MaxCachedBytes = DefaultMaxCachedBytes;
+	
+}
+
+static FT_Error RequestFace(FTC_FaceID faceID, FT_Library library, FT_Pointer requestData, FT_Face* outFace)
+{
+	Font* font = s_Impl->m_Fonts.Get((int)(size_t)faceID);
+	if (!font)
+		return FT_Err_Invalid_Handle;
+	return FT_New_Memory_Face(library, (const FT_Byte*)font->m_FaceData, (FT_Long)font->m_FaceDataSize, 0, outFace);
+}
+
+static void CreateCacheManager()
+{
+	FTC_Manager_New(s_Impl->m_Library, s_MaxCachedFaces, MaxCachedSizes, s_MaxCachedBytes, RequestFace, nullptr, &s_Impl->m_CacheManager);
+	FTC_CMapCache_New(s_Impl->m_CacheManager, &s_Impl->m_CMapCache);
+	FTC_SBitCache_New(s_Impl->m_CacheManager, &s_Impl->m_SBitCache);
 }
 
 void Fonts_Init()
 {
 	s_Impl = new Impl;
 	FT_Init_FreeType(&s_Impl->m_Library);
+	CreateCacheManager();
 	s_Impl->m_Fonts.Reserve(16);
     s_Impl->m_DefaultFont = 0;
+	s_Impl->m_RasterMutex = nullptr;
+	s_Impl->m_RasterDoneEvent = nullptr;
+	s_Impl->m_RasterQuit = false;
 }
 
+static void StopRasterWorkers();
+
 void Fonts_Shutdown()
 {
+	StopRasterWorkers();
+	FTC_Manager_Done(s_Impl->m_CacheManager);
 	FT_Done_FreeType(s_Impl->m_Library);
 	delete s_Impl;
 }
 
-int Bacon_LoadFont(int* outHandle, const char* path)
+static void ReleaseFaceData(const void* data, size_t size, bool mapped)
 {
-	if (!outHandle || !path)
-		return Bacon_Error_InvalidArgument;
+	if (mapped)
+		Platform_UnmapFile(data, size);
+	else
+		free((void*)data);
+}
+
+// Creates a font over data, which it takes ownership of
+static int OpenFont(int* outHandle, const void* data, size_t size, bool mapped)
+{
+	int handle = s_Impl->m_Fonts.Alloc();
+	Font* font = s_Impl->m_Fonts.Get(handle);
+	font->m_FaceID = (FTC_FaceID)(size_t)handle;
+	font->m_FaceData = data;
+	font->m_FaceDataSize = size;
+	font->m_FaceDataMapped = mapped;
 	
+	// Opening the face now reports unsupported files
 	FT_Face face;
-	FT_Error error = FT_New_Face(s_Impl->m_Library, path, 0, &face);
-	if (error == FT_Err_Unknown_File_Format)
-		return Bacon_Error_UnsupportedFormat;
-	else if (error != FT_Err_Ok)
+	FT_Error error = FTC_Manager_LookupFace(s_Impl->m_CacheManager, font->m_FaceID, &face);
+	if (error != FT_Err_Ok)
 	{
-		Bacon_Log(Bacon_LogLevel_Error, "Font: Failed to load font at %s", path);
-        return Bacon_Error_IOError;
+		FTC_Manager_RemoveFaceID(s_Impl->m_CacheManager, font->m_FaceID);
+		s_Impl->m_Fonts.Free(handle);
+		ReleaseFaceData(data, size, mapped);
+		return error == FT_Err_Unknown_File_Format ? Bacon_Error_UnsupportedFormat : Bacon_Error_Unknown;
 	}
+	font->m_NumGlyphs = face->num_glyphs;
+	
+	*outHandle = handle;
+	return Bacon_Error_None;
+}
 
-	*outHandle = s_Impl->m_Fonts.Alloc();
-	Font* font = s_Impl->m_Fonts.Get(*outHandle);
-	font->m_Face = face;
-    font->m_FaceData = nullptr;
+int Bacon_SetFontCacheBudget(int maxFaces, int maxBytes)
+{
+	if (maxFaces < 1 || maxBytes < 0)
+		return Bacon_Error_InvalidArgument;
+	
+	s_MaxCachedFaces = maxFaces;
+	s_MaxCachedBytes = maxBytes;
+	
+	// The manager's limits are fixed on creation; fonts' faces are reopened on demand by the new one
+	if (s_Impl)
+	{
+		FTC_Manager_Done(s_Impl->m_CacheManager);
+		CreateCacheManager();
+	}
+	return Bacon_Error_None;
+}
 
+int Bacon_SetFontCacheDirectory(const char* path)
+{
+	s_CacheDirectory = path ? path : "";
 	return Bacon_Error_None;
 }
 
+int Bacon_LoadFont(int* outHandle, const char* path)
+{
+	if (!outHandle || !path)
+		return Bacon_Error_InvalidArgument;
+	
+	// Mapped rather than read, so only the pages of tables and glyphs in use are resident
+	size_t size;
+	const void* data = Platform_MapFile(path, &size);
+	int error = data ? OpenFont(outHandle, data, size, true) : Bacon_Error_IOError;
+	if (error && error != Bacon_Error_UnsupportedFormat)
+	{
+		Bacon_Log(Bacon_LogLevel_Error, "Font: Failed to load font at %s", path);
+		return Bacon_Error_IOError;
+	}
+	return error;
+}
+
+static void CancelRasterJobs(int font);
+
 int Bacon_UnloadFont(int handle)
 {
 	Font* font = s_Impl->m_Fonts.Get(handle);
 	if (!font)
 		return Bacon_Error_InvalidHandle;
 	
-    if (font->m_Face)
-	    FT_Done_Face(font->m_Face);
-    if (font->m_FaceData)
-        free(font->m_FaceData);
+	// Raster workers may be reading the font's data
+	CancelRasterJobs(handle);
+	
+	// Closes the face and its sizes, and flushes its cached glyph bitmaps
+	FTC_Manager_RemoveFaceID(s_Impl->m_CacheManager, font->m_FaceID);
+	ReleaseFaceData(font->m_FaceData, font->m_FaceDataSize, font->m_FaceDataMapped);
+	for (auto& entry : font->m_Glyphs)
+	{
+		if (entry.second.m_Image)
+			Bacon_UnloadImage(entry.second.m_Image);
+	}
+	font->m_Glyphs.clear();
+	Text_OnFontUnloaded(handle);
 	s_Impl->m_Fonts.Free(handle);
 	
     if (handle == s_Impl->m_DefaultFont)
@@ -90,36 +264,101 @@ int Bacon_UnloadFont(int handle)
 	return Bacon_Error_None;
 }
 
-int LoadBuiltinFont(int* outHandle, const void* compressedData, unsigned int compressedDataSize, unsigned int size)
+// Maps the decompressed built-in font from the cache directory, writing it there first if needed
+static const void* MapCachedBuiltinFont(const void* compressedData, unsigned int compressedDataSize, unsigned int size)
 {
-    *outHandle = s_Impl->m_Fonts.Alloc();
-    Font* font = s_Impl->m_Fonts.Get(*outHandle);
-    font->m_Face = nullptr;
-    font->m_FaceData = malloc(size);
-
-    uLongf uncompressedSize = size;
-    if (uncompress((Bytef*)font->m_FaceData, &uncompressedSize, (const Bytef*)compressedData, compressedDataSize) != Z_OK)
-        return Bacon_Error_Unknown;
+	string cachePath = s_CacheDirectory + "/" + BuiltinFontCacheName;
+	size_t mappedSize;
+	const void* data = Platform_MapFile(cachePath.c_str(), &mappedSize);
+	if (data && mappedSize == size)
+		return data;
+	if (data)
+		Platform_UnmapFile(data, mappedSize);
+	
+	vector<Bytef> uncompressed(size);
+	uLongf uncompressedSize = size;
+	if (uncompress(uncompressed.data(), &uncompressedSize, (const Bytef*)compressedData, compressedDataSize) != Z_OK)
+		return nullptr;
+	
+	// Written under a temporary name so a partial file is never mapped
+	string tempPath = cachePath + ".tmp";
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (!file)
+		return nullptr;
+	bool written = fwrite(uncompressed.data(), 1, size, file) == size;
+	written = fclose(file) == 0 && written;
+	
+	remove(cachePath.c_str());
+	if (!written || rename(tempPath.c_str(), cachePath.c_str()) != 0)
+	{
+		Bacon_Log(Bacon_LogLevel_Warning, "Font: Failed to write font cache %s", cachePath.c_str());
+		remove(tempPath.c_str());
+		return nullptr;
+	}
+	
+	data = Platform_MapFile(cachePath.c_str(), &mappedSize);
+	if (data && mappedSize != size)
+	{
+		Platform_UnmapFile(data, mappedSize);
+		return nullptr;
+	}
+	return data;
+}
 
-    FT_Face face;
-    FT_Error error = FT_New_Memory_Face(s_Impl->m_Library, (const FT_Byte*)font->m_FaceData, size, 0, &face);
-    if (error == FT_Err_Unknown_File_Format)
-        return Bacon_Error_UnsupportedFormat;
-    else if (error != FT_Err_Ok)
+static int LoadBuiltinFont(int* outHandle, const void* compressedData, unsigned int compressedDataSize, unsigned int size)
+{
+	// With a cache directory the font is only decompressed on first run, and is mapped thereafter
+	if (!s_CacheDirectory.empty())
+	{
+		if (const void* data = MapCachedBuiltinFont(compressedData, compressedDataSize, size))
+			return OpenFont(outHandle, data, size, true);
+	}
+	
+	void* data = malloc(size);
+	uLongf uncompressedSize = size;
+	if (uncompress((Bytef*)data, &uncompressedSize, (const Bytef*)compressedData, compressedDataSize) != Z_OK)
+	{
+		free(data);
 		return Bacon_Error_Unknown;
-
-    font->m_Face = face;
-    return Bacon_Error_None;
+	}
+	return OpenFont(outHandle, data, size, false);
 }
 
 int Bacon_GetDefaultFont(int* outHandle)
 {
+	if (!outHandle)
+		return Bacon_Error_InvalidArgument;
+	
     if (!s_Impl->m_DefaultFont)
-        LoadBuiltinFont(&s_Impl->m_DefaultFont, g_SourceCodePro_otf_Compressed, g_SourceCodePro_otf_CompressedLength, g_SourceCodePro_otf_Length);
+	{
+		if (int error = LoadBuiltinFont(&s_Impl->m_DefaultFont, g_SourceCodePro_otf_Compressed, g_SourceCodePro_otf_CompressedLength, g_SourceCodePro_otf_Length))
+		{
+			s_Impl->m_DefaultFont = 0;
+			return error;
+		}
+	}
     *outHandle = s_Impl->m_DefaultFont;
     return Bacon_Error_None;
 }
 
+static void GetScaler(Font* font, float size, FTC_ScalerRec* outScaler)
+{
+	outScaler->face_id = font->m_FaceID;
+	outScaler->width = 0;
+	outScaler->height = (FT_UInt)(size * 64);
+	outScaler->pixel = 0;
+	outScaler->x_res = Dpi;
+	outScaler->y_res = Dpi;
+}
+
+// Looks up the font's face at size, and makes it the face's active size
+static bool LookupSize(Font* font, float size, FT_Size* outSize)
+{
+	FTC_ScalerRec scaler;
+	GetScaler(font, size, &scaler);
+	return FTC_Manager_LookupSize(s_Impl->m_CacheManager, &scaler, outSize) == FT_Err_Ok;
+}
+
 int Bacon_GetFontMetrics(int handle, float size, int* outAscent, int* outDescent)
 {
 	if (!outAscent || !outDescent || size <= 0.f)
@@ -129,13 +368,295 @@ int Bacon_GetFontMetrics(int handle, float size, int* outAscent, int* outDescent
 	if (!font)
 		return Bacon_Error_InvalidHandle;
 	
-	FT_Face face = font->m_Face;
-	if (FT_Set_Char_Size(face, 0, (int)(size * 64), Dpi, Dpi))
+	FT_Size ftSize;
+	if (!LookupSize(font, size, &ftSize))
+		return Bacon_Error_InvalidFontSize;
+	
+	*outAscent = (int)(ftSize->metrics.ascender / 64);
+	*outDescent = (int)(ftSize->metrics.descender / 64);
+	
+	return Bacon_Error_None;
+}
+
+// Converts FreeType coverage into a new 8bpp alpha bitmap, or color into a 32bpp premultiplied
+// bitmap, in a single pass.  FIBITMAP rows are stored bottom-up.
+static FIBITMAP* CreateGlyphBitmap(FT_Bitmap const& source)
+{
+	int width = source.width;
+	int height = source.rows;
+	if (source.pixel_mode != FT_PIXEL_MODE_MONO &&
+		source.pixel_mode != FT_PIXEL_MODE_GRAY &&
+		source.pixel_mode != FT_PIXEL_MODE_BGRA)
+		return nullptr;
+	
+	FIBITMAP* bitmap = FreeImage_Allocate(width, height, source.pixel_mode == FT_PIXEL_MODE_BGRA ? 32 : 8);
+	if (!bitmap)
+		return nullptr;
+	
+	for (int y = 0; y < height; ++y)
+	{
+		const unsigned char* src = source.buffer + y * source.pitch;
+		unsigned char* dest = FreeImage_GetScanLine(bitmap, height - 1 - y);
+		switch (source.pixel_mode)
+		{
+			case FT_PIXEL_MODE_MONO:
+				for (int x = 0; x < width; ++x)
+					dest[x] = ((src[x >> 3] >> (7 - (x & 7))) & 1) ? 255 : 0;
+				break;
+			case FT_PIXEL_MODE_GRAY:
+				memcpy(dest, src, width);
+				break;
+			case FT_PIXEL_MODE_BGRA:
+				// Already premultiplied BGRA
+				memcpy(dest, src, width * 4);
+				break;
+		}
+	}
+	return bitmap;
+}
+
+// Nearest seed found so far by the distance transform, as an offset from the cell
+struct DistanceFieldCell
+{
+	int m_X;
+	int m_Y;
+	
+	int GetDistanceSquared() const { return m_X * m_X + m_Y * m_Y; }
+};
+
+static void CompareDistanceFieldCell(vector<DistanceFieldCell>& grid, int width, int height, int x, int y, int offsetX, int offsetY)
+{
+	int otherX = x + offsetX;
+	int otherY = y + offsetY;
+	if (otherX < 0 || otherY < 0 || otherX >= width || otherY >= height)
+		return;
+	
+	DistanceFieldCell other = grid[otherY * width + otherX];
+	other.m_X += offsetX;
+	other.m_Y += offsetY;
+	DistanceFieldCell& cell = grid[y * width + x];
+	if (other.GetDistanceSquared() < cell.GetDistanceSquared())
+		cell = other;
+}
+
+// Two-pass 8-neighbour sequential Euclidean distance transform (8SSEDT) to the nearest seed cell
+static void TransformDistanceField(vector<DistanceFieldCell>& grid, int width, int height)
+{
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			CompareDistanceFieldCell(grid, width, height, x, y, -1, 0);
+			CompareDistanceFieldCell(grid, width, height, x, y, 0, -1);
+			CompareDistanceFieldCell(grid, width, height, x, y, -1, -1);
+			CompareDistanceFieldCell(grid, width, height, x, y, 1, -1);
+		}
+		for (int x = width - 1; x >= 0; --x)
+			CompareDistanceFieldCell(grid, width, height, x, y, 1, 0);
+	}
+	
+	for (int y = height - 1; y >= 0; --y)
+	{
+		for (int x = width - 1; x >= 0; --x)
+		{
+			CompareDistanceFieldCell(grid, width, height, x, y, 1, 0);
+			CompareDistanceFieldCell(grid, width, height, x, y, 0, 1);
+			CompareDistanceFieldCell(grid, width, height, x, y, -1, 1);
+			CompareDistanceFieldCell(grid, width, height, x, y, 1, 1);
+		}
+		for (int x = 0; x < width; ++x)
+			CompareDistanceFieldCell(grid, width, height, x, y, -1, 0);
+	}
+}
+
+static bool IsGlyphPixelInside(FT_Bitmap const& source, int x, int y)
+{
+	const unsigned char* src = source.buffer + y * source.pitch;
+	switch (source.pixel_mode)
+	{
+		case FT_PIXEL_MODE_MONO:
+			return ((src[x >> 3] >> (7 - (x & 7))) & 1) != 0;
+		case FT_PIXEL_MODE_GRAY:
+			return src[x] >= 128;
+		case FT_PIXEL_MODE_BGRA:
+			return src[x * 4 + 3] >= 128;
+		default:
+			return false;
+	}
+}
+
+// Converts FreeType coverage into a new 8bpp alpha signed distance field bitmap (see
+// Fonts_DistanceFieldSize), padded by Fonts_DistanceFieldSpread on each side.
+static FIBITMAP* CreateDistanceFieldBitmap(FT_Bitmap const& source)
+{
+	const int spread = Fonts_DistanceFieldSpread;
+	const DistanceFieldCell seed = { 0, 0 };
+	const DistanceFieldCell empty = { 0x3fff, 0x3fff };
+	
+	int width = source.width + spread * 2;
+	int height = source.rows + spread * 2;
+	FIBITMAP* bitmap = FreeImage_Allocate(width, height, 8);
+	if (!bitmap)
+		return nullptr;
+	
+	// Distance from each cell to the nearest inside cell, and to the nearest outside cell
+	vector<DistanceFieldCell> toInside(width * height, empty);
+	vector<DistanceFieldCell> toOutside(width * height, seed);
+	for (int y = 0; y < (int)source.rows; ++y)
+	{
+		for (int x = 0; x < (int)source.width; ++x)
+		{
+			if (IsGlyphPixelInside(source, x, y))
+			{
+				int index = (y + spread) * width + x + spread;
+				toInside[index] = seed;
+				toOutside[index] = empty;
+			}
+		}
+	}
+	TransformDistanceField(toInside, width, height);
+	TransformDistanceField(toOutside, width, height);
+	
+	for (int y = 0; y < height; ++y)
+	{
+		unsigned char* dest = FreeImage_GetScanLine(bitmap, height - 1 - y);
+		for (int x = 0; x < width; ++x)
+		{
+			int index = y * width + x;
+			float distance = sqrtf((float)toOutside[index].GetDistanceSquared()) - sqrtf((float)toInside[index].GetDistanceSquared());
+			float value = 0.5f + distance / (2.f * spread);
+			value = value < 0.f ? 0.f : (value > 1.f ? 1.f : value);
+			dest[x] = (unsigned char)(value * 255.f + 0.5f);
+		}
+	}
+	return bitmap;
+}
+
+static FT_Int32 GetLoadFlags(int flags)
+{
+	// Distance fields are scaled to any size, so are rasterized without hinting
+	bool distanceField = (flags & Bacon_FontFlags_DistanceField) != 0;
+	FT_Int32 loadFlags = FT_LOAD_RENDER;
+	if (distanceField)
+		loadFlags |= FT_LOAD_NO_HINTING;
+	else
+		loadFlags |= FT_LOAD_COLOR;
+	if ((flags & Bacon_FontFlags_LightHinting) && !distanceField)
+		loadFlags |= FT_LOAD_TARGET_LIGHT;
+	return loadFlags;
+}
+
+// Converts a rendered glyph into a new bitmap, or null for glyphs with no bitmap (e.g. space)
+static int ConvertGlyph(FT_Bitmap const& source, int left, int top, int advance, int flags,
+						Fonts_Glyph* outGlyph, FIBITMAP** outBitmap)
+{
+	*outBitmap = nullptr;
+	outGlyph->m_Image = 0;
+	outGlyph->m_Width = 0;
+	outGlyph->m_Height = 0;
+	outGlyph->m_OffsetX = 0;
+	outGlyph->m_OffsetY = 0;
+	outGlyph->m_Advance = advance;
+	if (!source.width || !source.rows)
+		return Bacon_Error_None;
+	
+	bool distanceField = (flags & Bacon_FontFlags_DistanceField) != 0;
+	FIBITMAP* bitmap;
+	if (distanceField)
+		bitmap = CreateDistanceFieldBitmap(source);
+	else
+		bitmap = CreateGlyphBitmap(source);
+	if (!bitmap)
+		return Bacon_Error_Unknown;
+	
+	*outBitmap = bitmap;
+	outGlyph->m_Width = FreeImage_GetWidth(bitmap);
+	outGlyph->m_Height = FreeImage_GetHeight(bitmap);
+	outGlyph->m_OffsetX = left;
+	outGlyph->m_OffsetY = top;
+	if (distanceField)
+	{
+		outGlyph->m_OffsetX -= Fonts_DistanceFieldSpread;
+		outGlyph->m_OffsetY += Fonts_DistanceFieldSpread;
+	}
+	return Bacon_Error_None;
+}
+
+// Renders a character at the face's active size into a new bitmap.  Touches no shared state, so the
+// raster workers render with their own faces too.
+static int RenderGlyph(FT_Face face, int character, int flags, Fonts_Glyph* outGlyph, FIBITMAP** outBitmap)
+{
+	// On failure the slot still holds the previous character's glyph
+	*outBitmap = nullptr;
+	if (FT_Load_Char(face, character, GetLoadFlags(flags)))
+		return Bacon_Error_Unknown;
+	
+	// Hinted advances are whole pixels; unhinted (distance field) advances are rounded
+	FT_GlyphSlot slot = face->glyph;
+	return ConvertGlyph(slot->bitmap, slot->bitmap_left, slot->bitmap_top, (int)((slot->advance.x + 32) / 64), flags,
+						outGlyph, outBitmap);
+}
+
+// As RenderGlyph, with the font's cached face.  Glyphs small enough for the sbit cache are copied from it,
+// and only rendered on a miss.
+static int RenderCachedGlyph(Font* font, float size, int character, int flags, Fonts_Glyph* outGlyph, FIBITMAP** outBitmap)
+{
+	FT_Size ftSize;
+	if (!LookupSize(font, size, &ftSize))
 		return Bacon_Error_InvalidFontSize;
 	
-	*outAscent = (int)(face->size->metrics.ascender / 64);
-	*outDescent = (int)(face->size->metrics.descender / 64);
+	FTC_ScalerRec scaler;
+	GetScaler(font, size, &scaler);
+	FT_UInt glyphIndex = FTC_CMapCache_Lookup(s_Impl->m_CMapCache, font->m_FaceID, -1, character);
+	FTC_SBit sbit;
+	if (!FTC_SBitCache_LookupScaler(s_Impl->m_SBitCache, &scaler, GetLoadFlags(flags), glyphIndex, &sbit, nullptr) &&
+		(sbit->buffer || sbit->width != 255))
+	{
+		FT_Bitmap bitmap;
+		memset(&bitmap, 0, sizeof(bitmap));
+		bitmap.rows = sbit->height;
+		bitmap.width = sbit->width;
+		bitmap.pitch = sbit->pitch;
+		bitmap.buffer = sbit->buffer;
+		bitmap.num_grays = sbit->max_grays + 1;
+		bitmap.pixel_mode = sbit->format;
+		return ConvertGlyph(bitmap, sbit->left, sbit->top, sbit->xadvance, flags, outGlyph, outBitmap);
+	}
 	
+	// Too large for the sbit cache (which marks it with a width of 255 and no buffer); the lookup may have
+	// recycled the size, so look it up again
+	if (!LookupSize(font, size, &ftSize))
+		return Bacon_Error_InvalidFontSize;
+	return RenderGlyph(ftSize->face, character, flags, outGlyph, outBitmap);
+}
+
+// Creates the glyph's image, taking ownership of bitmap
+static int CreateGlyphImage(Fonts_Glyph* glyph, FIBITMAP* bitmap)
+{
+	// Coverage and distance fields are packed into single channel atlas pages; color glyphs into RGBA
+	int imageFlags = Bacon_ImageFlags_DiscardBitmap | (1 << Bacon_ImageFlags_AtlasGroupShift);
+	int error;
+	if (FreeImage_GetBPP(bitmap) == 8)
+		error = Graphics_CreateAlphaImage(&glyph->m_Image, glyph->m_Width, glyph->m_Height, imageFlags);
+	else
+		error = Bacon_CreateImage(&glyph->m_Image, glyph->m_Width, glyph->m_Height, imageFlags);
+	if (error)
+	{
+		FreeImage_Unload(bitmap);
+		glyph->m_Image = 0;
+		return Bacon_Error_Unknown;
+	}
+	Graphics_SetImageBitmap(glyph->m_Image, bitmap);
+	return Bacon_Error_None;
+}
+
+static int RasterizeGlyph(Font* font, float size, int character, int flags, Fonts_Glyph* outGlyph)
+{
+	FIBITMAP* bitmap;
+	if (int error = RenderCachedGlyph(font, size, character, flags, outGlyph, &bitmap))
+		return error;
+	if (bitmap)
+		return CreateGlyphImage(outGlyph, bitmap);
 	return Bacon_Error_None;
 }
 
@@ -149,60 +670,632 @@ int Bacon_GetGlyph(int handle, float size, int character, int flags, int* outIma
 	if (!font)
 		return Bacon_Error_InvalidHandle;
 	
-	FT_Face face = font->m_Face;
-	if (FT_Set_Char_Size(face, 0, (int)(size * 64), Dpi, Dpi))
+	// The caller owns the image, so this bypasses the font's glyph cache
+	Fonts_Glyph glyph;
+	if (int error = RasterizeGlyph(font, size, character, flags, &glyph))
+		return error;
+	
+	*outImage = glyph.m_Image;
+	*outOffsetX = glyph.m_OffsetX;
+	*outOffsetY = glyph.m_OffsetY;
+	*outAdvance = glyph.m_Advance;
+	return Bacon_Error_None;
+}
+
+// Size in 26.6 fixed point, font flags and character packed into a single key
+static unsigned long long GetGlyphKey(float size, int flags, unsigned int character)
+{
+	unsigned long long size26_6 = (unsigned int)(size * 64);
+	return (size26_6 << 32) | ((unsigned long long)(flags & 0xff) << 24) | (character & 0xffffff);
+}
+
+static int GetCachedGlyph(Font* font, float size, int flags, unsigned int character, const Fonts_Glyph** outGlyph)
+{
+	// One set of distance field glyphs serves every size
+	if (flags & Bacon_FontFlags_DistanceField)
+		size = Fonts_DistanceFieldSize;
+	
+	unsigned long long key = GetGlyphKey(size, flags, character);
+	auto it = font->m_Glyphs.find(key);
+	if (it == font->m_Glyphs.end())
+	{
+		Fonts_Glyph glyph;
+		if (int error = RasterizeGlyph(font, size, character, flags, &glyph))
+			return error;
+		it = font->m_Glyphs.insert(make_pair(key, glyph)).first;
+	}
+	
+	*outGlyph = &it->second;
+	return Bacon_Error_None;
+}
+int Fonts_GetGlyph(int handle, float size, int flags, unsigned int character, const Fonts_Glyph** outGlyph)
+{
+	Font* font = s_Impl->m_Fonts.Get(handle);
+	if (!font)
+		return Bacon_Error_InvalidHandle;
+	
+	return GetCachedGlyph(font, size, flags, character, outGlyph);
+}
+
+int Fonts_GetKerning(int handle, float size, int flags, const unsigned int* characters, int count, int* outKerning)
+{
+	Font* font = s_Impl->m_Fonts.Get(handle);
+	if (!font)
+		return Bacon_Error_InvalidHandle;
+	
+	for (int i = 0; i < count; ++i)
+		outKerning[i] = 0;
+	
+	if (count < 2)
+		return Bacon_Error_None;
+	
+	// Distance field glyphs are unhinted, so their kerning is not grid-fitted either
+	bool distanceField = (flags & Bacon_FontFlags_DistanceField) != 0;
+	if (distanceField)
+		size = Fonts_DistanceFieldSize;
+	FT_Size ftSize;
+	if (!LookupSize(font, size, &ftSize))
 		return Bacon_Error_InvalidFontSize;
+	
+	FT_Face face = ftSize->face;
+	if (!FT_HAS_KERNING(face))
+		return Bacon_Error_None;
+	
+	FT_UInt kerningMode = distanceField ? FT_KERNING_UNFITTED : FT_KERNING_DEFAULT;
+	FT_UInt left = FTC_CMapCache_Lookup(s_Impl->m_CMapCache, font->m_FaceID, -1, characters[0]);
+	for (int i = 0; i < count - 1; ++i)
+	{
+		FT_UInt right = FTC_CMapCache_Lookup(s_Impl->m_CMapCache, font->m_FaceID, -1, characters[i + 1]);
+		FT_Vector kerning;
+		if (left && right && !FT_Get_Kerning(face, left, right, kerningMode, &kerning))
+			outKerning[i] = (int)((kerning.x + 32) >> 6);
+		left = right;
+	}
+	return Bacon_Error_None;
+}
 
-	int loadFlags = FT_LOAD_RENDER | FT_LOAD_COLOR;
-	if (flags & Bacon_FontFlags_LightHinting)
-		loadFlags |= FT_LOAD_TARGET_LIGHT;
-	FT_Load_Char(face, character, loadFlags);
+int Bacon_GetGlyphs(int handle, float size, int flags, const int* characters, int count, int* outGlyphs)
+{
+	if (!characters || !outGlyphs || count < 0 || size <= 0.f)
+		return Bacon_Error_InvalidArgument;
+	
+	Font* font = s_Impl->m_Fonts.Get(handle);
+	if (!font)
+		return Bacon_Error_InvalidHandle;
+	
+	if (int error = Fonts_PrefetchGlyphs(handle, size, flags, (const unsigned int*)characters, count))
+		return error;
+	
+	for (int i = 0; i < count; ++i)
+	{
+		const Fonts_Glyph* glyph;
+		if (int error = GetCachedGlyph(font, size, flags, characters[i], &glyph))
+			return error;
+		
+		int* out = outGlyphs + i * BACON_GLYPH_INT_COUNT;
+		out[0] = glyph->m_Image;
+		out[1] = glyph->m_Width;
+		out[2] = glyph->m_Height;
+		out[3] = glyph->m_OffsetX;
+		out[4] = glyph->m_OffsetY;
+		out[5] = glyph->m_Advance;
+	}
+	return Bacon_Error_None;
+}
+
+static bool IsRasterJobCancelled(RasterJob const* job)
+{
+	gc_mutex_lock(s_Impl->m_RasterMutex);
+	bool cancelled = job->m_Cancelled || s_Impl->m_RasterQuit;
+	gc_mutex_unlock(s_Impl->m_RasterMutex);
+	return cancelled;
+}
+
+static void RunRasterJob(FT_Face face, RasterJob* job)
+{
+	if (FT_Set_Char_Size(face, 0, (FT_F26Dot6)(job->m_Size * 64), Dpi, Dpi))
+		return;
+	
+	job->m_Glyphs.reserve(job->m_Characters.size());
+	for (unsigned int character : job->m_Characters)
+	{
+		if (IsRasterJobCancelled(job))
+			break;
+		
+		RasterGlyph glyph;
+		glyph.m_Key = GetGlyphKey(job->m_Size, job->m_Flags, character);
+		if (!RenderGlyph(face, character, job->m_Flags, &glyph.m_Glyph, &glyph.m_Bitmap))
+			job->m_Glyphs.push_back(glyph);
+	}
+}
 
-	if (face->glyph->bitmap.width && face->glyph->bitmap.rows)
+static gc_int32 RasterWorkerFunc(void* context)
+{
+	RasterWorker* worker = (RasterWorker*)context;
+	FT_Library library = nullptr;
+	FT_Init_FreeType(&library);
+	
+	FT_Face face = nullptr;
+	for (;;)
 	{
-		int width = face->glyph->bitmap.width;
-		int height = face->glyph->bitmap.rows;
-		if (Bacon_CreateImage(outImage, width, height, Bacon_ImageFlags_DiscardBitmap | (1 << Bacon_ImageFlags_AtlasGroupShift)))
-			return Bacon_Error_Unknown;
+		gc_mutex_lock(s_Impl->m_RasterMutex);
+		bool quit = s_Impl->m_RasterQuit;
+		RasterJob* job = nullptr;
+		if (!quit && !s_Impl->m_RasterQueue.empty())
+		{
+			job = s_Impl->m_RasterQueue.front();
+			s_Impl->m_RasterQueue.erase(s_Impl->m_RasterQueue.begin());
+		}
+		worker->m_Job = job;
+		bool closeFace = face && (!job || job->m_Font != worker->m_Font);
+		gc_mutex_unlock(s_Impl->m_RasterMutex);
 		
-		int bpp = 0;
-		switch (face->glyph->bitmap.pixel_mode)
+		// The face reads the font's data, which is released once the font is unloaded (see CancelRasterJobs),
+		// so it is only kept open while there is more work for the font
+		if (closeFace)
 		{
-			case FT_PIXEL_MODE_MONO:
-				bpp = 1;
-				break;
-			case FT_PIXEL_MODE_GRAY:
-				bpp = 8;
-				break;
-			case FT_PIXEL_MODE_BGRA:
-				bpp = 32;
+			FT_Done_Face(face);
+			face = nullptr;
+			gc_mutex_lock(s_Impl->m_RasterMutex);
+			worker->m_Font = 0;
+			gc_mutex_unlock(s_Impl->m_RasterMutex);
+			gc_event_signal(s_Impl->m_RasterDoneEvent);
+		}
+		
+		if (quit)
+			break;
+		if (!job)
+		{
+			gc_event_wait(worker->m_Event, 0xffffffff);
+			continue;
+		}
+		
+		if (!face && library &&
+			FT_New_Memory_Face(library, (const FT_Byte*)job->m_FaceData, (FT_Long)job->m_FaceDataSize, 0, &face))
+			face = nullptr;
+		if (face)
+		{
+			gc_mutex_lock(s_Impl->m_RasterMutex);
+			worker->m_Font = job->m_Font;
+			gc_mutex_unlock(s_Impl->m_RasterMutex);
+			RunRasterJob(face, job);
+		}
+		
+		gc_mutex_lock(s_Impl->m_RasterMutex);
+		job->m_Finished = true;
+		s_Impl->m_RasterFinished.push_back(job);
+		worker->m_Job = nullptr;
+		gc_mutex_unlock(s_Impl->m_RasterMutex);
+		gc_event_signal(s_Impl->m_RasterDoneEvent);
+	}
+	
+	if (library)
+		FT_Done_FreeType(library);
+	return GC_SUCCESS;
+}
+
+static void StartRasterWorkers()
+{
+	if (!s_Impl->m_RasterWorkers.empty())
+		return;
+	
+	// Leave a core for the main thread
+	unsigned int workerCount = thread::hardware_concurrency();
+	workerCount = std::max(1u, std::min(workerCount > 1 ? workerCount - 1 : 1, MaxRasterWorkers));
+	
+	s_Impl->m_RasterMutex = gc_mutex_create();
+	s_Impl->m_RasterDoneEvent = gc_event_create();
+	s_Impl->m_RasterQuit = false;
+	for (unsigned int i = 0; i < workerCount; ++i)
+	{
+		RasterWorker* worker = new RasterWorker;
+		worker->m_Event = gc_event_create();
+		worker->m_Job = nullptr;
+		worker->m_Font = 0;
+		worker->m_Thread = gc_thread_create(RasterWorkerFunc, worker, GC_THREAD_PRIORITY_LOW, 0);
+		s_Impl->m_RasterWorkers.push_back(worker);
+		gc_thread_run(worker->m_Thread);
+	}
+}
+
+static void WakeRasterWorkers()
+{
+	for (RasterWorker* worker : s_Impl->m_RasterWorkers)
+		gc_event_signal(worker->m_Event);
+}
+
+static void DeleteRasterJob(RasterJob* job)
+{
+	for (RasterGlyph& glyph : job->m_Glyphs)
+	{
+		if (glyph.m_Bitmap)
+			FreeImage_Unload(glyph.m_Bitmap);
+	}
+	delete job;
+}
+
+static void StopRasterWorkers()
+{
+	if (s_Impl->m_RasterWorkers.empty())
+		return;
+	
+	gc_mutex_lock(s_Impl->m_RasterMutex);
+	s_Impl->m_RasterQuit = true;
+	gc_mutex_unlock(s_Impl->m_RasterMutex);
+	WakeRasterWorkers();
+	for (RasterWorker* worker : s_Impl->m_RasterWorkers)
+	{
+		gc_thread_join(worker->m_Thread);
+		gc_thread_destroy(worker->m_Thread);
+		gc_event_destroy(worker->m_Event);
+		delete worker;
+	}
+	s_Impl->m_RasterWorkers.clear();
+	
+	for (RasterJob* job : s_Impl->m_RasterQueue)
+		DeleteRasterJob(job);
+	for (RasterJob* job : s_Impl->m_RasterFinished)
+		DeleteRasterJob(job);
+	s_Impl->m_RasterQueue.clear();
+	s_Impl->m_RasterFinished.clear();
+	
+	gc_event_destroy(s_Impl->m_RasterDoneEvent);
+	gc_mutex_destroy(s_Impl->m_RasterMutex);
+}
+
+static void RemoveRasterJobs(vector<RasterJob*>& jobs, int font)
+{
+	for (size_t i = 0; i < jobs.size(); )
+	{
+		if (jobs[i]->m_Font == font)
+		{
+			DeleteRasterJob(jobs[i]);
+			jobs.erase(jobs.begin() + i);
+		}
+		else
+			++i;
+	}
+}
+
+static void CancelRasterJobs(int font)
+{
+	if (s_Impl->m_RasterWorkers.empty())
+		return;
+	
+	// Drop the font's pending jobs, then stop any running and wait for workers to close its faces
+	gc_mutex_lock(s_Impl->m_RasterMutex);
+	RemoveRasterJobs(s_Impl->m_RasterQueue, font);
+	for (;;)
+	{
+		bool busy = false;
+		for (RasterWorker* worker : s_Impl->m_RasterWorkers)
+		{
+			if (worker->m_Job && worker->m_Job->m_Font == font)
+			{
+				worker->m_Job->m_Cancelled = true;
+				busy = true;
+			}
+			if (worker->m_Font == font)
+				busy = true;
+		}
+		if (!busy)
+			break;
+		
+		gc_mutex_unlock(s_Impl->m_RasterMutex);
+		gc_event_wait(s_Impl->m_RasterDoneEvent, 0xffffffff);
+		gc_mutex_lock(s_Impl->m_RasterMutex);
+	}
+	RemoveRasterJobs(s_Impl->m_RasterFinished, font);
+	gc_mutex_unlock(s_Impl->m_RasterMutex);
+}
+
+// Splits characters into jobs of RasterBatchSize, so that they are shared between the workers
+static void CreateRasterJobs(int handle, Font* font, float size, int flags, vector<unsigned int> const& characters,
+							 vector<RasterJob*>& outJobs)
+{
+	for (size_t first = 0; first < characters.size(); first += RasterBatchSize)
+	{
+		size_t last = std::min(first + RasterBatchSize, characters.size());
+		RasterJob* job = new RasterJob;
+		job->m_Font = handle;
+		job->m_FaceData = font->m_FaceData;
+		job->m_FaceDataSize = font->m_FaceDataSize;
+		job->m_Size = size;
+		job->m_Flags = flags;
+		job->m_Characters.assign(characters.begin() + first, characters.begin() + last);
+		job->m_Cancelled = false;
+		job->m_Finished = false;
+		outJobs.push_back(job);
+	}
+}
+
+// Adds the glyphs of finished jobs to their fonts' caches
+static void IntegrateRasterJobs()
+{
+	vector<RasterJob*> finished;
+	gc_mutex_lock(s_Impl->m_RasterMutex);
+	finished.swap(s_Impl->m_RasterFinished);
+	gc_mutex_unlock(s_Impl->m_RasterMutex);
+	
+	// Images are created unatlased; the first draw from their atlas group packs all of them into
+	// atlas pages together, with one upload per page
+	for (RasterJob* job : finished)
+	{
+		Font* font = s_Impl->m_Fonts.Get(job->m_Font);
+		for (RasterGlyph& glyph : job->m_Glyphs)
+		{
+			if (!font)
 				break;
-			default:
-				return Bacon_Error_Unknown;
+			
+			// Glyphs requested while the job was running have been rasterized already
+			if (font->m_Glyphs.find(glyph.m_Key) != font->m_Glyphs.end())
+				continue;
+			
+			if (glyph.m_Bitmap)
+			{
+				FIBITMAP* bitmap = glyph.m_Bitmap;
+				glyph.m_Bitmap = nullptr;
+				if (CreateGlyphImage(&glyph.m_Glyph, bitmap))
+					continue;
+			}
+			font->m_Glyphs.insert(make_pair(glyph.m_Key, glyph.m_Glyph));
+		}
+		DeleteRasterJob(job);
+	}
+}
+
+int Bacon_PrewarmFont(int handle, float size, int flags, const int* ranges, int rangeCount)
+{
+	if (!ranges || rangeCount < 0 || size <= 0.f)
+		return Bacon_Error_InvalidArgument;
+	
+	Font* font = s_Impl->m_Fonts.Get(handle);
+	if (!font)
+		return Bacon_Error_InvalidHandle;
+	
+	if (flags & Bacon_FontFlags_DistanceField)
+		size = Fonts_DistanceFieldSize;
+	
+	vector<unsigned int> characters;
+	for (int i = 0; i < rangeCount; ++i)
+	{
+		int first = ranges[i * 2];
+		int last = ranges[i * 2 + 1];
+		if (first < 0 || last < first || last > 0x10ffff)
+			return Bacon_Error_InvalidArgument;
+		
+		// Skip characters already in the cache
+		for (int character = first; character <= last; ++character)
+		{
+			if (font->m_Glyphs.find(GetGlyphKey(size, flags, character)) == font->m_Glyphs.end())
+				characters.push_back(character);
 		}
+	}
+	if (characters.empty())
+		return Bacon_Error_None;
+	
+	vector<RasterJob*> jobs;
+	CreateRasterJobs(handle, font, size, flags, characters, jobs);
+	StartRasterWorkers();
+	gc_mutex_lock(s_Impl->m_RasterMutex);
+	s_Impl->m_RasterQueue.insert(s_Impl->m_RasterQueue.end(), jobs.begin(), jobs.end());
+	gc_mutex_unlock(s_Impl->m_RasterMutex);
+	WakeRasterWorkers();
+	return Bacon_Error_None;
+}
+
+int Fonts_PrefetchGlyphs(int handle, float size, int flags, const unsigned int* characters, int count)
+{
+	Font* font = s_Impl->m_Fonts.Get(handle);
+	if (!font)
+		return Bacon_Error_InvalidHandle;
+	
+	if (flags & Bacon_FontFlags_DistanceField)
+		size = Fonts_DistanceFieldSize;
+	
+	vector<unsigned int> missing;
+	for (int i = 0; i < count; ++i)
+	{
+		if (font->m_Glyphs.find(GetGlyphKey(size, flags, characters[i])) == font->m_Glyphs.end())
+			missing.push_back(characters[i]);
+	}
+	if (missing.size() < ParallelRasterMinGlyphs)
+		return Bacon_Error_None;
+	
+	sort(missing.begin(), missing.end());
+	missing.erase(unique(missing.begin(), missing.end()), missing.end());
+	if (missing.size() < ParallelRasterMinGlyphs)
+		return Bacon_Error_None;
+	
+	// Queued ahead of prewarming, as the caller waits for them
+	vector<RasterJob*> jobs;
+	CreateRasterJobs(handle, font, size, flags, missing, jobs);
+	StartRasterWorkers();
+	gc_mutex_lock(s_Impl->m_RasterMutex);
+	s_Impl->m_RasterQueue.insert(s_Impl->m_RasterQueue.begin(), jobs.begin(), jobs.end());
+	gc_mutex_unlock(s_Impl->m_RasterMutex);
+	WakeRasterWorkers();
+	
+	// Jobs are only deleted on the main thread, so remain valid while waiting
+	gc_mutex_lock(s_Impl->m_RasterMutex);
+	for (RasterJob* job : jobs)
+	{
+		while (!job->m_Finished)
+		{
+			gc_mutex_unlock(s_Impl->m_RasterMutex);
+			gc_event_wait(s_Impl->m_RasterDoneEvent, 0xffffffff);
+			gc_mutex_lock(s_Impl->m_RasterMutex);
+		}
+	}
+	gc_mutex_unlock(s_Impl->m_RasterMutex);
+	
+	IntegrateRasterJobs();
+	return Bacon_Error_None;
+}
+
+void Fonts_Update()
+{
+	if (!s_Impl->m_RasterWorkers.empty())
+		IntegrateRasterJobs();
+}
+
+// Glyph cache files hold, after GlyphCacheMagic, the face's glyph count and the number of glyphs, each glyph's key, metrics and
+// bitmap (bits per pixel then rows top-down).  Glyph images are discarded once atlased, so saving renders
+// the cached glyphs again.
+static bool WriteInt(FILE* file, int value)
+{
+	return fwrite(&value, sizeof(value), 1, file) == 1;
+}
+
+static bool ReadInt(FILE* file, int* outValue)
+{
+	return fread(outValue, sizeof(*outValue), 1, file) == 1;
+}
+
+static bool WriteCachedGlyph(FILE* file, Font* font, unsigned long long key, Fonts_Glyph const& cachedGlyph)
+{
+	float size = (key >> 32) / 64.f;
+	int flags = (int)((key >> 24) & 0xff);
+	int character = (int)(key & 0xffffff);
+	
+	Fonts_Glyph glyph = cachedGlyph;
+	FIBITMAP* bitmap = nullptr;
+	if (glyph.m_Image)
+	{
+		if (RenderCachedGlyph(font, size, character, flags, &glyph, &bitmap))
+			return false;
+	}
+	
+	int bpp = bitmap ? FreeImage_GetBPP(bitmap) : 0;
+	bool success = fwrite(&key, sizeof(key), 1, file) == 1 &&
+		WriteInt(file, glyph.m_Width) &&
+		WriteInt(file, glyph.m_Height) &&
+		WriteInt(file, glyph.m_OffsetX) &&
+		WriteInt(file, glyph.m_OffsetY) &&
+		WriteInt(file, glyph.m_Advance) &&
+		WriteInt(file, bpp);
+	
+	if (bitmap)
+	{
+		int rowSize = glyph.m_Width * bpp / 8;
+		for (int y = 0; y < glyph.m_Height && success; ++y)
+			success = fwrite(FreeImage_GetScanLine(bitmap, glyph.m_Height - 1 - y), 1, rowSize, file) == (size_t)rowSize;
+		FreeImage_Unload(bitmap);
+	}
+	return success;
+}
+
+int Bacon_SaveFontCache(int handle, const char* path)
+{
+	if (!path)
+		return Bacon_Error_InvalidArgument;
+	
+	Font* font = s_Impl->m_Fonts.Get(handle);
+	if (!font)
+		return Bacon_Error_InvalidHandle;
+	
+	FILE* file = fopen(path, "wb");
+	if (!file)
+		return Bacon_Error_IOError;
+	
+	bool success = fwrite(GlyphCacheMagic, sizeof(GlyphCacheMagic), 1, file) == 1 &&
+		WriteInt(file, (int)font->m_NumGlyphs) &&
+		WriteInt(file, (int)font->m_Glyphs.size());
+	for (auto it = font->m_Glyphs.begin(); it != font->m_Glyphs.end() && success; ++it)
+		success = WriteCachedGlyph(file, font, it->first, it->second);
+	
+	if (fclose(file) || !success)
+	{
+		Bacon_Log(Bacon_LogLevel_Error, "Font: Failed to write glyph cache to %s", path);
+		return Bacon_Error_IOError;
+	}
+	return Bacon_Error_None;
+}
+
+static bool ReadCachedGlyph(FILE* file, Font* font)
+{
+	unsigned long long key;
+	Fonts_Glyph glyph;
+	int bpp;
+	if (fread(&key, sizeof(key), 1, file) != 1 ||
+		!ReadInt(file, &glyph.m_Width) ||
+		!ReadInt(file, &glyph.m_Height) ||
+		!ReadInt(file, &glyph.m_OffsetX) ||
+		!ReadInt(file, &glyph.m_OffsetY) ||
+		!ReadInt(file, &glyph.m_Advance) ||
+		!ReadInt(file, &bpp))
+		return false;
+	
+	glyph.m_Image = 0;
+	FIBITMAP* bitmap = nullptr;
+	if (bpp)
+	{
+		if ((bpp != 8 && bpp != 32) || glyph.m_Width <= 0 || glyph.m_Height <= 0)
+			return false;
 		
-		FIBITMAP* bmp = FreeImage_ConvertFromRawBits(face->glyph->bitmap.buffer,
-													 width, height, face->glyph->bitmap.pitch, bpp, 0, 0, 0, TRUE);
-		if (bpp == 1)
-		{
-			RGBQUAD *palette = FreeImage_GetPalette(bmp);
-			memset(&palette[0], 0, sizeof(RGBQUAD));
-			memset(&palette[1], 255, sizeof(RGBQUAD));
-		}
-		FIBITMAP* bmp32 = FreeImage_ConvertTo32Bits(bmp);
-		FreeImage_SetChannel(bmp32, bmp, FICC_ALPHA);
-		FreeImage_Unload(bmp);
-		Graphics_SetImageBitmap(*outImage, bmp32);
+		bitmap = FreeImage_Allocate(glyph.m_Width, glyph.m_Height, bpp);
+		if (!bitmap)
+			return false;
 		
-		*outOffsetX = (float)face->glyph->bitmap_left;
-		*outOffsetY = (float)face->glyph->bitmap_top;
+		int rowSize = glyph.m_Width * bpp / 8;
+		for (int y = 0; y < glyph.m_Height; ++y)
+		{
+			if (fread(FreeImage_GetScanLine(bitmap, glyph.m_Height - 1 - y), 1, rowSize, file) != (size_t)rowSize)
+			{
+				FreeImage_Unload(bitmap);
+				return false;
+			}
+		}
 	}
-	else
+	
+	// Glyphs already cached are kept
+	if (font->m_Glyphs.find(key) != font->m_Glyphs.end())
 	{
-		*outImage = 0;
+		if (bitmap)
+			FreeImage_Unload(bitmap);
+		return true;
 	}
 	
-	*outAdvance = (int)(face->glyph->advance.x / 64);
+	if (bitmap && CreateGlyphImage(&glyph, bitmap))
+		return false;
+	font->m_Glyphs.insert(make_pair(key, glyph));
+	return true;
+}
+
+int Bacon_LoadFontCache(int handle, const char* path)
+{
+	if (!path)
+		return Bacon_Error_InvalidArgument;
 	
+	Font* font = s_Impl->m_Fonts.Get(handle);
+	if (!font)
+		return Bacon_Error_InvalidHandle;
+	
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return Bacon_Error_IOError;
+	
+	// The face's glyph count guards against loading another font's cache
+	char magic[sizeof(GlyphCacheMagic)];
+	int faceGlyphCount;
+	int count;
+	if (fread(magic, sizeof(magic), 1, file) != 1 || memcmp(magic, GlyphCacheMagic, sizeof(magic)) ||
+		!ReadInt(file, &faceGlyphCount) || faceGlyphCount != font->m_NumGlyphs ||
+		!ReadInt(file, &count) || count < 0)
+	{
+		fclose(file);
+		return Bacon_Error_UnsupportedFormat;
+	}
+	
+	bool success = true;
+	for (int i = 0; i < count && success; ++i)
+		success = ReadCachedGlyph(file, font);
+	fclose(file);
+	
+	if (!success)
+	{
+		Bacon_Log(Bacon_LogLevel_Error, "Font: Failed to read glyph cache from %s", path);
+		return Bacon_Error_IOError;
+	}
 	return Bacon_Error_None;
-}
\ No newline at end of file
+}
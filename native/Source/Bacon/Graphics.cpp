@@ -23,8 +23,13 @@
 using namespace Bacon;
 
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <ctime>
 #include <vector>
 #include <string>
+#include <unordered_map>
 using namespace std;
 
 using vmml::vec2f;
@@ -38,6 +43,11 @@ namespace {
     const char* const VertexAttribPosition = "a_Position";
     const char* const VertexAttribTexCoord0 = "a_TexCoord0";
     const char* const VertexAttribColor = "a_Color";
+	const char* const VertexAttribCorner = "a_Corner";
+	const char* const VertexAttribInstanceRect = "a_InstanceRect";
+	const char* const VertexAttribInstanceTexCoords = "a_InstanceTexCoords";
+	const char* const VertexAttribInstanceColor = "a_InstanceColor";
+	const char* const VertexAttribInstanceRotation = "a_InstanceRotation";
 
     const char* const UniformProjection = "g_Projection";
     const char* const UniformTexture0 = "g_Texture0";
@@ -45,6 +55,11 @@ namespace {
 	const int BoundVertexAttribPosition = 0;
 	const int BoundVertexAttribTexCoord0 = 1;
 	const int BoundVertexAttribColor = 2;
+	const int BoundVertexAttribCorner = 3;
+	const int BoundVertexAttribInstanceRect = 4;
+	const int BoundVertexAttribInstanceTexCoords = 5;
+	const int BoundVertexAttribInstanceColor = 6;
+	const int BoundVertexAttribInstanceRotation = 7;
 
 	const int TextureAtlasMargin = 2;
 	const int TextureAtlasMinSize = 128;
@@ -52,12 +67,26 @@ namespace {
 
     const int MaxVertexCount = 4096;
     const int MaxIndexCount = 8192;
+	const int MaxSpriteInstanceCount = 4096;
+	
+	// Number of frames a pooled transient image may go unused before its texture is released
+	const int TransientImageEvictFrames = 60;
+
+	// Seconds between checks for modified shader source files
+	const float ShaderReloadInterval = 0.5f;
 
 	enum Bacon_ImageFlags_Internal
 	{
 		// Image.m_Texture actually refers to another image.  Used for image regions of images
 		// that have not had their texture realized yet.
 		Bacon_ImageFlags_Internal_TextureIsImage = 1 << 16,
+		
+		// Single channel texture (glyph coverage), a quarter the size of RGBA; see Graphics_CreateAlphaImage.
+		// Not color-renderable, so cannot be a frame buffer.
+		Bacon_ImageFlags_Internal_FormatAlpha = 1 << 17,
+		
+		// Flags pertinent to selecting a compatible texture atlas, including internal ones
+		Bacon_ImageFlags_Internal_AtlasFlagsMask = Bacon_ImageFlags_AtlasFlagsMask | Bacon_ImageFlags_Internal_FormatAlpha,
 	};
 
 	struct Vertex
@@ -73,6 +102,16 @@ namespace {
 		vec4f m_Color;
 	};
 
+	// Per-sprite record uploaded for the instanced sprite path; the quad is expanded in the
+	// sprite vertex shader.
+	struct SpriteInstance
+	{
+		vec4f m_Rect;			// center x, y, width, height
+		vec4f m_TexCoords;		// texture coordinates of upper-left and lower-right corners
+		vec4f m_Color;
+		float m_Rotation;
+	};
+
 	struct UVScaleBias
 	{
 		UVScaleBias()
@@ -107,6 +146,8 @@ namespace {
 		: m_RefCount(0)
         , m_Flags(0)
         , m_Size(0)
+		, m_TextureId(0)
+		, m_FrameBuffer(0)
 		{ }
 
 		int m_RefCount;
@@ -157,6 +198,17 @@ namespace {
 		UVScaleBias m_UVScaleBias;
 	};
 	
+	// Render target owned by the transient image pool; m_Image holds the pool's reference
+	struct TransientImage
+	{
+		int m_Image;
+		int m_Width;
+		int m_Height;
+		int m_Flags;
+		bool m_InUse;
+		int m_LastUsedFrame;
+	};
+	
 	struct ShaderUniform
 	{
 		ShaderUniform()
@@ -210,6 +262,14 @@ namespace {
 		string m_VertexSource;
 		string m_FragmentSource;
 
+		// For shaders created with Bacon_LoadShader, the source paths and their modification
+		// times when last loaded; used for hot-reloading
+		int m_Flags;
+		string m_VertexPath;
+		string m_FragmentPath;
+		time_t m_VertexModifiedTime;
+		time_t m_FragmentModifiedTime;
+
 		vector<ShaderUniform> m_Uniforms;
 		vector<int> m_TextureUnits;
 
@@ -219,16 +279,64 @@ namespace {
 		bool m_NonSharedValuesDirty;
 		bool m_HasError;
 	};
+
+	// Set of shaders compiled from the same source with different combinations of #define
+	// keys.  Variants are created on first use and cached by the bitmask of enabled keys.
+	const int MaxShaderFamilyDefines = 32;
+
+	struct ShaderFamily
+	{
+		string m_VertexSource;
+		string m_FragmentSource;
+		vector<string> m_Defines;
+		unordered_map<int, int> m_Variants;
+	};
+
+	// Shadow copy of the GL state touched by the renderer.  All state changes go through the
+	// SetGL* functions, which skip the GL call if the shadow value already matches.
+	const GLuint InvalidGLName = ~0u;
+	const int MaxTextureUnits = 16;
+
+	struct GLState
+	{
+		GLuint m_Program;
+		int m_BlendEnabled;
+		GLenum m_BlendSrc;
+		GLenum m_BlendDest;
+		GLint m_Viewport[4];
+		GLint m_Scissor[4];
+		GLuint m_ActiveTexture;
+		GLuint m_Textures[MaxTextureUnits];
+		GLuint m_FrameBuffer;
+		GLuint m_ArrayBuffer;
+		GLuint m_ElementArrayBuffer;
+	};
 		
 	struct Impl
 	{
         GLuint m_VBO;
         GLuint m_IBO;
 		
+		// Instanced sprite path; only used if m_SupportsInstancing
+		bool m_SupportsInstancing;
+		GLuint m_SpriteCornerVBO;
+		GLuint m_SpriteInstanceVBO;
+		int m_SpriteShader;
+		int m_SpriteTransformUniform;
+		int m_SpriteColorUniform;
+		int m_SpriteZUniform;
+		vector<SpriteInstance> m_SpriteInstances;
+		
+		// Built-in shader for distance field glyphs; see Graphics_BeginDistanceField
+		int m_DistanceFieldShader;
+		int m_DistanceFieldSmoothingUniform;
+		int m_DistanceFieldPreviousShader;
+		
 		int m_FrameBufferWidth;
 		int m_FrameBufferHeight;
 		
 		HandleArray<Shader> m_Shaders;
+		HandleArray<ShaderFamily> m_ShaderFamilies;
 		int m_DefaultShader;
 
 		HandleArray<Texture> m_Textures;
@@ -238,6 +346,8 @@ namespace {
         int m_BlankImageAlternative;
 		vector<GLuint> m_PendingDeleteTextures;
 		vector<GLuint> m_PendingDeleteFrameBuffers;
+		vector<TransientImage> m_TransientImages;
+		int m_FrameIndex;
 		
 		vector<Vertex> m_Vertices;
 		vector<unsigned short> m_Indices;
@@ -248,14 +358,22 @@ namespace {
 		int m_CurrentShader;
 		int m_CurrentFrameBuffer;
         int m_CurrentFrameBufferTexture;
-		int m_CurrentTextureUnits[16];
+		int m_CurrentBlendSrc;
+		int m_CurrentBlendDest;
+		
+		GLState m_GLState;
 		
 		int m_SharedUniformsVersion;
 		vector<ShaderUniform> m_SharedUniforms;
 		
+		int m_HotReloadShaderCount;
+		float m_LastShaderReloadCheckTime;
+		
 		// Built-in shared uniforms
 		int m_ProjectionUniform;
 		int m_Texture0Uniform;
+		// 1 if the texture bound to g_Texture0 is single channel (Bacon_ImageFlags_Internal_FormatAlpha), else 0
+		int m_Texture0AlphaUniform;
 		
 		vector<mat4f> m_TransformStack;
 		vector<vec4f> m_ColorStack;
@@ -267,6 +385,11 @@ namespace {
         int m_DebugCounter_FrameBufferBinds;
         int m_DebugCounter_DrawCalls;
         int m_DebugCounter_Primitives;
+        int m_DebugCounter_GLStateIssued;
+        int m_DebugCounter_GLStateFiltered;
+        int m_DebugCounter_TransientImages;
+        int m_DebugCounter_TransientAcquires;
+        int m_DebugCounter_TransientAliased;
 	};
 	static Impl* s_Impl = nullptr;
 	
@@ -280,6 +403,8 @@ namespace {
 		return Bacon_Error_NotRendering;
 
 static int CreateSharedUniform(ShaderUniform const& uniform);
+static void UpdateShaderHotReload();
+static void RecycleTransientImages();
 
 static void FreeImageErrorHandler(FREE_IMAGE_FORMAT format, const char* message)
 {
@@ -289,11 +414,171 @@ static void FreeImageErrorHandler(FREE_IMAGE_FORMAT format, const char* message)
 	Bacon_Log(Bacon_LogLevel_Error, "%s: %s", formatString, message);
 }
 
+// GL state cache
+
+static void ResetGLState()
+{
+	GLState& state = s_Impl->m_GLState;
+	state.m_Program = InvalidGLName;
+	state.m_BlendEnabled = -1;
+	state.m_BlendSrc = InvalidGLName;
+	state.m_BlendDest = InvalidGLName;
+	for (int i = 0; i < 4; ++i)
+	{
+		state.m_Viewport[i] = -1;
+		state.m_Scissor[i] = -1;
+	}
+	state.m_ActiveTexture = InvalidGLName;
+	for (int i = 0; i < MaxTextureUnits; ++i)
+		state.m_Textures[i] = InvalidGLName;
+	state.m_FrameBuffer = InvalidGLName;
+	state.m_ArrayBuffer = InvalidGLName;
+	state.m_ElementArrayBuffer = InvalidGLName;
+	
+	// Bacon_SetBlending filters on these, so they are forgotten along with the GL blend state
+	s_Impl->m_CurrentBlendSrc = -1;
+	s_Impl->m_CurrentBlendDest = -1;
+}
+
+// Returns true if the state change is redundant and should be skipped, and records the outcome
+// in the debug counters.
+static bool FilterGLState(bool redundant)
+{
+	DebugOverlay_AddCounter(redundant ? s_Impl->m_DebugCounter_GLStateFiltered : s_Impl->m_DebugCounter_GLStateIssued, 1);
+	return redundant;
+}
+
+static void SetGLProgram(GLuint program)
+{
+	if (FilterGLState(s_Impl->m_GLState.m_Program == program))
+		return;
+	s_Impl->m_GLState.m_Program = program;
+	glUseProgram(program);
+}
+
+static void SetGLBlending(bool enabled, GLenum src, GLenum dest)
+{
+	GLState& state = s_Impl->m_GLState;
+	if (!FilterGLState(state.m_BlendEnabled == (int)enabled))
+	{
+		state.m_BlendEnabled = (int)enabled;
+		if (enabled)
+			glEnable(GL_BLEND);
+		else
+			glDisable(GL_BLEND);
+	}
+	
+	if (!FilterGLState(state.m_BlendSrc == src && state.m_BlendDest == dest))
+	{
+		state.m_BlendSrc = src;
+		state.m_BlendDest = dest;
+		glBlendFunc(src, dest);
+	}
+}
+
+static bool IsGLRectEqual(const GLint* a, GLint x, GLint y, GLint width, GLint height)
+{
+	return a[0] == x && a[1] == y && a[2] == width && a[3] == height;
+}
+
+static void SetGLViewport(GLint x, GLint y, GLint width, GLint height)
+{
+	GLint* viewport = s_Impl->m_GLState.m_Viewport;
+	if (FilterGLState(IsGLRectEqual(viewport, x, y, width, height)))
+		return;
+	viewport[0] = x;
+	viewport[1] = y;
+	viewport[2] = width;
+	viewport[3] = height;
+	glViewport(x, y, width, height);
+}
+
+static void SetGLScissor(GLint x, GLint y, GLint width, GLint height)
+{
+	GLint* scissor = s_Impl->m_GLState.m_Scissor;
+	if (FilterGLState(IsGLRectEqual(scissor, x, y, width, height)))
+		return;
+	scissor[0] = x;
+	scissor[1] = y;
+	scissor[2] = width;
+	scissor[3] = height;
+	glScissor(x, y, width, height);
+}
+
+static void SetGLActiveTexture(GLuint unit)
+{
+	if (FilterGLState(s_Impl->m_GLState.m_ActiveTexture == unit))
+		return;
+	s_Impl->m_GLState.m_ActiveTexture = unit;
+	glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+static void SetGLTexture(GLuint unit, GLuint texture)
+{
+	assert(unit < (GLuint)MaxTextureUnits);
+	
+	// Callers go on to modify the texture bound to the unit (e.g. UpdateTexture), so the unit is made
+	// active even when the binding itself is redundant
+	SetGLActiveTexture(unit);
+	if (FilterGLState(s_Impl->m_GLState.m_Textures[unit] == texture))
+		return;
+	s_Impl->m_GLState.m_Textures[unit] = texture;
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+static void SetGLFrameBuffer(GLuint frameBuffer)
+{
+	if (FilterGLState(s_Impl->m_GLState.m_FrameBuffer == frameBuffer))
+		return;
+	s_Impl->m_GLState.m_FrameBuffer = frameBuffer;
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+}
+
+static void SetGLBuffer(GLenum target, GLuint buffer)
+{
+	GLuint& current = (target == GL_ARRAY_BUFFER) ? s_Impl->m_GLState.m_ArrayBuffer : s_Impl->m_GLState.m_ElementArrayBuffer;
+	if (FilterGLState(current == buffer))
+		return;
+	current = buffer;
+	glBindBuffer(target, buffer);
+}
+
+// Deleting a bound object reverts the binding to zero; keep the shadow state in sync
+static void ForgetGLTextures(const vector<GLuint>& textures)
+{
+	GLState& state = s_Impl->m_GLState;
+	for (GLuint texture : textures)
+	{
+		for (int i = 0; i < MaxTextureUnits; ++i)
+		{
+			if (state.m_Textures[i] == texture)
+				state.m_Textures[i] = 0;
+		}
+	}
+}
+
+static void ForgetGLFrameBuffers(const vector<GLuint>& frameBuffers)
+{
+	GLState& state = s_Impl->m_GLState;
+	for (GLuint frameBuffer : frameBuffers)
+	{
+		if (state.m_FrameBuffer == frameBuffer)
+			state.m_FrameBuffer = 0;
+	}
+}
+
 void Graphics_Init()
 {
 	s_Impl = new Impl;
     s_Impl->m_VBO = 0;
     s_Impl->m_IBO = 0;
+	s_Impl->m_SupportsInstancing = false;
+	s_Impl->m_SpriteCornerVBO = 0;
+	s_Impl->m_SpriteInstanceVBO = 0;
+	s_Impl->m_SpriteShader = 0;
+	s_Impl->m_DistanceFieldShader = 0;
+	s_Impl->m_DistanceFieldSmoothingUniform = -1;
+	s_Impl->m_DistanceFieldPreviousShader = 0;
 	s_Impl->m_Images.Reserve(256);
 	s_Impl->m_TextureAtlases.Reserve(32);
 	s_Impl->m_Textures.Reserve(256);
@@ -302,15 +587,17 @@ void Graphics_Init()
 	s_Impl->m_Indices.reserve(MaxIndexCount);
 	s_Impl->m_IsInFrame = false;
 	s_Impl->m_CurrentZ = 0.f;
-	for (int i = 0; i < BACON_ARRAY_COUNT(s_Impl->m_CurrentTextureUnits); ++i)
-		s_Impl->m_CurrentTextureUnits[i] = -1;
+	s_Impl->m_FrameIndex = 0;
 	s_Impl->m_CurrentFrameBuffer = -1;
     s_Impl->m_CurrentFrameBufferTexture = -1;
 	s_Impl->m_CurrentShader = -1;
 	s_Impl->m_CurrentMode = GL_TRIANGLES;
+	ResetGLState();
 	s_Impl->m_ColorStack.push_back(vec4f::ONE);
 	s_Impl->m_TransformStack.push_back(mat4f::IDENTITY);
 	s_Impl->m_SharedUniformsVersion = 0;
+	s_Impl->m_HotReloadShaderCount = 0;
+	s_Impl->m_LastShaderReloadCheckTime = 0.f;
 
     s_Impl->m_DebugCounter_TextureMemory = DebugOverlay_CreateCounter("Texture Memory");
     s_Impl->m_DebugCounter_Images = DebugOverlay_CreateCounter("Images");
@@ -319,6 +606,11 @@ void Graphics_Init()
     s_Impl->m_DebugCounter_FrameBufferBinds = DebugOverlay_CreateCounter("Targets/Frame");
     s_Impl->m_DebugCounter_DrawCalls = DebugOverlay_CreateCounter("Draws/Frame");
     s_Impl->m_DebugCounter_Primitives = DebugOverlay_CreateCounter("Primitives/Frame");
+    s_Impl->m_DebugCounter_GLStateIssued = DebugOverlay_CreateCounter("GL State/Frame");
+    s_Impl->m_DebugCounter_GLStateFiltered = DebugOverlay_CreateCounter("GL Filtered/Frame");
+    s_Impl->m_DebugCounter_TransientImages = DebugOverlay_CreateCounter("Transient Targets");
+    s_Impl->m_DebugCounter_TransientAcquires = DebugOverlay_CreateCounter("Transient Acquires/Frame");
+    s_Impl->m_DebugCounter_TransientAliased = DebugOverlay_CreateCounter("Transient Aliased/Frame");
 	
 	// Init FreeImage error reporting
 	FreeImage_SetOutputMessage(FreeImageErrorHandler);
@@ -352,6 +644,7 @@ void Graphics_Init()
 	// Built-in shared uniforms
 	s_Impl->m_ProjectionUniform = CreateSharedUniform(ShaderUniform("g_Projection", SH_FLOAT_MAT4, 1));
 	s_Impl->m_Texture0Uniform = CreateSharedUniform(ShaderUniform("g_Texture0", SH_SAMPLER_2D, 1));
+	s_Impl->m_Texture0AlphaUniform = CreateSharedUniform(ShaderUniform("g_Texture0Alpha", SH_FLOAT, 1));
 }
 
 void Graphics_Shutdown()
@@ -366,6 +659,131 @@ void Graphics_Shutdown()
 	delete s_Impl;
 }
 
+static void VertexAttribDivisor(GLuint index, GLuint divisor)
+{
+#if BACON_PLATFORM_ANGLE
+	glVertexAttribDivisorANGLE(index, divisor);
+#else
+	glVertexAttribDivisor(index, divisor);
+#endif
+}
+
+static void DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount)
+{
+#if BACON_PLATFORM_ANGLE
+	glDrawArraysInstancedANGLE(mode, first, count, instanceCount);
+#else
+	glDrawArraysInstanced(mode, first, count, instanceCount);
+#endif
+}
+
+static bool IsInstancingSupported()
+{
+#if BACON_PLATFORM_ANGLE
+	const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+	return extensions && strstr(extensions, "GL_ANGLE_instanced_arrays");
+#else
+	// Vertex attribute divisors are core in OpenGL 3.3
+	int major = 0;
+	int minor = 0;
+	const char* version = (const char*)glGetString(GL_VERSION);
+	if (!version || sscanf(version, "%d.%d", &major, &minor) != 2)
+		return false;
+	return major > 3 || (major == 3 && minor >= 3);
+#endif
+}
+
+static int FindShaderUniform(int shaderHandle, const char* name)
+{
+	Shader* shader = s_Impl->m_Shaders.Get(shaderHandle);
+	for (size_t i = 0; i < shader->m_Uniforms.size(); ++i)
+	{
+		if (shader->m_Uniforms[i].m_Name == name)
+			return (int)i;
+	}
+	return -1;
+}
+
+static void InitSpritesGL()
+{
+	s_Impl->m_SupportsInstancing = IsInstancingSupported();
+	Bacon_Log(Bacon_LogLevel_Info, "Instanced sprites: %s", s_Impl->m_SupportsInstancing ? "enabled" : "not supported");
+	if (!s_Impl->m_SupportsInstancing)
+		return;
+	
+	// Unit quad, drawn as a triangle strip
+	const float corners[] = {
+		0.f, 0.f,
+		0.f, 1.f,
+		1.f, 0.f,
+		1.f, 1.f
+	};
+	glGenBuffers(1, &s_Impl->m_SpriteCornerVBO);
+	SetGLBuffer(GL_ARRAY_BUFFER, s_Impl->m_SpriteCornerVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+	glVertexAttribPointer(BoundVertexAttribCorner, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, 0);
+	
+	glGenBuffers(1, &s_Impl->m_SpriteInstanceVBO);
+	SetGLBuffer(GL_ARRAY_BUFFER, s_Impl->m_SpriteInstanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(SpriteInstance) * MaxSpriteInstanceCount, nullptr, GL_DYNAMIC_DRAW);
+	glVertexAttribPointer(BoundVertexAttribInstanceRect, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, m_Rect));
+	glVertexAttribPointer(BoundVertexAttribInstanceTexCoords, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, m_TexCoords));
+	glVertexAttribPointer(BoundVertexAttribInstanceColor, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, m_Color));
+	glVertexAttribPointer(BoundVertexAttribInstanceRotation, 1, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, m_Rotation));
+	VertexAttribDivisor(BoundVertexAttribInstanceRect, 1);
+	VertexAttribDivisor(BoundVertexAttribInstanceTexCoords, 1);
+	VertexAttribDivisor(BoundVertexAttribInstanceColor, 1);
+	VertexAttribDivisor(BoundVertexAttribInstanceRotation, 1);
+	
+	s_Impl->m_SpriteInstances.reserve(MaxSpriteInstanceCount);
+	
+	Bacon_CreateShader(&s_Impl->m_SpriteShader,
+		
+		// Vertex shader
+		"precision highp float;\n"
+		"attribute vec2 a_Corner;\n"
+		"attribute vec4 a_InstanceRect;\n"
+		"attribute vec4 a_InstanceTexCoords;\n"
+		"attribute vec4 a_InstanceColor;\n"
+		"attribute float a_InstanceRotation;\n"
+		
+		"varying vec2 v_TexCoord0;\n"
+		"varying vec4 v_Color;\n"
+		
+		"uniform mat4 g_Projection;\n"
+		"uniform mat4 u_Transform;\n"
+		"uniform vec4 u_Color;\n"
+		"uniform float u_Z;\n"
+		
+		"void main()\n"
+		"{\n"
+		"    vec2 offset = (a_Corner - 0.5) * a_InstanceRect.zw;\n"
+		"    float s = sin(a_InstanceRotation);\n"
+		"    float c = cos(a_InstanceRotation);\n"
+		"    vec2 position = a_InstanceRect.xy + vec2(offset.x * c - offset.y * s, offset.x * s + offset.y * c);\n"
+		"    gl_Position = g_Projection * (u_Transform * vec4(position, u_Z, 1.0));\n"
+		"    v_TexCoord0 = mix(a_InstanceTexCoords.xy, a_InstanceTexCoords.zw, a_Corner);\n"
+		"    v_Color = u_Color * a_InstanceColor;\n"
+		"}\n",
+		
+		// Fragment shader
+		"precision highp float;\n"
+		"uniform sampler2D g_Texture0;\n"
+		"uniform float g_Texture0Alpha;\n"
+		"varying vec2 v_TexCoord0;\n"
+		"varying vec4 v_Color;\n"
+		
+		"void main()\n"
+		"{"
+		"    vec4 texel = texture2D(g_Texture0, v_TexCoord0);\n"
+		"    gl_FragColor = v_Color * mix(texel, texel.aaaa, g_Texture0Alpha);\n"
+		"}\n");
+	
+	s_Impl->m_SpriteTransformUniform = FindShaderUniform(s_Impl->m_SpriteShader, "u_Transform");
+	s_Impl->m_SpriteColorUniform = FindShaderUniform(s_Impl->m_SpriteShader, "u_Color");
+	s_Impl->m_SpriteZUniform = FindShaderUniform(s_Impl->m_SpriteShader, "u_Z");
+}
+
 void Graphics_InitGL()
 {
     Bacon_Log(Bacon_LogLevel_Info, "GL_VENDOR: %s", glGetString(GL_VENDOR));
@@ -376,15 +794,18 @@ void Graphics_InitGL()
 	// Constant state
 	glDisable(GL_CULL_FACE);
     glEnable(GL_SCISSOR_TEST);
+	
+	// Context is new, nothing in the shadow state can be trusted
+	ResetGLState();
 
 	// Vertex Buffer Object
 	glGenBuffers(1, &s_Impl->m_VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, s_Impl->m_VBO);
+	SetGLBuffer(GL_ARRAY_BUFFER, s_Impl->m_VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * MaxVertexCount, nullptr, GL_DYNAMIC_DRAW);
 	
 	// Index Buffer Object
 	glGenBuffers(1, &s_Impl->m_IBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_Impl->m_IBO);
+	SetGLBuffer(GL_ELEMENT_ARRAY_BUFFER, s_Impl->m_IBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * MaxIndexCount, nullptr, GL_DYNAMIC_DRAW);
 	
 	// Vertex Array Object
@@ -419,13 +840,54 @@ void Graphics_InitGL()
 		 // Fragment shader
          "precision highp float;\n"
 		 "uniform sampler2D g_Texture0;\n"
+		 "uniform float g_Texture0Alpha;\n"
+		 "varying vec2 v_TexCoord0;\n"
+		 "varying vec4 v_Color;\n"
+		 
+		 "void main()\n"
+		 "{"
+		 "    // Single channel textures hold premultiplied white\n"
+		 "    vec4 texel = texture2D(g_Texture0, v_TexCoord0);\n"
+         "    gl_FragColor = v_Color * mix(texel, texel.aaaa, g_Texture0Alpha);\n"
+		 "}\n");
+	
+	// Distance field shader; texels hold signed distance to the glyph outline, 0.5 on the edge.
+	// u_Smoothing is half the width of one target pixel in those units.
+	Bacon_CreateShader(&s_Impl->m_DistanceFieldShader,
+		 
+		 // Vertex shader
+		 "precision highp float;\n"
+         "attribute vec3 a_Position;\n"
+		 "attribute vec2 a_TexCoord0;\n"
+         "attribute vec4 a_Color;\n"
+		 
+		 "varying vec2 v_TexCoord0;\n"
+		 "varying vec4 v_Color;\n"
+		 
+		 "uniform mat4 g_Projection;\n"
+		 
+		 "void main()\n"
+		 "{\n"
+		 "    gl_Position = g_Projection * vec4(a_Position, 1.0);\n"
+		 "    v_TexCoord0 = a_TexCoord0;\n"
+		 "    v_Color = a_Color;\n"
+		 "}\n",
+		 
+		 // Fragment shader
+         "precision highp float;\n"
+		 "uniform sampler2D g_Texture0;\n"
+		 "uniform float u_Smoothing;\n"
 		 "varying vec2 v_TexCoord0;\n"
 		 "varying vec4 v_Color;\n"
 		 
 		 "void main()\n"
 		 "{"
-         "    gl_FragColor = v_Color * texture2D(g_Texture0, v_TexCoord0);\n"
+		 "    float distance = texture2D(g_Texture0, v_TexCoord0).a;\n"
+         "    gl_FragColor = v_Color * smoothstep(0.5 - u_Smoothing, 0.5 + u_Smoothing, distance);\n"
 		 "}\n");
+	s_Impl->m_DistanceFieldSmoothingUniform = FindShaderUniform(s_Impl->m_DistanceFieldShader, "u_Smoothing");
+	
+	InitSpritesGL();
 }
 
 void Graphics_ShutdownGL()
@@ -437,16 +899,22 @@ void Graphics_BeginFrame(int width, int height)
     DebugOverlay_SetCounter(s_Impl->m_DebugCounter_FrameBufferBinds, 0);
     DebugOverlay_SetCounter(s_Impl->m_DebugCounter_DrawCalls, 0);
     DebugOverlay_SetCounter(s_Impl->m_DebugCounter_Primitives, 0);
+    DebugOverlay_SetCounter(s_Impl->m_DebugCounter_GLStateIssued, 0);
+    DebugOverlay_SetCounter(s_Impl->m_DebugCounter_GLStateFiltered, 0);
+    DebugOverlay_SetCounter(s_Impl->m_DebugCounter_TransientAcquires, 0);
+    DebugOverlay_SetCounter(s_Impl->m_DebugCounter_TransientAliased, 0);
 
 	if (!s_Impl->m_PendingDeleteTextures.empty())
 	{
 		glDeleteTextures((GLsizei)s_Impl->m_PendingDeleteTextures.size(), &s_Impl->m_PendingDeleteTextures[0]);
+		ForgetGLTextures(s_Impl->m_PendingDeleteTextures);
 		s_Impl->m_PendingDeleteTextures.clear();
 	}
 
 	if (!s_Impl->m_PendingDeleteFrameBuffers.empty())
 	{
 		glDeleteFramebuffers((GLsizei)s_Impl->m_PendingDeleteFrameBuffers.size(), &s_Impl->m_PendingDeleteFrameBuffers[0]);
+		ForgetGLFrameBuffers(s_Impl->m_PendingDeleteFrameBuffers);
 		s_Impl->m_PendingDeleteFrameBuffers.clear();
 	}
 	
@@ -470,6 +938,8 @@ void Graphics_BeginFrame(int width, int height)
 	s_Impl->m_TransformStack.clear();
 	s_Impl->m_TransformStack.push_back(mat4f::IDENTITY);
 	
+	UpdateShaderHotReload();
+	
 	Bacon_SetFrameBuffer(0, contentScale);
 	Bacon_SetShader(0);
 	Bacon_SetBlending(Bacon_Blend_One, Bacon_Blend_OneMinusSrcAlpha);
@@ -478,6 +948,8 @@ void Graphics_BeginFrame(int width, int height)
 void Graphics_EndFrame()
 {
 	Bacon_Flush();
+	RecycleTransientImages();
+	++s_Impl->m_FrameIndex;
 	s_Impl->m_IsInFrame = false;
 }
 
@@ -694,56 +1166,353 @@ static bool TranslateShader(Shader* shader, GLuint type, string& source)
 	return true;
 }
 
-int Bacon_CreateShader(int* outHandle, const char* vertexSource, const char* fragmentSource)
+// Assign texture units to sampler uniforms
+static void AssignShaderTextureUnits(Shader* shader)
+{
+	int textureUnit = 0;
+	shader->m_TextureUnits.clear();
+	for (auto& uniform : shader->m_Uniforms)
+	{
+		if (uniform.m_Type == SH_SAMPLER_2D)
+		{
+			uniform.m_TextureUnit = textureUnit;
+			for (int i = 0; i < uniform.m_ArrayCount; ++i)
+			{
+				textureUnit++;
+				shader->m_TextureUnits.push_back(0);
+			}
+		}
+		else
+		{
+			uniform.m_TextureUnit = -1;
+		}
+	}
+}
+
+// Translate both stages and reflect uniforms; on failure the shader is left partially initialized
+// and must be discarded.
+static bool InitShader(Shader* shader, const char* vertexSource, const char* fragmentSource)
 {
-	if (!outHandle || !vertexSource || !fragmentSource)
-		return Bacon_Error_InvalidArgument;
-	
-	*outHandle = s_Impl->m_Shaders.Alloc();
-	Shader* shader = s_Impl->m_Shaders.Get(*outHandle);
 	shader->m_Program = 0;
 	shader->m_VertexSource = vertexSource;
 	shader->m_FragmentSource = fragmentSource;
 	shader->m_SharedUniformsVersion = -1;
 	shader->m_NonSharedValuesDirty = true;
+	shader->m_Uniforms.clear();
 	
 	if (!TranslateShader(shader, GL_VERTEX_SHADER, shader->m_VertexSource))
+		return false;
+	
+	if (!TranslateShader(shader, GL_FRAGMENT_SHADER, shader->m_FragmentSource))
+		return false;
+
+	AssignShaderTextureUnits(shader);
+	return true;
+}
+
+int Bacon_CreateShader(int* outHandle, const char* vertexSource, const char* fragmentSource)
+{
+	if (!outHandle || !vertexSource || !fragmentSource)
+		return Bacon_Error_InvalidArgument;
+	
+	*outHandle = s_Impl->m_Shaders.Alloc();
+	Shader* shader = s_Impl->m_Shaders.Get(*outHandle);
+	shader->m_Flags = 0;
+	
+	if (!InitShader(shader, vertexSource, fragmentSource))
 	{
 		s_Impl->m_Shaders.Free(*outHandle);
 		return Bacon_Error_ShaderCompileError;
 	}
+
+	if (!s_Impl->m_CurrentShader)
+		s_Impl->m_CurrentShader = *outHandle;
 	
-	if (!TranslateShader(shader, GL_FRAGMENT_SHADER, shader->m_FragmentSource))
+    DebugOverlay_AddCounter(s_Impl->m_DebugCounter_Shaders, 1);
+
+	return Bacon_Error_None;
+}
+
+static bool ReadTextFile(const char* path, string& outText)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return false;
+	
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	outText.resize(size);
+	bool success = size == 0 || fread(&outText[0], 1, size, file) == (size_t)size;
+	fclose(file);
+	return success;
+}
+
+static time_t GetFileModifiedTime(const char* path)
+{
+	struct stat info;
+	if (stat(path, &info) != 0)
+		return 0;
+	return info.st_mtime;
+}
+
+int Bacon_LoadShader(int* outHandle, const char* vertexPath, const char* fragmentPath, int flags)
+{
+	if (!outHandle || !vertexPath || !fragmentPath)
+		return Bacon_Error_InvalidArgument;
+	
+	string vertexSource;
+	string fragmentSource;
+	time_t vertexModifiedTime = GetFileModifiedTime(vertexPath);
+	time_t fragmentModifiedTime = GetFileModifiedTime(fragmentPath);
+	if (!ReadTextFile(vertexPath, vertexSource) ||
+		!ReadTextFile(fragmentPath, fragmentSource))
+		return Bacon_Error_IOError;
+	
+	if (int error = Bacon_CreateShader(outHandle, vertexSource.c_str(), fragmentSource.c_str()))
+		return error;
+	
+	Shader* shader = s_Impl->m_Shaders.Get(*outHandle);
+	shader->m_Flags = flags;
+	shader->m_VertexPath = vertexPath;
+	shader->m_FragmentPath = fragmentPath;
+	shader->m_VertexModifiedTime = vertexModifiedTime;
+	shader->m_FragmentModifiedTime = fragmentModifiedTime;
+	
+	if (flags & Bacon_ShaderFlags_HotReload)
+		++s_Impl->m_HotReloadShaderCount;
+	
+	return Bacon_Error_None;
+}
+
+int Bacon_CreateShaderFamily(int* outHandle, const char* vertexSource, const char* fragmentSource, const char** defines, int defineCount)
+{
+	if (!outHandle || !vertexSource || !fragmentSource || defineCount < 0 || defineCount > MaxShaderFamilyDefines)
+		return Bacon_Error_InvalidArgument;
+	
+	if (defineCount && !defines)
+		return Bacon_Error_InvalidArgument;
+	
+	*outHandle = s_Impl->m_ShaderFamilies.Alloc();
+	ShaderFamily* family = s_Impl->m_ShaderFamilies.Get(*outHandle);
+	family->m_VertexSource = vertexSource;
+	family->m_FragmentSource = fragmentSource;
+	for (int i = 0; i < defineCount; ++i)
+		family->m_Defines.push_back(defines[i]);
+	
+	return Bacon_Error_None;
+}
+
+// Insert #define lines into source, after the #version directive if there is one
+static string GetShaderVariantSource(string const& source, string const& defines)
+{
+	size_t insertPos = 0;
+	size_t versionPos = source.find("#version");
+	if (versionPos != string::npos && source.find_first_not_of(" \t\r\n") == versionPos)
 	{
-		s_Impl->m_Shaders.Free(*outHandle);
-		return Bacon_Error_ShaderCompileError;
+		insertPos = source.find('\n', versionPos);
+		insertPos = (insertPos == string::npos) ? source.size() : insertPos + 1;
 	}
+	
+	string variantSource = source;
+	variantSource.insert(insertPos, defines);
+	return variantSource;
+}
 
-	// Assign texture units to sampler uniforms
-	int textureUnit = 0;
-	for (auto& uniform : shader->m_Uniforms)
+int Bacon_GetShaderVariant(int* outShader, int familyHandle, int defineMask)
+{
+	if (!outShader)
+		return Bacon_Error_InvalidArgument;
+	
+	ShaderFamily* family = s_Impl->m_ShaderFamilies.Get(familyHandle);
+	if (!family)
+		return Bacon_Error_InvalidHandle;
+	
+	// Bits are tested unsigned, as the 32nd define is the sign bit
+	unsigned int mask = (unsigned int)defineMask;
+	int definesCount = (int)family->m_Defines.size();
+	if (definesCount < MaxShaderFamilyDefines && (mask & ~((1u << definesCount) - 1)))
+		return Bacon_Error_InvalidArgument;
+	
+	auto it = family->m_Variants.find(defineMask);
+	if (it != family->m_Variants.end())
 	{
-		if (uniform.m_Type == SH_SAMPLER_2D)
+		*outShader = it->second;
+		return Bacon_Error_None;
+	}
+	
+	string defines;
+	for (int i = 0; i < definesCount; ++i)
+	{
+		if (mask & (1u << i))
+			defines += "#define " + family->m_Defines[i] + " 1\n";
+	}
+	
+	string vertexSource = GetShaderVariantSource(family->m_VertexSource, defines);
+	string fragmentSource = GetShaderVariantSource(family->m_FragmentSource, defines);
+	if (int error = Bacon_CreateShader(outShader, vertexSource.c_str(), fragmentSource.c_str()))
+		return error;
+	
+	family->m_Variants[defineMask] = *outShader;
+	return Bacon_Error_None;
+}
+
+static ShaderUniform* FindShaderUniform(vector<ShaderUniform>& uniforms, ShaderUniform const& match)
+{
+	for (auto& uniform : uniforms)
+	{
+		if (uniform.m_Name == match.m_Name &&
+			uniform.m_Type == match.m_Type &&
+			uniform.m_ArrayCount == match.m_ArrayCount)
+			return &uniform;
+	}
+	return nullptr;
+}
+
+static int CompileShader(Shader* shader);
+
+// Re-translates, compiles and links the shader from new source; on failure the shader is left
+// untouched.  Uniform indices already handed out by Bacon_EnumShaderUniforms stay valid: existing
+// uniforms keep their index and value, uniforms removed from the source remain as unlinked
+// placeholders, and new uniforms are appended.
+static bool ReloadShader(Shader* shader, const char* vertexSource, const char* fragmentSource)
+{
+	Shader reloaded;
+	reloaded.m_Flags = shader->m_Flags;
+	if (!InitShader(&reloaded, vertexSource, fragmentSource))
+		return false;
+	
+	vector<ShaderUniform> uniforms;
+	vector<bool> isTranslated;
+	uniforms.reserve(shader->m_Uniforms.size() + reloaded.m_Uniforms.size());
+	for (auto& oldUniform : shader->m_Uniforms)
+	{
+		ShaderUniform* newUniform = FindShaderUniform(reloaded.m_Uniforms, oldUniform);
+		if (newUniform)
 		{
-			uniform.m_TextureUnit = textureUnit;
-			for (int i = 0; i < uniform.m_ArrayCount; ++i)
-			{
-				textureUnit++;
-				shader->m_TextureUnits.push_back(0);
-			}
+			uniforms.push_back(*newUniform);
+			if (oldUniform.m_SharedUniformIndex == -1)
+				uniforms.back().m_Value = oldUniform.m_Value;
+			newUniform->m_Name.clear();
 		}
 		else
+		{
+			uniforms.push_back(oldUniform);
+		}
+		uniforms.back().m_Id = -1;
+		uniforms.back().m_ValueVersion = uniforms.back().m_SharedUniformIndex == -1 ? 1 : -1;
+		isTranslated.push_back(newUniform != nullptr);
+	}
+	
+	for (auto& newUniform : reloaded.m_Uniforms)
+	{
+		if (newUniform.m_Name.empty())
+			continue;
+		uniforms.push_back(newUniform);
+		isTranslated.push_back(true);
+	}
+	
+	// Carry sampler bindings over by uniform name
+	vector<int> oldTextureUnits = shader->m_TextureUnits;
+	vector<int> oldUniformTextureUnits;
+	for (auto& uniform : shader->m_Uniforms)
+		oldUniformTextureUnits.push_back(uniform.m_TextureUnit);
+	
+	reloaded.m_Uniforms.swap(uniforms);
+	reloaded.m_TextureUnits.clear();
+	int textureUnit = 0;
+	for (size_t i = 0; i < reloaded.m_Uniforms.size(); ++i)
+	{
+		ShaderUniform& uniform = reloaded.m_Uniforms[i];
+		if (uniform.m_Type != SH_SAMPLER_2D || !isTranslated[i])
 		{
 			uniform.m_TextureUnit = -1;
+			continue;
+		}
+		
+		uniform.m_TextureUnit = textureUnit;
+		for (int j = 0; j < uniform.m_ArrayCount; ++j)
+		{
+			int value = 0;
+			if (i < oldUniformTextureUnits.size() && oldUniformTextureUnits[i] != -1)
+				value = oldTextureUnits[oldUniformTextureUnits[i] + j];
+			reloaded.m_TextureUnits.push_back(value);
+			++textureUnit;
 		}
 	}
-
-	if (!s_Impl->m_CurrentShader)
-		s_Impl->m_CurrentShader = *outHandle;
 	
-    DebugOverlay_AddCounter(s_Impl->m_DebugCounter_Shaders, 1);
+	// Stages that translate can still fail to compile or link together (e.g. mismatched varyings)
+	if (CompileShader(&reloaded))
+		return false;
+	
+	if (shader->m_Program)
+	{
+		if (s_Impl->m_GLState.m_Program == shader->m_Program)
+			SetGLProgram(0);
+		glDeleteProgram(shader->m_Program);
+	}
+	
+	shader->m_VertexSource.swap(reloaded.m_VertexSource);
+	shader->m_FragmentSource.swap(reloaded.m_FragmentSource);
+	shader->m_Uniforms.swap(reloaded.m_Uniforms);
+	shader->m_TextureUnits.swap(reloaded.m_TextureUnits);
+	shader->m_Program = reloaded.m_Program;
+	shader->m_HasError = false;
+	shader->m_SharedUniformsVersion = -1;
+	shader->m_NonSharedValuesDirty = true;
+	return true;
+}
 
-	return Bacon_Error_None;
+// Called at the start of each frame; reloads any hot-reload shaders whose source files have
+// changed since they were last loaded.
+static void UpdateShaderHotReload()
+{
+	if (!s_Impl->m_HotReloadShaderCount)
+		return;
+	
+	float time;
+	Platform_GetPerformanceTime(time);
+	if (time - s_Impl->m_LastShaderReloadCheckTime < ShaderReloadInterval)
+		return;
+	s_Impl->m_LastShaderReloadCheckTime = time;
+	
+	bool reloaded = false;
+	for (Shader& shader : s_Impl->m_Shaders)
+	{
+		if (!(shader.m_Flags & Bacon_ShaderFlags_HotReload))
+			continue;
+		
+		time_t vertexModifiedTime = GetFileModifiedTime(shader.m_VertexPath.c_str());
+		time_t fragmentModifiedTime = GetFileModifiedTime(shader.m_FragmentPath.c_str());
+		if (vertexModifiedTime == shader.m_VertexModifiedTime &&
+			fragmentModifiedTime == shader.m_FragmentModifiedTime)
+			continue;
+		
+		// Record the times even if the reload fails, so a broken shader is reported only once
+		// per save
+		shader.m_VertexModifiedTime = vertexModifiedTime;
+		shader.m_FragmentModifiedTime = fragmentModifiedTime;
+		
+		string vertexSource;
+		string fragmentSource;
+		if (!ReadTextFile(shader.m_VertexPath.c_str(), vertexSource) ||
+			!ReadTextFile(shader.m_FragmentPath.c_str(), fragmentSource))
+			continue;
+		
+		if (ReloadShader(&shader, vertexSource.c_str(), fragmentSource.c_str()))
+		{
+			reloaded = true;
+			Bacon_Log(Bacon_LogLevel_Info, "Reloaded shader %s, %s", shader.m_VertexPath.c_str(), shader.m_FragmentPath.c_str());
+		}
+		else
+		{
+			Bacon_Log(Bacon_LogLevel_Error, "Failed to reload shader %s, %s; keeping previous version", shader.m_VertexPath.c_str(), shader.m_FragmentPath.c_str());
+		}
+	}
+	
+	// Current shader may have been reloaded; force it to be rebound
+	if (reloaded)
+		s_Impl->m_CurrentShader = -1;
 }
 
 int Bacon_EnumShaderUniforms(int handle, Bacon_EnumShaderUniformsCallback callback, void* arg)
@@ -830,12 +1599,23 @@ static int CompileShader(Shader* shader)
 	GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, shader->m_VertexSource.c_str());
 	GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, shader->m_FragmentSource.c_str());
 	if (!vertexShader || !fragmentShader)
+	{
+		if (vertexShader)
+			glDeleteShader(vertexShader);
+		if (fragmentShader)
+			glDeleteShader(fragmentShader);
 		return Bacon_Error_ShaderCompileError;
+	}
 	
 	GLuint program = glCreateProgram();
 	glBindAttribLocation(program, BoundVertexAttribPosition, VertexAttribPosition);
     glBindAttribLocation(program, BoundVertexAttribTexCoord0, VertexAttribTexCoord0);
     glBindAttribLocation(program, BoundVertexAttribColor, VertexAttribColor);
+	glBindAttribLocation(program, BoundVertexAttribCorner, VertexAttribCorner);
+	glBindAttribLocation(program, BoundVertexAttribInstanceRect, VertexAttribInstanceRect);
+	glBindAttribLocation(program, BoundVertexAttribInstanceTexCoords, VertexAttribInstanceTexCoords);
+	glBindAttribLocation(program, BoundVertexAttribInstanceColor, VertexAttribInstanceColor);
+	glBindAttribLocation(program, BoundVertexAttribInstanceRotation, VertexAttribInstanceRotation);
 	glAttachShader(program, vertexShader);
 	glAttachShader(program, fragmentShader);
 	
@@ -856,13 +1636,14 @@ static int CompileShader(Shader* shader)
 		Bacon_Log(Bacon_LogLevel_Error, "Vertex shader source:\n%s", shader->m_VertexSource.c_str());
 		Bacon_Log(Bacon_LogLevel_Error, "Fragment shader source:\n%s", shader->m_FragmentSource.c_str());
 		delete[] log;
+		glDeleteProgram(program);
 		return Bacon_Error_ShaderLinkError;
 	}
 	
 	shader->m_HasError = false;
 	shader->m_Program = program;
 	
-	glUseProgram(program);
+	SetGLProgram(program);
 	for (auto& uniform : shader->m_Uniforms)
 	{
 		uniform.m_Id = glGetUniformLocation(program, uniform.m_Name.c_str());
@@ -895,14 +1676,14 @@ static int BindShader(int handle)
 		CompileShader(shader);
 			
 	if (shader->m_HasError)
-		glUseProgram(0);					// TODO error shader
+		SetGLProgram(0);					// TODO error shader
 	else
-		glUseProgram(shader->m_Program);
+		SetGLProgram(shader->m_Program);
 	
 	return Bacon_Error_None;
 }
 
-static int BindTexture(int handle);
+static int BindTexture(int unit, int handle);
 
 static void BindShaderUniforms()
 {
@@ -995,15 +1776,8 @@ static void BindShaderTextureUnits()
 {
 	Shader* shader = s_Impl->m_Shaders.Get(s_Impl->m_CurrentShader);
 
-	for (int i = 0; i < shader->m_TextureUnits.size(); ++i)
-	{
-		if (s_Impl->m_CurrentTextureUnits[i] != shader->m_TextureUnits[i])
-		{
-			glActiveTexture(GL_TEXTURE0 + i);
-			BindTexture(shader->m_TextureUnits[i]);
-			s_Impl->m_CurrentTextureUnits[i] = shader->m_TextureUnits[i];
-		}
-	}
+	for (int i = 0; i < shader->m_TextureUnits.size() && i < MaxTextureUnits; ++i)
+		BindTexture(i, shader->m_TextureUnits[i]);
 }
 
 // Images
@@ -1015,6 +1789,12 @@ static bool IsPowerTwo(int n)
 
 static bool IsImageFlagsValid(int width, int height, int flags)
 {
+    if (flags & ~(Bacon_ImageFlags_Reserved - 1))
+    {
+        Bacon_Log(Bacon_LogLevel_Error, "Image flags from Bacon_ImageFlags_Reserved are for internal use");
+        return false;
+    }
+
     if ((flags & Bacon_ImageFlags_Wrap) && 
         (flags & Bacon_ImageFlags_AtlasGroupMask))
     {
@@ -1031,14 +1811,8 @@ static bool IsImageFlagsValid(int width, int height, int flags)
     return true;
 }
 
-int Bacon_CreateImage(int* outHandle, int width, int height, int flags)
+static int CreateImage(int* outHandle, int width, int height, int flags)
 {
-	if (!outHandle || width <= 0 || height <= 0)
-		return Bacon_Error_InvalidArgument;
-	
-    if (!IsImageFlagsValid(width, height, flags))
-        return Bacon_Error_InvalidArgument;
-
 	*outHandle = s_Impl->m_Images.Alloc();
 	Image* image = s_Impl->m_Images.Get(*outHandle);
     image->m_RefCount = 1;
@@ -1055,6 +1829,28 @@ int Bacon_CreateImage(int* outHandle, int width, int height, int flags)
 	return Bacon_Error_None;
 }
 
+int Bacon_CreateImage(int* outHandle, int width, int height, int flags)
+{
+	if (!outHandle || width <= 0 || height <= 0)
+		return Bacon_Error_InvalidArgument;
+	
+    if (!IsImageFlagsValid(width, height, flags))
+        return Bacon_Error_InvalidArgument;
+
+	return CreateImage(outHandle, width, height, flags);
+}
+
+int Graphics_CreateAlphaImage(int* outHandle, int width, int height, int flags)
+{
+	if (!outHandle || width <= 0 || height <= 0)
+		return Bacon_Error_InvalidArgument;
+	
+    if (!IsImageFlagsValid(width, height, flags))
+        return Bacon_Error_InvalidArgument;
+
+	return CreateImage(outHandle, width, height, flags | Bacon_ImageFlags_Internal_FormatAlpha);
+}
+
 int Bacon_LoadImage(int* outHandle, const char* path, int flags)
 {
 	if (!outHandle || !path)
@@ -1231,13 +2027,112 @@ int Bacon_UnloadImage(int handle)
 	return Bacon_Error_None;
 }
 
+int Bacon_AcquireTransientImage(int* outHandle, int width, int height, int flags)
+{
+	if (!outHandle || width <= 0 || height <= 0)
+		return Bacon_Error_InvalidArgument;
+	
+	// Transient images are render targets, so are never packed into an atlas
+	flags &= ~Bacon_ImageFlags_AtlasGroupMask;
+	if (!IsImageFlagsValid(width, height, flags))
+		return Bacon_Error_InvalidArgument;
+	
+	DebugOverlay_AddCounter(s_Impl->m_DebugCounter_TransientAcquires, 1);
+	
+	// Alias a pooled image of the same size and sampling that is not in use this frame
+	int matchFlags = flags & Bacon_ImageFlags_AtlasFlagsMask;
+	TransientImage* transient = nullptr;
+	for (TransientImage& entry : s_Impl->m_TransientImages)
+	{
+		if (!entry.m_InUse &&
+			entry.m_Width == width &&
+			entry.m_Height == height &&
+			(entry.m_Flags & Bacon_ImageFlags_AtlasFlagsMask) == matchFlags)
+		{
+			transient = &entry;
+			DebugOverlay_AddCounter(s_Impl->m_DebugCounter_TransientAliased, 1);
+			break;
+		}
+	}
+	
+	if (!transient)
+	{
+		TransientImage entry;
+		if (int error = Bacon_CreateImage(&entry.m_Image, width, height, flags))
+			return error;
+		entry.m_Width = width;
+		entry.m_Height = height;
+		entry.m_Flags = flags;
+		s_Impl->m_TransientImages.push_back(entry);
+		transient = &s_Impl->m_TransientImages.back();
+		DebugOverlay_AddCounter(s_Impl->m_DebugCounter_TransientImages, 1);
+	}
+	
+	transient->m_InUse = true;
+	transient->m_LastUsedFrame = s_Impl->m_FrameIndex;
+	
+	// Caller's reference, released with Bacon_UnloadImage as usual
+	++s_Impl->m_Images.Get(transient->m_Image)->m_RefCount;
+	*outHandle = transient->m_Image;
+	return Bacon_Error_None;
+}
+
+int Bacon_ReleaseTransientImage(int handle)
+{
+	for (TransientImage& entry : s_Impl->m_TransientImages)
+	{
+		if (entry.m_Image == handle)
+		{
+			entry.m_InUse = false;
+			return Bacon_Error_None;
+		}
+	}
+	return Bacon_Error_InvalidHandle;
+}
+
+static void RecycleTransientImages()
+{
+	vector<TransientImage>& transients = s_Impl->m_TransientImages;
+	for (size_t i = 0; i < transients.size(); )
+	{
+		TransientImage& entry = transients[i];
+		entry.m_InUse = false;
+		if (s_Impl->m_FrameIndex - entry.m_LastUsedFrame >= TransientImageEvictFrames)
+		{
+			ReleaseImage(entry.m_Image);
+			transients[i] = transients.back();
+			transients.pop_back();
+			DebugOverlay_AddCounter(s_Impl->m_DebugCounter_TransientImages, -1);
+		}
+		else
+			++i;
+	}
+}
+
 static void UpdateTexture(Texture* texture, FIBITMAP* bitmap)
 {
 	bool ownsData = false;
 	BYTE* data = nullptr;
+	FIBITMAP* ownedBitmap = nullptr;
 	GLuint format = GL_BGRA_EXT;
 	GLuint internalFormat = GL_RGBA;
-	if (bitmap)
+	int bytesPerTexel = 4;
+	if (texture->m_Flags & Bacon_ImageFlags_Internal_FormatAlpha)
+	{
+		format = GL_ALPHA;
+		internalFormat = GL_ALPHA;
+		bytesPerTexel = 1;
+		if (bitmap)
+		{
+			if (FreeImage_GetBPP(bitmap) != 8)
+				bitmap = ownedBitmap = FreeImage_GetChannel(bitmap, FICC_ALPHA);
+			
+			// Rows of 8bpp bitmaps are padded to 4 bytes
+			data = bitmap ? FreeImage_GetBits(bitmap) : nullptr;
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		}
+	}
+	else if (bitmap)
 	{
 		data = FreeImage_GetBits(bitmap);
 		int pitch = FreeImage_GetPitch(bitmap);
@@ -1273,14 +2168,11 @@ static void UpdateTexture(Texture* texture, FIBITMAP* bitmap)
 	internalFormat = format;
 #endif
 	
-	glActiveTexture(GL_TEXTURE0);
-	s_Impl->m_CurrentTextureUnits[0] = s_Impl->m_Textures.GetHandle(texture);
-	
 	// TODO optionally use TexSubImage2D
 	
 	if (!texture->m_TextureId)
 		glGenTextures(1, &texture->m_TextureId);
-	glBindTexture(GL_TEXTURE_2D, texture->m_TextureId);
+	SetGLTexture(0, texture->m_TextureId);
 	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, texture->m_Width, texture->m_Height, 0, format, GL_UNSIGNED_BYTE, data);
     if (texture->m_Flags & Bacon_ImageFlags_SampleNearest)
     {
@@ -1304,13 +2196,14 @@ static void UpdateTexture(Texture* texture, FIBITMAP* bitmap)
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     }
 
-    int size = texture->m_Width * texture->m_Height * 4;
+    int size = texture->m_Width * texture->m_Height * bytesPerTexel;
     DebugOverlay_AddCounter(s_Impl->m_DebugCounter_TextureMemory, size - texture->m_Size);
     texture->m_Size = size;
 
 	if (ownsData)
 		free(data);
-
+	if (ownedBitmap)
+		FreeImage_Unload(ownedBitmap);
 }
 
 static Texture* CreateTexture(int* outTextureHandle, FIBITMAP* bitmap, int width, int height, int flags)
@@ -1330,65 +2223,80 @@ static Texture* CreateTexture(int* outTextureHandle, FIBITMAP* bitmap, int width
 	return texture;
 }
 
-static void Blit32Line(char* destData, int destPitch, const char* srcData, int srcPitch, int destX, int destY, int srcX, int srcY, int size, int margin)
+static void BlitLine(char* destData, int destPitch, const char* srcData, int srcPitch, int bytesPerPixel, int destX, int destY, int srcX, int srcY, int size, int margin)
 {
-	char* dest = destData + destPitch * destY + destX * 4;
-	const char* src = srcData + srcPitch * srcY + srcX * 4;
+	char* dest = destData + destPitch * destY + destX * bytesPerPixel;
+	const char* src = srcData + srcPitch * srcY + srcX * bytesPerPixel;
 	
 	// Left margin
 	for (int x = -margin; x < 0; ++x)
-		memcpy(dest + x * 4, src, 4);
+		memcpy(dest + x * bytesPerPixel, src, bytesPerPixel);
 		
 	// Row
-	memcpy(dest, src, size * 4);
+	memcpy(dest, src, size * bytesPerPixel);
 
 	// Right margin
-	for (int x = size * 4; x < (size + margin) * 4; x += 4)
-		memcpy(dest + x, src + (size - 1) * 4, 4);
+	for (int x = size * bytesPerPixel; x < (size + margin) * bytesPerPixel; x += bytesPerPixel)
+		memcpy(dest + x, src + (size - 1) * bytesPerPixel, bytesPerPixel);
 }
 
-// Blit entire srcBitmap int destRect of destBitmap.  If destMargin > 0, adds padding pixels around
-// destRect (caller's responsibility to ensure dest bitmap is large enough)
-static void Blit32(FIBITMAP* destBitmap, FIBITMAP* srcBitmap, Rect const& destRect, int destMargin)
+// Blit entire srcBitmap int destRect of destBitmap, which is either 32bpp or 8bpp (alpha only).  If
+// destMargin > 0, adds padding pixels around destRect (caller's responsibility to ensure dest bitmap
+// is large enough)
+static void Blit(FIBITMAP* destBitmap, FIBITMAP* srcBitmap, Rect const& destRect, int destMargin)
 {
+	int bytesPerPixel = FreeImage_GetBPP(destBitmap) / 8;
+	assert(bytesPerPixel == 4 || bytesPerPixel == 1);
+	
 	const char* srcData;
+	int srcPitch;
 	char* ownedSrcData = nullptr;
-	if (FreeImage_GetBPP(srcBitmap) == 32)
+	FIBITMAP* ownedSrcBitmap = nullptr;
+	if (FreeImage_GetBPP(srcBitmap) == bytesPerPixel * 8)
 	{
 		srcData = (char*)FreeImage_GetBits(srcBitmap);
+		srcPitch = FreeImage_GetPitch(srcBitmap);
+	}
+	else if (bytesPerPixel == 1)
+	{
+		ownedSrcBitmap = FreeImage_GetChannel(srcBitmap, FICC_ALPHA);
+		if (!ownedSrcBitmap)
+			return;
+		srcData = (char*)FreeImage_GetBits(ownedSrcBitmap);
+		srcPitch = FreeImage_GetPitch(ownedSrcBitmap);
 	}
 	else
 	{
 		// TODO support more source formats directly, at least 24bpp
-		int pitch = FreeImage_GetWidth(srcBitmap) * 4;
-		srcData = ownedSrcData = (char*)malloc(pitch * FreeImage_GetHeight(srcBitmap));
-		FreeImage_ConvertToRawBits((BYTE*)ownedSrcData, srcBitmap, pitch, 32, 0, 0, 0, FALSE);
+		srcPitch = FreeImage_GetWidth(srcBitmap) * 4;
+		srcData = ownedSrcData = (char*)malloc(srcPitch * FreeImage_GetHeight(srcBitmap));
+		FreeImage_ConvertToRawBits((BYTE*)ownedSrcData, srcBitmap, srcPitch, 32, 0, 0, 0, FALSE);
 	}
 
-	assert(FreeImage_GetBPP(destBitmap) == 32);
 	char* destData = (char*)FreeImage_GetBits(destBitmap);
-	int destPitch = FreeImage_GetWidth(destBitmap) * 4;
-	int srcPitch = FreeImage_GetWidth(srcBitmap) * 4;
+	int destPitch = FreeImage_GetPitch(destBitmap);
 	
 	// Top margin
 	for (int y = destRect.m_Top - destMargin; y < destRect.m_Top; ++y)
-		Blit32Line(destData, destPitch, srcData, srcPitch, destRect.m_Left, y, 0, 0, destRect.GetWidth(), destMargin);
+		BlitLine(destData, destPitch, srcData, srcPitch, bytesPerPixel, destRect.m_Left, y, 0, 0, destRect.GetWidth(), destMargin);
 	
 	// Image
 	for (int y = destRect.m_Top; y < destRect.m_Bottom; ++y)
-		Blit32Line(destData, destPitch, srcData, srcPitch, destRect.m_Left, y, 0, y - destRect.m_Top, destRect.GetWidth(), destMargin);
+		BlitLine(destData, destPitch, srcData, srcPitch, bytesPerPixel, destRect.m_Left, y, 0, y - destRect.m_Top, destRect.GetWidth(), destMargin);
 
 	// Bottom margin
 	for (int y = destRect.m_Bottom; y < destRect.m_Bottom + destMargin; ++y)
-		Blit32Line(destData, destPitch, srcData, srcPitch, destRect.m_Left, y, 0, destRect.GetHeight() - 1, destRect.GetWidth(), destMargin);
+		BlitLine(destData, destPitch, srcData, srcPitch, bytesPerPixel, destRect.m_Left, y, 0, destRect.GetHeight() - 1, destRect.GetWidth(), destMargin);
 
 	if (ownedSrcData)
 		free(ownedSrcData);
+	if (ownedSrcBitmap)
+		FreeImage_Unload(ownedSrcBitmap);
 }
 
 static bool IsAtlasFlagsCompatible(TextureAtlas* atlas, Image* image)
 {
-	if ((atlas->m_Flags & Bacon_ImageFlags_AtlasFlagsMask) != (image->m_Flags & Bacon_ImageFlags_AtlasFlagsMask))
+	if ((atlas->m_Flags & Bacon_ImageFlags_Internal_AtlasFlagsMask) != (image->m_Flags & Bacon_ImageFlags_Internal_AtlasFlagsMask))
 		return false;
 	return true;
 }
@@ -1437,11 +2345,11 @@ static void AddImageToTextureAtlas(Image* image, int hintSize)
 		atlasHandle = s_Impl->m_TextureAtlases.Alloc();
 		atlas = s_Impl->m_TextureAtlases.Get(atlasHandle);
 		atlas->m_Allocator.Init(size, size);
-		atlas->m_Flags = (image->m_Flags & Bacon_ImageFlags_AtlasFlagsMask);
+		atlas->m_Flags = (image->m_Flags & Bacon_ImageFlags_Internal_AtlasFlagsMask);
 		atlas->m_Texture = 0;
 		atlas->m_Width = size;
 		atlas->m_Height = size;
-		atlas->m_Bitmap = FreeImage_Allocate(atlas->m_Width, atlas->m_Height, 32);
+		atlas->m_Bitmap = FreeImage_Allocate(atlas->m_Width, atlas->m_Height, (atlas->m_Flags & Bacon_ImageFlags_Internal_FormatAlpha) ? 8 : 32);
 		
 		atlas->m_Allocator.Alloc(rect, image->m_Width, image->m_Height, TextureAtlasMargin);
 		CreateTexture(&atlas->m_Texture, atlas->m_Bitmap, atlas->m_Width, atlas->m_Height, atlas->m_Flags);
@@ -1450,7 +2358,7 @@ static void AddImageToTextureAtlas(Image* image, int hintSize)
 	assert(rect.GetWidth() == image->m_Width &&
 		   rect.GetHeight() == image->m_Height);
 	if (image->m_Bitmap)
-		Blit32(atlas->m_Bitmap, image->m_Bitmap, rect, TextureAtlasMargin);
+		Blit(atlas->m_Bitmap, image->m_Bitmap, rect, TextureAtlasMargin);
 	image->m_Atlas = atlasHandle;
 	image->m_UVScaleBias = UVScaleBias(rect.GetWidth() / (float)atlas->m_Width,
 									   rect.GetHeight() / (float)atlas->m_Height,
@@ -1472,7 +2380,7 @@ static void FillTextureAtlases(int group)
 	for (Image& image : s_Impl->m_Images)
 	{
 		if (image.m_Texture == 0 &&
-			(image.m_Flags & Bacon_ImageFlags_AtlasFlagsMask) == group)
+			(image.m_Flags & Bacon_ImageFlags_Internal_AtlasFlagsMask) == group)
 		{
 			images.push_back(&image);
 			totalArea += (image.m_Width + TextureAtlasMargin * 2) * (image.m_Height + TextureAtlasMargin * 2);
@@ -1531,7 +2439,7 @@ static Texture* RealizeTexture(Image* image)
 		
 		if (image->m_Flags & Bacon_ImageFlags_AtlasGroupMask)
 		{
-			FillTextureAtlases(image->m_Flags & Bacon_ImageFlags_AtlasFlagsMask);
+			FillTextureAtlases(image->m_Flags & Bacon_ImageFlags_Internal_AtlasFlagsMask);
 			texture = s_Impl->m_Textures.Get(image->m_Texture);
 		}
 		else
@@ -1549,22 +2457,32 @@ static Texture* RealizeTexture(Image* image)
 	return texture;
 }
 
-static int BindTexture(int textureHandle)
+static int BindTexture(int unit, int textureHandle)
 {
 	Texture* texture = s_Impl->m_Textures.Get(textureHandle);
 	if (!texture)
 		return Bacon_Error_InvalidHandle;
 	
-	glBindTexture(GL_TEXTURE_2D, texture->m_TextureId);
+	SetGLTexture(unit, texture->m_TextureId);
 	return Bacon_Error_None;
 }
 
 static bool CreateTextureFrameBuffer(Texture* texture)
 {
+	// Frame buffer is created once and kept with the texture until it is released
+	if (texture->m_FrameBuffer)
+		return true;
+	
 	glGenFramebuffers(1, &texture->m_FrameBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, texture->m_FrameBuffer);
+	SetGLFrameBuffer(texture->m_FrameBuffer);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->m_TextureId, 0);
-	return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		s_Impl->m_PendingDeleteFrameBuffers.push_back(texture->m_FrameBuffer);
+		texture->m_FrameBuffer = 0;
+		return false;
+	}
+	return true;
 }
 
 static int BindFrameBuffer(int imageHandle, float contentScale)
@@ -1572,7 +2490,7 @@ static int BindFrameBuffer(int imageHandle, float contentScale)
 	if (!imageHandle)
 	{
         s_Impl->m_CurrentFrameBufferTexture = 0;
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		SetGLFrameBuffer(0);
 		Bacon_SetViewport(0, 0, s_Impl->m_FrameBufferWidth, s_Impl->m_FrameBufferHeight, contentScale);
 
         DebugOverlay_AddCounter(s_Impl->m_DebugCounter_FrameBufferBinds, 1);
@@ -1583,6 +2501,12 @@ static int BindFrameBuffer(int imageHandle, float contentScale)
 	Image* image = s_Impl->m_Images.Get(imageHandle);
 	if (!image)
 		return Bacon_Error_InvalidHandle;
+	
+	if (image->m_Flags & Bacon_ImageFlags_Internal_FormatAlpha)
+	{
+		Bacon_Log(Bacon_LogLevel_Error, "Glyph images cannot be used as a frame buffer");
+		return Bacon_Error_InvalidArgument;
+	}
 
 	Texture* texture = RealizeTexture(image);
 	s_Impl->m_CurrentFrameBufferTexture = image->m_Texture;
@@ -1590,7 +2514,7 @@ static int BindFrameBuffer(int imageHandle, float contentScale)
 	if (!CreateTextureFrameBuffer(texture))
 		return Bacon_Error_Unknown;
 	
-	glBindFramebuffer(GL_FRAMEBUFFER, texture->m_FrameBuffer);
+	SetGLFrameBuffer(texture->m_FrameBuffer);
 	float x = image->m_UVScaleBias.m_BiasX * texture->m_Width;
 	float bottom = texture->m_Height - image->m_UVScaleBias.m_BiasY * texture->m_Height;
 	float top = bottom - image->m_Height;
@@ -1738,8 +2662,6 @@ int Bacon_SetViewport(int x, int y, int width, int height, float contentScale)
 {
 	REQUIRE_GL();
 
-	Bacon_Flush();
-
 	int frameBufferHeight = s_Impl->m_FrameBufferHeight;
 	if (s_Impl->m_CurrentFrameBuffer != 0)
 	{
@@ -1749,14 +2671,41 @@ int Bacon_SetViewport(int x, int y, int width, int height, float contentScale)
 	}
 	
 	y = frameBufferHeight - (y + height);
-	glViewport(x * contentScale, y * contentScale, width * contentScale, height * contentScale);
-    glScissor(x * contentScale, y * contentScale, width * contentScale, height * contentScale);
+	GLint glX = (GLint)(x * contentScale);
+	GLint glY = (GLint)(y * contentScale);
+	GLint glWidth = (GLint)(width * contentScale);
+	GLint glHeight = (GLint)(height * contentScale);
+	
+	// Only flush pending geometry if the rectangle actually changes; the projection uniform
+	// flushes itself on change.
+	if (!IsGLRectEqual(s_Impl->m_GLState.m_Viewport, glX, glY, glWidth, glHeight) ||
+		!IsGLRectEqual(s_Impl->m_GLState.m_Scissor, glX, glY, glWidth, glHeight))
+		Bacon_Flush();
+	
+	SetGLViewport(glX, glY, glWidth, glHeight);
+	SetGLScissor(glX, glY, glWidth, glHeight);
     
 	vmml::mat4f projection = frustumf(0.f, (float)width, (float)height, 0.f, -1.f, 1.f).compute_ortho_matrix();
 	SetSharedUniformValue(s_Impl->m_ProjectionUniform, projection, sizeof(mat4f));
 	return Bacon_Error_None;
 }
 
+int Graphics_BeginDistanceField(float smoothing)
+{
+	REQUIRE_GL();
+	
+	s_Impl->m_DistanceFieldPreviousShader = s_Impl->m_CurrentShader;
+	Bacon_SetShader(s_Impl->m_DistanceFieldShader);
+	return Bacon_SetShaderUniform(s_Impl->m_DistanceFieldShader, s_Impl->m_DistanceFieldSmoothingUniform, &smoothing, sizeof(float));
+}
+
+int Graphics_EndDistanceField()
+{
+	REQUIRE_GL();
+	
+	return Bacon_SetShader(s_Impl->m_DistanceFieldPreviousShader);
+}
+
 int Bacon_SetShader(int shader)
 {
 	REQUIRE_GL();
@@ -1793,18 +2742,19 @@ static GLuint GetGLBlending(int blend)
 int Bacon_SetBlending(int src, int dest)
 {
 	REQUIRE_GL();
-	Bacon_Flush();
 	
 	GLuint blendSrc = GetGLBlending(src);
 	GLuint blendDest = GetGLBlending(dest);
 	if (!blendSrc || !blendDest)
 		return Bacon_Error_InvalidArgument;
 	
-	if (blendSrc == GL_ONE && blendDest == GL_ZERO)
-		glDisable(GL_BLEND);
-	else
-		glEnable(GL_BLEND);
-	glBlendFunc(blendSrc, blendDest);
+	if (s_Impl->m_CurrentBlendSrc == src && s_Impl->m_CurrentBlendDest == dest)
+		return Bacon_Error_None;
+	
+	Bacon_Flush();
+	s_Impl->m_CurrentBlendSrc = src;
+	s_Impl->m_CurrentBlendDest = dest;
+	SetGLBlending(!(blendSrc == GL_ONE && blendDest == GL_ZERO), blendSrc, blendDest);
 	return Bacon_Error_None;
 }
 
@@ -1899,6 +2849,10 @@ inline int SetCurrentTexture(int textureHandle)
     if (textureHandle == s_Impl->m_CurrentFrameBufferTexture)
         return Bacon_Error_RenderingToSelf;
 	SetSharedUniformValue(s_Impl->m_Texture0Uniform, textureHandle);
+	
+	Texture* texture = s_Impl->m_Textures.Get(textureHandle);
+	float alpha = (texture && (texture->m_Flags & Bacon_ImageFlags_Internal_FormatAlpha)) ? 1.f : 0.f;
+	SetSharedUniformValue(s_Impl->m_Texture0AlphaUniform, &alpha, sizeof(float));
     return Bacon_Error_None;
 }
 
@@ -2066,6 +3020,132 @@ int Bacon_FillRect(float x1, float y1, float x2, float y2)
 	return Bacon_DrawImage(GetBlankImageHandle(), x1, y1, x2, y2);
 }
 
+// Draw sprites on the CPU as regular quads; used when instancing is unavailable or a custom
+// shader is set.
+static void DrawSpritesQuads(Image* image, const float* sprites, int count)
+{
+	for (int i = 0; i < count; ++i, sprites += BACON_SPRITE_FLOAT_COUNT)
+	{
+		float x = sprites[0];
+		float y = sprites[1];
+		float halfWidth = sprites[2] * 0.5f;
+		float halfHeight = sprites[3] * 0.5f;
+		float s = sinf(sprites[4]);
+		float c = cosf(sprites[4]);
+		float u1 = sprites[5];
+		float v1 = 1.f - sprites[6];
+		float u2 = sprites[7];
+		float v2 = 1.f - sprites[8];
+		
+		float z = s_Impl->m_CurrentZ;
+		float positions[] = {
+			x + (-halfWidth * c + halfHeight * s), y + (-halfWidth * s - halfHeight * c), z,
+			x + (-halfWidth * c - halfHeight * s), y + (-halfWidth * s + halfHeight * c), z,
+			x + (halfWidth * c - halfHeight * s), y + (halfWidth * s + halfHeight * c), z,
+			x + (halfWidth * c + halfHeight * s), y + (halfWidth * s - halfHeight * c), z
+		};
+		float texCoords[] = {
+			u1, v1,
+			u1, v2,
+			u2, v2,
+			u2, v1
+		};
+		const float* color = &sprites[9];
+		float colors[] = {
+			color[0], color[1], color[2], color[3],
+			color[0], color[1], color[2], color[3],
+			color[0], color[1], color[2], color[3],
+			color[0], color[1], color[2], color[3],
+		};
+		
+		Graphics_DrawQuad(positions, texCoords, colors, image->m_UVScaleBias);
+	}
+}
+
+static void DrawSpritesInstanced(Image* image, const float* sprites, int count)
+{
+	Bacon_Flush();
+	
+	mat4f const& transform = s_Impl->m_TransformStack.back();
+	vec4f const& color = s_Impl->m_ColorStack.back();
+	Bacon_SetShaderUniform(s_Impl->m_SpriteShader, s_Impl->m_SpriteTransformUniform, &transform, sizeof(mat4f));
+	Bacon_SetShaderUniform(s_Impl->m_SpriteShader, s_Impl->m_SpriteColorUniform, &color, sizeof(vec4f));
+	Bacon_SetShaderUniform(s_Impl->m_SpriteShader, s_Impl->m_SpriteZUniform, &s_Impl->m_CurrentZ, sizeof(float));
+	
+	// Temporarily switch to the sprite shader; the current shader is the default shader
+	int previousShader = s_Impl->m_CurrentShader;
+	s_Impl->m_CurrentShader = s_Impl->m_SpriteShader;
+	BindShader(s_Impl->m_SpriteShader);
+	BindShaderUniforms();
+	BindShaderTextureUnits();
+	
+	glEnableVertexAttribArray(BoundVertexAttribCorner);
+	glEnableVertexAttribArray(BoundVertexAttribInstanceRect);
+	glEnableVertexAttribArray(BoundVertexAttribInstanceTexCoords);
+	glEnableVertexAttribArray(BoundVertexAttribInstanceColor);
+	glEnableVertexAttribArray(BoundVertexAttribInstanceRotation);
+	
+	UVScaleBias const& uvScaleBias = image->m_UVScaleBias;
+	vector<SpriteInstance>& instances = s_Impl->m_SpriteInstances;
+	while (count > 0)
+	{
+		int batchCount = std::min(count, MaxSpriteInstanceCount);
+		instances.resize(batchCount);
+		for (int i = 0; i < batchCount; ++i, sprites += BACON_SPRITE_FLOAT_COUNT)
+		{
+			SpriteInstance& instance = instances[i];
+			vec2f upperLeft = uvScaleBias.Apply(vec2f(sprites[5], 1.f - sprites[6]));
+			vec2f lowerRight = uvScaleBias.Apply(vec2f(sprites[7], 1.f - sprites[8]));
+			instance.m_Rect = vec4f(sprites[0], sprites[1], sprites[2], sprites[3]);
+			instance.m_TexCoords = vec4f(upperLeft.x(), upperLeft.y(), lowerRight.x(), lowerRight.y());
+			instance.m_Color = vec4f(sprites[9], sprites[10], sprites[11], sprites[12]);
+			instance.m_Rotation = sprites[4];
+		}
+		
+		SetGLBuffer(GL_ARRAY_BUFFER, s_Impl->m_SpriteInstanceVBO);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(SpriteInstance) * batchCount, &instances[0]);
+		DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, batchCount);
+		
+		DebugOverlay_AddCounter(s_Impl->m_DebugCounter_DrawCalls, 1);
+		DebugOverlay_AddCounter(s_Impl->m_DebugCounter_Primitives, batchCount * 2);
+		count -= batchCount;
+	}
+	instances.clear();
+	
+	glDisableVertexAttribArray(BoundVertexAttribCorner);
+	glDisableVertexAttribArray(BoundVertexAttribInstanceRect);
+	glDisableVertexAttribArray(BoundVertexAttribInstanceTexCoords);
+	glDisableVertexAttribArray(BoundVertexAttribInstanceColor);
+	glDisableVertexAttribArray(BoundVertexAttribInstanceRotation);
+	
+	s_Impl->m_CurrentShader = previousShader;
+	BindShader(previousShader);
+}
+
+int Bacon_DrawSprites(int imageHandle, const float* sprites, int count)
+{
+	REQUIRE_GL();
+	
+	if ((!sprites && count) || count < 0)
+		return Bacon_Error_InvalidArgument;
+	
+	Image* image = s_Impl->m_Images.Get(imageHandle);
+	if (!image)
+		return Bacon_Error_InvalidHandle;
+	
+	if (int error = SetCurrentImage(image))
+		return error;
+	
+	// Custom shaders expect the regular vertex attributes, so only the default shader is replaced
+	// by the instanced path
+	if (s_Impl->m_SupportsInstancing && s_Impl->m_CurrentShader == s_Impl->m_DefaultShader)
+		DrawSpritesInstanced(image, sprites, count);
+	else
+		DrawSpritesQuads(image, sprites, count);
+	
+	return Bacon_Error_None;
+}
+
 int Bacon_Flush()
 {
 	REQUIRE_GL();
@@ -2076,10 +3156,10 @@ int Bacon_Flush()
 	BindShaderUniforms();
 	BindShaderTextureUnits();
 	
-	glBindBuffer(GL_ARRAY_BUFFER, s_Impl->m_VBO);
+	SetGLBuffer(GL_ARRAY_BUFFER, s_Impl->m_VBO);
 	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertex) * s_Impl->m_Vertices.size(), &s_Impl->m_Vertices[0]);
 	
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_Impl->m_IBO);
+	SetGLBuffer(GL_ELEMENT_ARRAY_BUFFER, s_Impl->m_IBO);
 	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(unsigned short) * s_Impl->m_Indices.size(), &s_Impl->m_Indices[0]);
 	
 	glDrawElements(s_Impl->m_CurrentMode, (int)s_Impl->m_Indices.size(), GL_UNSIGNED_SHORT, 0);
@@ -51,7 +51,6 @@ namespace Bacon {
 				index = m_Free;
 				m_Free = m_Elements[index].m_NextFree;
 				m_Elements[index].m_NextFree = index;
-				new (&m_Elements[index].m_Value) T;
 				++m_Count;
 				return CreateHandle(index);
 			}
@@ -61,7 +60,6 @@ namespace Bacon {
 			
 			index = (int)m_Elements.size();
 			m_Elements.push_back(Element(T(), 0, index));
-			new (&m_Elements[index].m_Value) T;
 			++m_Count;
 			return CreateHandle(index);
 		}
@@ -80,6 +78,10 @@ namespace Bacon {
 			memset(&element.m_Value, 0xdd, sizeof(T));
 			#endif
 			
+			// Free elements still hold a (default-initialized) value, as m_Elements copies and destroys
+			// every element when it reallocates or is destroyed
+			new (&element.m_Value) T;
+			
 			m_Free = index;
 			--m_Count;
 			return true;
@@ -106,7 +108,7 @@ namespace Bacon {
 			{
 				do {
 					++m_Index;
-				} while (m_Index < m_Array.m_Elements.size() &&
+				} while (m_Index < (int)m_Array.m_Elements.size() &&
 						 m_Array.m_Elements[m_Index].m_NextFree != m_Index);
 				return *this;
 			}
@@ -0,0 +1,588 @@
+#include "Bacon.h"
+#include "BaconInternal.h"
+#include "HandleArray.h"
+
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+#include <vector>
+using namespace Bacon;
+using namespace std;
+
+namespace {
+
+	const unsigned int ReplacementCharacter = 0xfffd;
+	
+	// Number of shaped strings kept by the shaping cache
+	const int ShapeCacheCapacity = 256;
+	
+	// Glyphs and kerned advances for a string in a font; cached by ShapeText
+	struct ShapedText
+	{
+		int m_Font;
+		float m_Size;
+		int m_Flags;
+		size_t m_Hash;
+		vector<unsigned int> m_Characters;
+		
+		// Copied, as fonts' glyph maps move when the font array grows
+		vector<Fonts_Glyph> m_Glyphs;
+		
+		// Advance of each glyph including kerning against the next, in glyph pixels
+		vector<int> m_Advances;
+	};
+
+	struct LayoutGlyph
+	{
+		unsigned int m_Character;
+		Fonts_Glyph m_Glyph;
+		float m_Advance;
+	};
+
+	// Range of m_Glyphs; glyphs dropped at a word break (the space) belong to no line
+	struct LayoutLine
+	{
+		int m_Start;
+		int m_End;
+		float m_ContentWidth;
+		float m_X;
+		float m_Y;
+	};
+
+	struct Layout
+	{
+		vector<LayoutGlyph> m_Glyphs;
+		vector<LayoutLine> m_Lines;
+		float m_Ascent;
+		float m_Descent;
+		float m_ContentWidth;
+		float m_ContentHeight;
+		
+		// Scale from glyph pixels to layout units
+		float m_GlyphScale;
+	};
+
+	// Quad of a text block glyph, built by Bacon_SetTextBlockGlyphs in the block's coordinates
+	struct TextBlockGlyph
+	{
+		int m_Image;
+		float m_Positions[12];
+		float m_Colors[16];
+		float m_Smoothing; // Distance field smoothing, or -1 for an ordinary glyph
+	};
+	
+	struct TextBlock
+	{
+		vector<TextBlockGlyph> m_Glyphs;
+	};
+	
+	float TextBlockTexCoords[] = {
+		0, 1,
+		0, 0,
+		1, 0,
+		1, 1
+	};
+
+	// Reused by every call, so that laying out text does not allocate once warm
+	static Layout s_Layout;
+	static vector<unsigned int> s_Characters;
+	static vector<int> s_Kerning;
+	
+	// Least recently used shaped text is at the back
+	static list<ShapedText> s_ShapeCache;
+	static unordered_multimap<size_t, list<ShapedText>::iterator> s_ShapeCacheIndex;
+	
+	static HandleArray<TextBlock> s_TextBlocks;
+
+}
+
+static void DecodeUTF8(const char* text, vector<unsigned int>& outCharacters)
+{
+	outCharacters.clear();
+	const unsigned char* c = (const unsigned char*)text;
+	while (*c)
+	{
+		unsigned int ch = *c++;
+		int continuation = 0;
+		if (ch >= 0xf0 && ch < 0xf8)
+		{
+			ch &= 0x07;
+			continuation = 3;
+		}
+		else if (ch >= 0xe0)
+		{
+			ch &= 0x0f;
+			continuation = 2;
+		}
+		else if (ch >= 0xc0)
+		{
+			ch &= 0x1f;
+			continuation = 1;
+		}
+		else if (ch >= 0x80)
+			ch = ReplacementCharacter;
+
+		for (; continuation; --continuation)
+		{
+			if ((*c & 0xc0) != 0x80)
+			{
+				ch = ReplacementCharacter;
+				break;
+			}
+			ch = (ch << 6) | (*c++ & 0x3f);
+		}
+		outCharacters.push_back(ch);
+	}
+}
+
+static float GetAdvance(Layout const& layout, int start, int end)
+{
+	float advance = 0.f;
+	for (int i = start; i < end; ++i)
+		advance += layout.m_Glyphs[i].m_Advance;
+	return advance;
+}
+
+static void AddLine(Layout& layout, int start, int end)
+{
+	LayoutLine line;
+	line.m_Start = start;
+	line.m_End = end;
+	line.m_ContentWidth = GetAdvance(layout, start, end);
+	line.m_X = 0.f;
+	line.m_Y = 0.f;
+	layout.m_Lines.push_back(line);
+}
+
+// Scans back from the end of [start, end), which overflows width by x, for the last glyph that
+// begins inside the box.  The line ends before that glyph and the next line begins with it.
+static bool FindCharacterBreak(Layout const& layout, int start, int end, float x, float width, int& outLineEnd, int& outNextStart)
+{
+	for (int i = end - 1; i >= start; --i)
+	{
+		x -= layout.m_Glyphs[i].m_Advance;
+		if (x >= width)
+			continue;
+
+		// Always keep at least one glyph on the line
+		if (i == start)
+			++i;
+		outLineEnd = i;
+		outNextStart = i;
+		return true;
+	}
+	return false;
+}
+
+// As FindCharacterBreak, but breaks at the last space (or zero-width space) that begins inside
+// the box, which is dropped.  Falls back to breaking between characters if there is none.
+static bool FindWordBreak(Layout const& layout, int start, int end, float x, float width, int& outLineEnd, int& outNextStart)
+{
+	float startX = x;
+	for (int i = end - 1; i >= start; --i)
+	{
+		x -= layout.m_Glyphs[i].m_Advance;
+		if (x >= width)
+			continue;
+
+		unsigned int ch = layout.m_Glyphs[i].m_Character;
+		if ((ch == ' ' || ch == 0x200b) && i != start)
+		{
+			outLineEnd = i;
+			outNextStart = i + 1;
+			return true;
+		}
+	}
+	return FindCharacterBreak(layout, start, end, startX, width, outLineEnd, outNextStart);
+}
+
+static void BreakLines(Layout& layout, float width, int overflow)
+{
+	int count = (int)layout.m_Glyphs.size();
+	int start = 0;
+	for (;;)
+	{
+		float x = GetAdvance(layout, start, count);
+		int lineEnd;
+		int nextStart;
+		bool broken = false;
+		if (x > width)
+		{
+			if (overflow == Bacon_TextOverflow_Wrap)
+				broken = FindWordBreak(layout, start, count, x, width, lineEnd, nextStart);
+			else
+				broken = FindCharacterBreak(layout, start, count, x, width, lineEnd, nextStart);
+		}
+
+		if (!broken)
+		{
+			AddLine(layout, start, count);
+			return;
+		}
+		AddLine(layout, start, lineEnd);
+		start = nextStart;
+	}
+}
+
+static void PositionLines(Layout& layout, float x, float y, float width, float height, int align, int verticalAlign)
+{
+	if (width >= 0.f)
+	{
+		// Align relative to box, not pivot
+		if (align == Bacon_TextAlignment_Center)
+			x += width / 2;
+		else if (align == Bacon_TextAlignment_Right)
+			x += width;
+	}
+
+	if (height >= 0.f)
+	{
+		// Align relative to box, not pivot
+		if (verticalAlign == Bacon_TextVerticalAlignment_Center)
+			y += height / 2;
+		else if (verticalAlign == Bacon_TextVerticalAlignment_Bottom)
+			y += height;
+		else if (verticalAlign == Bacon_TextVerticalAlignment_Baseline)
+			verticalAlign = Bacon_TextVerticalAlignment_Top;
+	}
+
+	// Align first baseline vertically against pivot
+	if (verticalAlign == Bacon_TextVerticalAlignment_Center)
+		y -= layout.m_ContentHeight / 2;
+	else if (verticalAlign == Bacon_TextVerticalAlignment_Bottom)
+		y -= layout.m_ContentHeight + layout.m_Descent;
+	else if (verticalAlign == Bacon_TextVerticalAlignment_Baseline)
+		y += layout.m_Ascent;
+
+	// Lines start on whole pixels
+	float startX = (float)(int)x;
+	y = (float)(int)y;
+	for (LayoutLine& line : layout.m_Lines)
+	{
+		x = startX;
+		if (align == Bacon_TextAlignment_Center)
+			x -= (float)(int)(line.m_ContentWidth / 2);
+		else if (align == Bacon_TextAlignment_Right)
+			x -= line.m_ContentWidth;
+
+		y -= layout.m_Ascent;
+		line.m_X = x;
+		line.m_Y = y;
+		y += layout.m_Descent;
+	}
+}
+
+static size_t GetShapeHash(int font, float size, int flags, const unsigned int* characters, int count)
+{
+	// FNV-1a
+	size_t hash = 2166136261u;
+	auto combine = [&hash](unsigned int value) { hash = (hash ^ value) * 16777619u; };
+	combine((unsigned int)font);
+	combine((unsigned int)(size * 64));
+	combine((unsigned int)flags);
+	for (int i = 0; i < count; ++i)
+		combine(characters[i]);
+	return hash;
+}
+
+static bool IsShapeMatch(ShapedText const& shaped, int font, float size, int flags, const unsigned int* characters, int count)
+{
+	return shaped.m_Font == font &&
+		shaped.m_Size == size &&
+		shaped.m_Flags == flags &&
+		shaped.m_Characters.size() == (size_t)count &&
+		equal(shaped.m_Characters.begin(), shaped.m_Characters.end(), characters);
+}
+
+static void RemoveShapeCacheIndex(list<ShapedText>::iterator it)
+{
+	auto range = s_ShapeCacheIndex.equal_range(it->m_Hash);
+	for (auto entry = range.first; entry != range.second; ++entry)
+	{
+		if (entry->second == it)
+		{
+			s_ShapeCacheIndex.erase(entry);
+			break;
+		}
+	}
+}
+
+// Looks up glyphs and kerning for the characters, through an LRU cache so that strings drawn every
+// frame cost a hash lookup.  The result is valid until the next call.
+static int ShapeText(int font, float size, int flags, const unsigned int* characters, int count, const ShapedText** outShaped)
+{
+	size_t hash = GetShapeHash(font, size, flags, characters, count);
+	auto range = s_ShapeCacheIndex.equal_range(hash);
+	for (auto entry = range.first; entry != range.second; ++entry)
+	{
+		if (IsShapeMatch(*entry->second, font, size, flags, characters, count))
+		{
+			s_ShapeCache.splice(s_ShapeCache.begin(), s_ShapeCache, entry->second);
+			*outShaped = &s_ShapeCache.front();
+			return Bacon_Error_None;
+		}
+	}
+	
+	// Reuse the least recently used entry once the cache is full
+	if (s_ShapeCache.size() >= (size_t)ShapeCacheCapacity)
+	{
+		auto last = prev(s_ShapeCache.end());
+		RemoveShapeCacheIndex(last);
+		s_ShapeCache.splice(s_ShapeCache.begin(), s_ShapeCache, last);
+	}
+	else
+		s_ShapeCache.push_front(ShapedText());
+	
+	ShapedText& shaped = s_ShapeCache.front();
+	shaped.m_Font = font;
+	shaped.m_Size = size;
+	shaped.m_Flags = flags;
+	shaped.m_Hash = hash;
+	shaped.m_Characters.assign(characters, characters + count);
+	shaped.m_Glyphs.resize(count);
+	shaped.m_Advances.resize(count);
+	
+	s_Kerning.resize(count);
+	int error = Fonts_GetKerning(font, size, flags, characters, count, s_Kerning.data());
+	if (!error)
+		error = Fonts_PrefetchGlyphs(font, size, flags, characters, count);
+	for (int i = 0; i < count && !error; ++i)
+	{
+		const Fonts_Glyph* glyph;
+		error = Fonts_GetGlyph(font, size, flags, characters[i], &glyph);
+		if (!error)
+		{
+			shaped.m_Glyphs[i] = *glyph;
+			shaped.m_Advances[i] = glyph->m_Advance + s_Kerning[i];
+		}
+	}
+	if (error)
+	{
+		s_ShapeCache.pop_front();
+		return error;
+	}
+	
+	s_ShapeCacheIndex.insert(make_pair(hash, s_ShapeCache.begin()));
+	*outShaped = &shaped;
+	return Bacon_Error_None;
+}
+
+void Text_OnFontUnloaded(int font)
+{
+	for (auto it = s_ShapeCache.begin(); it != s_ShapeCache.end(); )
+	{
+		auto next = std::next(it);
+		if (it->m_Font == font)
+		{
+			RemoveShapeCacheIndex(it);
+			s_ShapeCache.erase(it);
+		}
+		it = next;
+	}
+}
+
+static int LayoutText(int font, float size, float contentScale, int fontFlags, const unsigned int* characters, int count,
+					  float x, float y, float width, float height, int align, int verticalAlign, int overflow)
+{
+	if (size <= 0.f || contentScale <= 0.f || count < 0 || (!characters && count))
+		return Bacon_Error_InvalidArgument;
+	if (overflow < Bacon_TextOverflow_None || overflow > Bacon_TextOverflow_WrapCharacters)
+		return Bacon_Error_InvalidArgument;
+
+	Layout& layout = s_Layout;
+	layout.m_Glyphs.resize(count);
+	layout.m_Lines.clear();
+
+	// Metrics are at the logical size; glyphs are rasterized at the backing scale
+	int ascent;
+	int descent;
+	if (int error = Bacon_GetFontMetrics(font, size, &ascent, &descent))
+		return error;
+	layout.m_Ascent = (float)-ascent;
+	layout.m_Descent = (float)-descent;
+
+	// Distance field glyphs are all rasterized at the same size and scaled down
+	float glyphSize = size * contentScale;
+	layout.m_GlyphScale = 1.f / contentScale;
+	if (fontFlags & Bacon_FontFlags_DistanceField)
+	{
+		glyphSize = Fonts_DistanceFieldSize;
+		layout.m_GlyphScale = size / Fonts_DistanceFieldSize;
+	}
+	const ShapedText* shaped;
+	if (int error = ShapeText(font, glyphSize, fontFlags, characters, count, &shaped))
+		return error;
+	for (int i = 0; i < count; ++i)
+	{
+		LayoutGlyph& glyph = layout.m_Glyphs[i];
+		glyph.m_Character = characters[i];
+		glyph.m_Glyph = shaped->m_Glyphs[i];
+		glyph.m_Advance = shaped->m_Advances[i] * layout.m_GlyphScale;
+	}
+
+	float contentWidth = GetAdvance(layout, 0, count);
+	if (width < 0.f || overflow == Bacon_TextOverflow_None || contentWidth <= width)
+		AddLine(layout, 0, count);
+	else
+		BreakLines(layout, width, overflow);
+
+	layout.m_ContentWidth = 0.f;
+	for (LayoutLine const& line : layout.m_Lines)
+		layout.m_ContentWidth = max(layout.m_ContentWidth, line.m_ContentWidth);
+	layout.m_ContentHeight = layout.m_Lines.size() * (layout.m_Descent - layout.m_Ascent);
+
+	PositionLines(layout, x, y, width, height, align, verticalAlign);
+	return Bacon_Error_None;
+}
+
+int Bacon_LayoutText(int font, float size, float contentScale, int fontFlags, const char* text,
+					 float x, float y, float width, float height, int align, int verticalAlign, int overflow,
+					 float* outContentWidth, float* outContentHeight, int* outLineCount)
+{
+	if (!text || !outContentWidth || !outContentHeight || !outLineCount)
+		return Bacon_Error_InvalidArgument;
+
+	DecodeUTF8(text, s_Characters);
+	if (int error = LayoutText(font, size, contentScale, fontFlags, s_Characters.data(), (int)s_Characters.size(),
+							   x, y, width, height, align, verticalAlign, overflow))
+		return error;
+
+	*outContentWidth = s_Layout.m_ContentWidth;
+	*outContentHeight = s_Layout.m_ContentHeight;
+	*outLineCount = (int)s_Layout.m_Lines.size();
+	return Bacon_Error_None;
+}
+
+// Half of one target pixel, in distance field units
+static float GetDistanceFieldSmoothing(float pixelsPerTexel)
+{
+	float texelsPerPixel = 1.f / pixelsPerTexel;
+	return min(texelsPerPixel / (4.f * Fonts_DistanceFieldSpread), 0.5f);
+}
+
+int Text_DrawCharacters(int font, float size, float contentScale, int fontFlags, const unsigned int* characters, int count,
+						float x, float y, float width, float height, int align, int verticalAlign, int overflow)
+{
+	if (int error = LayoutText(font, size, contentScale, fontFlags, characters, count,
+							   x, y, width, height, align, verticalAlign, overflow))
+		return error;
+
+	Layout const& layout = s_Layout;
+	float glyphScale = layout.m_GlyphScale;
+	bool distanceField = (fontFlags & Bacon_FontFlags_DistanceField) != 0;
+	if (distanceField)
+		Graphics_BeginDistanceField(GetDistanceFieldSmoothing(glyphScale * contentScale));
+	
+	for (LayoutLine const& line : layout.m_Lines)
+	{
+		float penX = line.m_X;
+		float penY = line.m_Y;
+		for (int i = line.m_Start; i < line.m_End; ++i)
+		{
+			LayoutGlyph const& glyph = layout.m_Glyphs[i];
+			const Fonts_Glyph* g = &glyph.m_Glyph;
+			if (g->m_Image)
+			{
+				float x1 = penX + g->m_OffsetX * glyphScale;
+				float y1 = penY - g->m_OffsetY * glyphScale;
+				Bacon_DrawImage(g->m_Image, x1, y1, x1 + g->m_Width * glyphScale, y1 + g->m_Height * glyphScale);
+			}
+			penX += glyph.m_Advance;
+		}
+	}
+	
+	if (distanceField)
+		Graphics_EndDistanceField();
+	return Bacon_Error_None;
+}
+
+int Bacon_DrawText(int font, float size, float contentScale, int fontFlags, const char* text,
+				   float x, float y, float width, float height, int align, int verticalAlign, int overflow)
+{
+	if (!text)
+		return Bacon_Error_InvalidArgument;
+
+	DecodeUTF8(text, s_Characters);
+	return Text_DrawCharacters(font, size, contentScale, fontFlags, s_Characters.data(), (int)s_Characters.size(),
+							   x, y, width, height, align, verticalAlign, overflow);
+}
+
+int Bacon_CreateTextBlock(int* outHandle)
+{
+	if (!outHandle)
+		return Bacon_Error_InvalidArgument;
+	
+	*outHandle = s_TextBlocks.Alloc();
+	return Bacon_Error_None;
+}
+
+int Bacon_DestroyTextBlock(int handle)
+{
+	if (!s_TextBlocks.Free(handle))
+		return Bacon_Error_InvalidHandle;
+	return Bacon_Error_None;
+}
+
+int Bacon_SetTextBlockGlyphs(int handle, const int* images, const float* glyphs, int count)
+{
+	if (count < 0 || ((!images || !glyphs) && count))
+		return Bacon_Error_InvalidArgument;
+	
+	TextBlock* block = s_TextBlocks.Get(handle);
+	if (!block)
+		return Bacon_Error_InvalidHandle;
+	
+	// Quads are built once here, so that drawing the block only transforms them
+	block->m_Glyphs.resize(count);
+	for (int i = 0; i < count; ++i, glyphs += BACON_TEXT_BLOCK_GLYPH_FLOAT_COUNT)
+	{
+		TextBlockGlyph& glyph = block->m_Glyphs[i];
+		glyph.m_Image = images[i];
+		
+		float x1 = glyphs[0];
+		float y1 = glyphs[1];
+		float x2 = glyphs[2];
+		float y2 = glyphs[3];
+		float positions[] = {
+			x1, y1, 0.f,
+			x1, y2, 0.f,
+			x2, y2, 0.f,
+			x2, y1, 0.f
+		};
+		copy(positions, positions + 12, glyph.m_Positions);
+		for (int vertex = 0; vertex < 4; ++vertex)
+			copy(glyphs + 4, glyphs + 8, glyph.m_Colors + vertex * 4);
+		glyph.m_Smoothing = glyphs[8] > 0.f ? GetDistanceFieldSmoothing(glyphs[8]) : -1.f;
+	}
+	return Bacon_Error_None;
+}
+
+int Bacon_DrawTextBlock(int handle)
+{
+	TextBlock* block = s_TextBlocks.Get(handle);
+	if (!block)
+		return Bacon_Error_InvalidHandle;
+	
+	// Runs of distance field glyphs are drawn with the distance field shader, switching only where
+	// the font (and so the smoothing) changes
+	int error = Bacon_Error_None;
+	float smoothing = -1.f;
+	for (TextBlockGlyph& glyph : block->m_Glyphs)
+	{
+		if (glyph.m_Smoothing != smoothing)
+		{
+			if (smoothing >= 0.f)
+				Graphics_EndDistanceField();
+			smoothing = glyph.m_Smoothing;
+			if (smoothing >= 0.f)
+				Graphics_BeginDistanceField(smoothing);
+		}
+		
+		if ((error = Bacon_DrawImageQuad(glyph.m_Image, glyph.m_Positions, TextBlockTexCoords, glyph.m_Colors)))
+			break;
+	}
+	
+	if (smoothing >= 0.f)
+		Graphics_EndDistanceField();
+	return error;
+}
@@ -5,6 +5,10 @@
 #include <CoreServices/CoreServices.h>
 #include <mach/mach.h>
 #include <mach/mach_time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 NSWindow* g_Window = nil;
 NSString* g_WindowTitle = @"Bacon";
@@ -125,4 +129,31 @@ int Platform_Run()
 void Platform_Stop()
 {
 	[NSApp terminate:nil];
+}
+
+const void* Platform_MapFile(const char* path, size_t* outSize)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return nullptr;
+	
+	const void* data = nullptr;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		// The mapping outlives the descriptor
+		void* mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (mapped != MAP_FAILED)
+		{
+			data = mapped;
+			*outSize = (size_t)st.st_size;
+		}
+	}
+	close(fd);
+	return data;
+}
+
+void Platform_UnmapFile(const void* data, size_t size)
+{
+	munmap((void*)data, size);
 }
\ No newline at end of file
@@ -397,6 +397,38 @@ void Platform_Stop()
     PostQuitMessage(0);
 }
 
+const void* Platform_MapFile(const char* path, size_t* outSize)
+{
+    WCHAR widePath[MAX_PATH];
+    if (!MultiByteToWideChar(CP_UTF8, 0, path, -1, widePath, MAX_PATH))
+        return nullptr;
+
+    HANDLE file = CreateFileW(widePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    const void* data = nullptr;
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && (unsigned long long)size.QuadPart <= (size_t)-1)
+    {
+        // The view keeps the mapping alive once both handles are closed
+        HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping)
+        {
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        *outSize = (size_t)size.QuadPart;
+    }
+    CloseHandle(file);
+    return data;
+}
+
+void Platform_UnmapFile(const void* data, size_t size)
+{
+    UnmapViewOfFile(data);
+}
+
 static void OnSize(int width, int height)
 {
     if (!IsIconic(g_hWnd))
@@ -0,0 +1,69 @@
+/* Resampler throughput benchmark.
+ *
+ * Mixes a number of voices into a float bus at each resample quality, and at
+ * unity pitch through the non-resampling fast path, and reports the cost per
+ * voice-buffer.  Not part of the library build; from GorillaAudio/ run e.g.:
+ *
+ *   cc -O2 -Iinclude bench/ga_resample_bench.c src/ga_mix.c src/common/gc_common.c -lm -o ga_resample_bench
+ */
+
+#include "gorilla/ga.h"
+#include "gorilla/ga_internal.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_VOICES 64
+#define BENCH_BUFFERS 200
+#define BENCH_SAMPLES 512
+#define BENCH_SOURCE_FRAMES (BENCH_SAMPLES * 4 + GA_RESAMPLE_MAX_TAPS)
+
+static gc_int16 s_source[BENCH_SOURCE_FRAMES * 2];
+static gc_float32 s_bus[BENCH_SAMPLES * 2];
+
+static double benchRun(gc_int32 in_quality, gc_float32 in_pitch)
+{
+  gc_uint64 step = (gc_uint64)((gc_float64)in_pitch * 4294967296.0);
+  clock_t start = clock();
+  gc_int32 b, v;
+  for(b = 0; b < BENCH_BUFFERS; ++b)
+  {
+    memset(s_bus, 0, sizeof(s_bus));
+    for(v = 0; v < BENCH_VOICES; ++v)
+    {
+      if(in_quality < 0)
+        gaX_mix_stereo_s16(s_bus, s_source, BENCH_SAMPLES, 0.5f, 0.5f, 0.0f, 0.0f);
+      else
+        gaX_resample_mix_s16(s_bus, s_source, 2, BENCH_SAMPLES, (gc_uint64)v << 24, step,
+                             in_quality, 0.5f, 0.5f, 0.0f, 0.0f);
+    }
+  }
+  return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main()
+{
+  static const char* names[] = { "linear", "cubic", "polyphase" };
+  gc_float32 pitch = 1.5f;
+  double seconds, bufferSeconds;
+  gc_int32 i, q;
+
+  for(i = 0; i < BENCH_SOURCE_FRAMES; ++i)
+    s_source[i * 2] = s_source[i * 2 + 1] = (gc_int16)(16000 * sin(i * 0.0628));
+  gaX_resample_init();
+
+  bufferSeconds = BENCH_SAMPLES / 44100.0;
+  printf("%d voices x %d buffers of %d frames\n", BENCH_VOICES, BENCH_BUFFERS, BENCH_SAMPLES);
+  seconds = benchRun(-1, 1.0f);
+  printf("%-10s %8.3f us/voice-buffer  %6.0f voices/core\n", "unity",
+         seconds * 1e6 / (BENCH_VOICES * BENCH_BUFFERS), bufferSeconds * BENCH_VOICES * BENCH_BUFFERS / seconds);
+  for(q = GA_RESAMPLE_QUALITY_LINEAR; q <= GA_RESAMPLE_QUALITY_POLYPHASE; ++q)
+  {
+    seconds = benchRun(q, pitch);
+    printf("%-10s %8.3f us/voice-buffer  %6.0f voices/core\n", names[q],
+           seconds * 1e6 / (BENCH_VOICES * BENCH_BUFFERS), bufferSeconds * BENCH_VOICES * BENCH_BUFFERS / seconds);
+  }
+  return 0;
+}
@@ -146,6 +146,58 @@ void gc_mutex_unlock(gc_Mutex* in_mutex);
  */
 void gc_mutex_destroy(gc_Mutex* in_mutex);
 
+/***********/
+/*  Event  */
+/***********/
+/** Event thread synchronization primitive data structure and associated functions.
+ *
+ *  \ingroup common
+ *  \defgroup gc_Event Event
+ */
+
+/** Auto-reset event thread synchronization primitive data structure [\ref SINGLE_CLIENT].
+ *
+ *  An event is either signaled or not. Waiting on a signaled event returns
+ *  immediately and resets it; otherwise the waiting thread sleeps until another
+ *  thread signals the event. Signals do not accumulate.
+ *
+ *  \ingroup gc_Event
+ */
+typedef struct gc_Event {
+  void* event;
+} gc_Event;
+
+/** Creates an event in the non-signaled state.
+ *
+ *  \ingroup gc_Event
+ */
+gc_Event* gc_event_create();
+
+/** Signals an event, waking a thread waiting on it.
+ *
+ *  May be called from any thread.
+ *
+ *  \ingroup gc_Event
+ */
+void gc_event_signal(gc_Event* in_event);
+
+/** Waits for an event to be signaled, then resets it.
+ *
+ *  \ingroup gc_Event
+ *  \param in_event Event to wait on.
+ *  \param in_timeoutMs Maximum time to wait, in milliseconds.
+ *  \return GC_TRUE if the event was signaled. GC_FALSE if the wait timed out.
+ */
+gc_int32 gc_event_wait(gc_Event* in_event, gc_uint32 in_timeoutMs);
+
+/** Destroys an event.
+ *
+ *  \ingroup gc_Event
+ *  \warning Make sure no thread is waiting on the event before destroying it.
+ *  \warning Never use an event after it has been destroyed.
+ */
+void gc_event_destroy(gc_Event* in_event);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,47 @@
+/** WAV File Device Implementation.
+ *
+ *  Writes queued audio to a PCM WAV file, consuming buffers at the rate real hardware would play them
+ *  so that the recording keeps time with the game, or as fast as they are queued when unthrottled.
+ *
+ *  \file ga_file.h
+ */
+
+#ifndef _GORILLA_GA_FILE_H
+#define _GORILLA_GA_FILE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+#include "gorilla/ga_internal.h"
+#include "gorilla/devices/ga_null.h"
+
+#include <stdio.h>
+
+typedef struct ga_DeviceImpl_File
+{
+  GA_DEVICE_HEADER
+  gaX_DeviceClock clock;
+  gc_int32 flags; /* GA_DEVICE_FILE_FLAG_* */
+  FILE* file;
+  gc_uint32 dataSize; /* Bytes of sample data written so far */
+  gc_int32 full; /* Set once the next buffer would overflow the RIFF size fields; later buffers are dropped */
+} ga_DeviceImpl_File;
+
+ga_DeviceImpl_File* gaX_device_open_file(const char* in_filename,
+                                         gc_int32 in_numBuffers,
+                                         gc_int32 in_numSamples,
+                                         ga_Format* in_format,
+                                         gc_int32 in_flags);
+gc_int32 gaX_device_check_file(ga_DeviceImpl_File* in_device);
+gc_int32 gaX_device_wait_file(ga_DeviceImpl_File* in_device, gc_uint32 in_timeoutMs);
+gc_result gaX_device_queue_file(ga_DeviceImpl_File* in_device,
+                                void* in_buffer);
+gc_result gaX_device_close_file(ga_DeviceImpl_File* in_device);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _GORILLA_GA_FILE_H */
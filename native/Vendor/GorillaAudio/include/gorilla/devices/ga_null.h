@@ -0,0 +1,49 @@
+/** Null Device Implementation.
+ *
+ *  Discards all queued audio, consuming buffers at the rate real hardware would play them.
+ *
+ *  \file ga_null.h
+ */
+
+#ifndef _GORILLA_GA_NULL_H
+#define _GORILLA_GA_NULL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+#include "gorilla/ga_internal.h"
+
+/* Wall-clock schedule on which a device with no hardware behind it consumes buffers; shared with the file device */
+typedef struct gaX_DeviceClock
+{
+  gc_int64 startTime; /* Clock time (microseconds) at which the first buffer began playing */
+  gc_int64 numQueued; /* Total number of buffers queued since the first one */
+} gaX_DeviceClock;
+
+void gaX_device_clock_init(gaX_DeviceClock* in_clock);
+gc_int32 gaX_device_clock_check(gaX_DeviceClock* in_clock, ga_Device* in_device);
+gc_int32 gaX_device_clock_wait(gaX_DeviceClock* in_clock, ga_Device* in_device, gc_uint32 in_timeoutMs);
+void gaX_device_clock_queue(gaX_DeviceClock* in_clock);
+
+typedef struct ga_DeviceImpl_Null
+{
+  GA_DEVICE_HEADER
+  gaX_DeviceClock clock;
+} ga_DeviceImpl_Null;
+
+ga_DeviceImpl_Null* gaX_device_open_null(gc_int32 in_numBuffers,
+                                         gc_int32 in_numSamples,
+                                         ga_Format* in_format);
+gc_int32 gaX_device_check_null(ga_DeviceImpl_Null* in_device);
+gc_int32 gaX_device_wait_null(ga_DeviceImpl_Null* in_device, gc_uint32 in_timeoutMs);
+gc_result gaX_device_queue_null(ga_DeviceImpl_Null* in_device,
+                                void* in_buffer);
+gc_result gaX_device_close_null(ga_DeviceImpl_Null* in_device);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _GORILLA_GA_NULL_H */
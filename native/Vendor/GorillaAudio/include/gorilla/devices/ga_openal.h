@@ -28,6 +28,7 @@ ga_DeviceImpl_OpenAl* gaX_device_open_openAl(gc_int32 in_numBuffers,
                                              gc_int32 in_numSamples,
                                              ga_Format* in_format);
 gc_int32 gaX_device_check_openAl(ga_DeviceImpl_OpenAl* in_device);
+gc_int32 gaX_device_wait_openAl(ga_DeviceImpl_OpenAl* in_device, gc_uint32 in_timeoutMs);
 gc_result gaX_device_queue_openAl(ga_DeviceImpl_OpenAl* in_device,
                                   void* in_buffer);
 gc_result gaX_device_close_openAl(ga_DeviceImpl_OpenAl* in_device);
@@ -22,12 +22,15 @@ typedef struct ga_DeviceImpl_XAudio2
   gc_int32 sampleSize;
   gc_uint32 nextBuffer;
   void** buffers;
+  void* callback; /* Voice callback that signals bufferEvent as each buffer finishes */
+  gc_Event* bufferEvent;
 } ga_DeviceImpl_XAudio2;
 
 ga_DeviceImpl_XAudio2* gaX_device_open_xaudio2(gc_int32 in_numBuffers,
                                                gc_int32 in_numSamples,
                                                ga_Format* in_format);
 gc_int32 gaX_device_check_xaudio2(ga_DeviceImpl_XAudio2* in_device);
+gc_int32 gaX_device_wait_xaudio2(ga_DeviceImpl_XAudio2* in_device, gc_uint32 in_timeoutMs);
 gc_result gaX_device_queue_xaudio2(ga_DeviceImpl_XAudio2* in_device,
                                    void* in_buffer);
 gc_result gaX_device_close_xaudio2(ga_DeviceImpl_XAudio2* in_dev);
@@ -179,6 +179,10 @@ gc_int32 ga_format_toSamples(ga_Format* in_format, gc_float32 in_seconds);
 #define GA_DEVICE_TYPE_OPENAL 1 /**< OpenAL playback device (Windows, Linux, Mac) \ingroup ga_Device */
 #define GA_DEVICE_TYPE_DIRECTSOUND 2 /**< DirectSound playback device (Windows-only, disabled) \ingroup ga_Device */
 #define GA_DEVICE_TYPE_XAUDIO2 3 /**< XAudio2 playback device (Windows-only) \ingroup ga_Device */
+#define GA_DEVICE_TYPE_NULL 4 /**< Silent device that consumes buffers in real time (all platforms) \ingroup ga_Device */
+#define GA_DEVICE_TYPE_FILE 5 /**< WAV file writer, opened with ga_device_open_file() (all platforms) \ingroup ga_Device */
+
+#define GA_DEVICE_FILE_FLAG_UNTHROTTLED 1 /**< File device consumes buffers as fast as they are queued instead of in real time \ingroup ga_Device */
 
 /** Hardware device abstract data structure [\ref SINGLE_CLIENT].
  *
@@ -215,6 +219,30 @@ ga_Device* ga_device_open(gc_int32 in_type,
                           gc_int32 in_numSamples,
                           ga_Format* in_format);
 
+/** Opens a device that writes all queued buffers to a WAV file.
+ *
+ *  By default buffers are consumed at the rate the format would play them, like
+ *  GA_DEVICE_TYPE_NULL, so a recording keeps time with the client.  With
+ *  GA_DEVICE_FILE_FLAG_UNTHROTTLED every buffer is free whenever it is checked,
+ *  so audio is mixed as fast as the client queues it (for offline rendering and
+ *  benchmarks; streamed sources may not keep up).  Writing stops once the file
+ *  reaches the 4 GB WAV size limit.  The file is finalized when the device is
+ *  closed.
+ *
+ *  \ingroup ga_Device
+ *  \param in_filename Path of the WAV file to create (overwritten if it exists).
+ *  \param in_numBuffers Requested number of buffers.
+ *  \param in_numSamples Requested sample buffer size.
+ *  \param in_format Format of the PCM data that will be queued and written.
+ *  \param in_flags Bitmask of GA_DEVICE_FILE_FLAG_* values (0 for real-time pacing).
+ *  \return Device of type GA_DEVICE_TYPE_FILE. 0 if the file could not be created.
+ */
+ga_Device* ga_device_open_file(const char* in_filename,
+                               gc_int32 in_numBuffers,
+                               gc_int32 in_numSamples,
+                               ga_Format* in_format,
+                               gc_int32 in_flags);
+
 /** Checks the number of free (unqueued) buffers.
  *
  *  \ingroup ga_Device
@@ -223,6 +251,21 @@ ga_Device* ga_device_open(gc_int32 in_type,
  */
 gc_int32 ga_device_check(ga_Device* in_device);
 
+/** Waits until a device has at least one free (unqueued) buffer.
+ *
+ *  Returns immediately if a buffer is already free. Otherwise the calling thread
+ *  sleeps until the device finishes playing a buffer, so a mix thread can refill
+ *  buffers as soon as they are consumed without polling. The file device, whose
+ *  buffers are always free, instead yields for a few milliseconds so that loops
+ *  built on waiting do not spin.
+ *
+ *  \ingroup ga_Device
+ *  \param in_device Device to wait on.
+ *  \param in_timeoutMs Maximum time to wait, in milliseconds.
+ *  \return Number of free (unqueued) buffers; 0 if the wait timed out.
+ */
+gc_int32 ga_device_wait(ga_Device* in_device, gc_uint32 in_timeoutMs);
+
 /** Adds a buffer to a device's presentation queue.
  *
  *  \ingroup ga_Device
@@ -511,6 +554,31 @@ typedef struct ga_Memory ga_Memory;
  */
 ga_Memory* ga_memory_create(void* in_data, gc_int32 in_size);
 
+/** Memory object release callback.
+ *
+ *  \ingroup ga_Memory
+ *  \param in_data The data buffer passed to ga_memory_create_external().
+ *  \param in_context The user-specified callback context.
+ */
+typedef void (*ga_MemoryFreeFunc)(void* in_data, void* in_context);
+
+/** Create a shared memory object over an external buffer, without copying it.
+ *
+ *  The buffer must remain valid and unchanged until the memory object is 
+ *  destroyed, at which point in_freeFunc (if not null) is called to release
+ *  it. This allows sounds to play directly from memory-mapped files.
+ *  The returned memory object has an initial reference count of 1.
+ *
+ *  \ingroup ga_Memory
+ *  \param in_data Data buffer to be referenced by the memory object.
+ *  \param in_size Size (in bytes) of the provided data buffer.
+ *  \param in_freeFunc Function called to release the buffer, or 0.
+ *  \param in_freeContext Context passed to in_freeFunc.
+ *  \return Newly-allocated memory object, referencing the provided data buffer.
+ */
+ga_Memory* ga_memory_create_external(void* in_data, gc_int32 in_size,
+                                     ga_MemoryFreeFunc in_freeFunc, void* in_freeContext);
+
 /** Create a shared memory object from the full contents of a data source.
  *
  *  The full contents of the data source specified by in_dataSource are copied 
@@ -721,6 +789,27 @@ ga_Format* ga_mixer_format(ga_Mixer* in_mixer);
  */
 gc_int32 ga_mixer_numSamples(ga_Mixer* in_mixer);
 
+/** Resampling qualities, used when a handle's pitch or sample rate differs from the mixer's.
+ *
+ *  \ingroup ga_Mixer
+ *  \defgroup resampleQuality Resample Qualities
+ */
+#define GA_RESAMPLE_QUALITY_LINEAR 0 /**< Linear interpolation (default). \ingroup resampleQuality */
+#define GA_RESAMPLE_QUALITY_CUBIC 1 /**< Catmull-Rom cubic interpolation. \ingroup resampleQuality */
+#define GA_RESAMPLE_QUALITY_POLYPHASE 2 /**< 8-tap windowed-sinc polyphase filter. \ingroup resampleQuality */
+
+/** Sets the quality of resampling used by a mixer.
+ *
+ *  Higher qualities reduce aliasing at the cost of mixing time; handles playing at
+ *  the mixer's sample rate with unity pitch are never resampled.
+ *
+ *  \ingroup ga_Mixer
+ *  \param in_mixer Mixer object whose resample quality should be set.
+ *  \param in_quality Resample quality (see [\ref resampleQuality]).
+ *  \return GC_SUCCESS if the quality was set. GC_ERROR_GENERIC if the quality is not valid.
+ */
+gc_result ga_mixer_setResampleQuality(ga_Mixer* in_mixer, gc_int32 in_quality);
+
 /** Mixes samples from all ready handles into a single output buffer.
  *
  *  The output buffer is generally presented directly to the device queue
@@ -760,6 +849,95 @@ gc_result ga_mixer_dispatch(ga_Mixer* in_mixer);
 gc_result ga_mixer_destroy(ga_Mixer* in_mixer);
 
 
+/**********/
+/*  Bus  */
+/**********/
+/** Submix bus data structure and associated functions.
+ *
+ *  \ingroup external
+ *  \defgroup ga_Bus Bus
+ */
+
+/** Submix bus data structure [\ref SINGLE_CLIENT].
+ *
+ *  A bus sums the handles routed to it (see ga_handle_setBus()) and the buses
+ *  created with it as their parent, applies its filter, gain and ducking once
+ *  per mix, and adds the result into its parent bus or the mixer's output.
+ *
+ *  Buses live until their mixer is destroyed. Changes take effect at the start
+ *  of the next ga_mixer_mix(), like handle parameters.
+ *
+ *  This object may only be used on the main thread.
+ *
+ *  \ingroup ga_Bus
+ */
+typedef struct ga_Bus ga_Bus;
+
+/** Enumerated bus parameter values.
+ *
+ *  \ingroup ga_Bus
+ *  \defgroup busParams Bus Parameters
+ */
+#define GA_BUS_PARAM_UNKNOWN 0 /**< Unknown parameter. \ingroup busParams */
+#define GA_BUS_PARAM_GAIN 1 /**< Gain/volume (silent -> 0.0, normal -> 1.0). Floating-point parameter. \ingroup busParams */
+#define GA_BUS_PARAM_FILTER_CUTOFF 2 /**< Filter cutoff frequency, in Hz (default 1000.0). Floating-point parameter. \ingroup busParams */
+#define GA_BUS_PARAM_FILTER_Q 3 /**< Filter resonance (default 0.707, no peak). Floating-point parameter. \ingroup busParams */
+#define GA_BUS_PARAM_DUCK_GAIN 4 /**< Gain multiplier applied while the duck source is active (default 0.3). Floating-point parameter. \ingroup busParams */
+
+/** Bus filter types.
+ *
+ *  \ingroup ga_Bus
+ *  \defgroup busFilters Bus Filters
+ */
+#define GA_BUS_FILTER_NONE 0 /**< No filtering (default). \ingroup busFilters */
+#define GA_BUS_FILTER_LOWPASS 1 /**< 12 dB/octave low-pass biquad. \ingroup busFilters */
+#define GA_BUS_FILTER_HIGHPASS 2 /**< 12 dB/octave high-pass biquad. \ingroup busFilters */
+
+/** Creates a bus.
+ *
+ *  \ingroup ga_Bus
+ *  \param in_mixer Mixer the bus is mixed by (only stereo mixers are supported).
+ *  \param in_parent Bus to mix into, or 0 to mix into the mixer's output. Must
+ *                   belong to the same mixer.
+ *  \return Newly-created bus, or 0 if the mixer is not stereo or the parent
+ *          belongs to another mixer.
+ */
+ga_Bus* ga_bus_create(ga_Mixer* in_mixer, ga_Bus* in_parent);
+
+/** Sets a floating-point parameter value on a bus.
+ *
+ *  \ingroup ga_Bus
+ *  \param in_bus Bus on which the parameter should be set.
+ *  \param in_param Parameter to set (see \ref busParams).
+ *  \param in_value Value to set.
+ *  \return GC_SUCCESS if the parameter was set. GC_ERROR_GENERIC if the parameter is not valid.
+ */
+gc_result ga_bus_setParamf(ga_Bus* in_bus, gc_int32 in_param, gc_float32 in_value);
+
+/** Sets the filter applied to a bus's summed input.
+ *
+ *  \ingroup ga_Bus
+ *  \param in_bus Bus whose filter should be set.
+ *  \param in_filterType Filter type (see \ref busFilters).
+ *  \return GC_SUCCESS if the filter was set. GC_ERROR_GENERIC if the type is not valid.
+ */
+gc_result ga_bus_setFilter(ga_Bus* in_bus, gc_int32 in_filterType);
+
+/** Ducks a bus while another bus is playing.
+ *
+ *  While the source bus's output level is above -40 dBFS, the bus's gain is
+ *  eased towards GA_BUS_PARAM_DUCK_GAIN (20ms attack, 300ms release). The
+ *  source's level is measured once per mix.
+ *
+ *  \ingroup ga_Bus
+ *  \param in_bus Bus to duck.
+ *  \param in_source Sidechain bus, or 0 to stop ducking. Must belong to the same
+ *                   mixer and not be in_bus.
+ *  \return GC_SUCCESS if the source was set. GC_ERROR_GENERIC if the source is not valid.
+ */
+gc_result ga_bus_setDuckSource(ga_Bus* in_bus, ga_Bus* in_source);
+
+
 /************/
 /*  Handle  */
 /************/
@@ -781,6 +959,10 @@ gc_result ga_mixer_destroy(ga_Mixer* in_mixer);
  *  which are taken into account during the mix. Additionally, each handle
  *  tracks its playback state (playing/stopped/finished).
  *
+ *  Changes to parameters and playback state are passed to the mixer through a
+ *  lock-free queue, and take effect at the start of the next ga_mixer_mix(); the
+ *  mix thread never waits on a lock held by the main thread.
+ *
  *  This object may only be used on the main thread.
  *
  *  \ingroup ga_Handle
@@ -820,8 +1002,9 @@ typedef struct ga_Handle ga_Handle;
  *  \param in_finishedHandle The handle that has finished playback.
  *  \param in_context The user-specified callback context.
  *  \warning This callback is thrown once the handle has finished playback, 
- *           after which the handle can no longer be used except to destroy it.
- *  \todo Allow handles with GA_FLAG_SEEKABLE to be rewound/reused once finished.
+ *           after which the handle can no longer be used except to destroy it
+ *           or restart it with ga_handle_restart(). The callback is cleared
+ *           once thrown, and must be set again for each restart.
  */
 typedef void (*ga_FinishCallback)(ga_Handle* in_finishedHandle, void* in_context);
 
@@ -874,6 +1057,21 @@ gc_result ga_handle_play(ga_Handle* in_handle);
  */
 gc_result ga_handle_stop(ga_Handle* in_handle);
 
+/** Rewinds an audio playback handle to the start of its sample source and plays it.
+ *
+ *  Unlike ga_handle_play(), this may be called on a handle that has finished
+ *  playing, allowing a handle (and its sample source) to be reused instead of
+ *  destroyed and recreated. The rewind is applied by the mixer, in order with
+ *  any other pending changes to the handle.
+ *
+ *  \ingroup ga_Handle
+ *  \param in_handle Handle object to restart.
+ *  \return Whether the handle was restarted successfully. GA_SUCCESS if the
+ *          operation was successful, GA_ERROR_GENERIC if not.
+ *  \warning The handle's sample source must be seekable (GA_FLAG_SEEKABLE).
+ */
+gc_result ga_handle_restart(ga_Handle* in_handle);
+
 /** Checks whether a handle is currently playing.
  *
  *  \ingroup ga_Handle
@@ -984,6 +1182,17 @@ gc_result ga_handle_getParami(ga_Handle* in_handle,
                               gc_int32 in_param,
                               gc_int32* out_value);
 
+/** Routes a handle to a bus.
+ *
+ *  \ingroup ga_Handle
+ *  \param in_handle Handle to route.
+ *  \param in_bus Bus to mix the handle into (must belong to the handle's mixer),
+ *                or 0 to mix it straight into the mixer's output (default).
+ *  \return GC_SUCCESS if the handle was routed. GC_ERROR_GENERIC if the bus
+ *          belongs to another mixer.
+ */
+gc_result ga_handle_setBus(ga_Handle* in_handle, ga_Bus* in_bus);
+
 /** Seek to an offset (in samples) within a handle.
  *
  *  \ingroup ga_Handle
@@ -1063,6 +1272,18 @@ ga_StreamManager* ga_stream_manager_create();
  */
 void ga_stream_manager_buffer(ga_StreamManager* in_mgr);
 
+/** Waits until a managed stream needs filling.
+ *
+ *  Streams signal their manager when a read drops their buffer below its
+ *  low-watermark (half full), when they are seeked, and when they are created.
+ *
+ *  \ingroup ga_StreamManager
+ *  \param in_mgr The buffered-stream manager to wait on.
+ *  \param in_timeoutMs Maximum time to wait, in milliseconds.
+ *  \return GC_TRUE if a stream needs filling. GC_FALSE if the wait timed out.
+ */
+gc_int32 ga_stream_manager_wait(ga_StreamManager* in_mgr, gc_uint32 in_timeoutMs);
+
 /** Destroys a buffered-stream manager.
  *
  *  \ingroup ga_StreamManager
@@ -159,6 +159,8 @@ void ga_sample_source_init(ga_SampleSource* in_sampleSrc);
 struct ga_Memory {
   void* data;
   gc_uint32 size;
+  ga_MemoryFreeFunc freeFunc; /* Releases external data; 0 for data owned by the memory object */
+  void* freeContext;
   gc_int32 refCount;
   gc_Mutex* refMutex;
 };
@@ -184,6 +186,12 @@ struct ga_Sound {
 #define GA_HANDLE_STATE_FINISHED 4
 #define GA_HANDLE_STATE_DESTROYED 5
 
+/* Resampler filter sizes, in source frames */
+#define GA_RESAMPLE_POLYPHASE_TAPS 8
+#define GA_RESAMPLE_POLYPHASE_PHASE_BITS 8
+#define GA_RESAMPLE_POLYPHASE_PHASES (1 << GA_RESAMPLE_POLYPHASE_PHASE_BITS)
+#define GA_RESAMPLE_MAX_TAPS GA_RESAMPLE_POLYPHASE_TAPS
+
 struct ga_Handle {
   ga_Mixer* mixer;
   ga_FinishCallback callback;
@@ -194,33 +202,118 @@ struct ga_Handle {
   gc_float32 pan;
   gc_Link dispatchLink;
   gc_Link mixLink;
-  gc_Mutex* handleMutex;
   ga_SampleSource* sampleSrc;
-  volatile gc_int32 finished;
+  gc_int32 playSerial; /* Play-through counter, bumped by ga_handle_restart() */
+  volatile gc_int32 finished; /* Set by the mix thread to the play-through serial once the sample source has ended */
+  volatile gc_int32 mixReleased; /* Set by the mix thread once it has processed the destroy command */
+  /* Mixer-side copies of the state and parameters above, updated from the command queue (mix thread only) */
+  gc_int32 mixState;
+  gc_int32 mixSerial;
+  gc_float32 mixGain;
+  gc_float32 mixPitch;
+  gc_float32 mixPan;
+  gc_float32 mixGainL; /* Channel gains applied at the end of the last mix (mix thread only); < 0 before the first */
+  gc_float32 mixGainR;
+  ga_Bus* mixBus; /* Bus the handle is mixed into, or 0 for the mixer's output (mix thread only) */
+  /* Resampler state (mix thread only). History holds source frames read but not yet passed by the
+     interpolation window, the first of which is at the fractional position resampleFrac. */
+  gc_uint32 resampleFrac;
+  gc_int32 resampleTaps;
+  gc_int32 resampleHistoryCount;
+  gc_int32 resamplePadding; /* Trailing history frames that are zero padding past the end of the source */
+  gc_int16 resampleHistory[GA_RESAMPLE_MAX_TAPS * 2];
 };
 
 /************/
 /*  Mixer  */
 /************/
+#define GA_MIXER_COMMAND_LINK 0
+#define GA_MIXER_COMMAND_DESTROY 1
+#define GA_MIXER_COMMAND_PLAY 2
+#define GA_MIXER_COMMAND_STOP 3
+#define GA_MIXER_COMMAND_PARAMF 4
+#define GA_MIXER_COMMAND_RESTART 5
+#define GA_MIXER_COMMAND_SET_BUS 6 /* Routes the handle to the command's bus */
+#define GA_MIXER_COMMAND_BUS_LINK 7
+#define GA_MIXER_COMMAND_BUS_PARAMF 8
+#define GA_MIXER_COMMAND_BUS_FILTER 9 /* param is the filter type */
+#define GA_MIXER_COMMAND_BUS_DUCK 10 /* param is the id of the sidechain bus, or 0 for none */
+#define GA_MIXER_COMMAND_SEEK 11 /* Resets the resampler after the source was seeked */
+
+/* Command queue capacity, in bytes (must be a power-of-two) */
+#define GA_MIXER_COMMAND_QUEUE_SIZE 32768
+
+typedef struct ga_MixerCommand {
+  ga_Handle* handle;
+  ga_Bus* bus;
+  gc_int32 type;
+  gc_int32 param;
+  gc_float32 value;
+} ga_MixerCommand;
+
 struct ga_Mixer {
   ga_Format format;
   ga_Format mixFormat;
   gc_int32 numSamples;
-  gc_int32* mixBuffer;
+  gc_float32* mixBuffer; /* Interleaved float mix bus, in 16-bit sample scale */
+  void* scratchBuffer; /* Source samples read for the handle being mixed, reused across handles */
+  gc_int32 scratchSize;
+  volatile gc_int32 resampleQuality;
   gc_Link dispatchList;
   gc_Mutex* dispatchMutex;
-  gc_Link mixList;
-  gc_Mutex* mixMutex;
+  gc_Link mixList; /* Mix thread only */
+  /* Handle commands from the main thread to the mix thread, applied at the start of each mix */
+  gc_CircBuffer* commandQueue;
+  /* Commands that did not fit in the queue, in order (main thread only) */
+  ga_MixerCommand* pendingCommands;
+  gc_int32 numPendingCommands;
+  gc_int32 pendingCommandCapacity;
+  gc_Link busList; /* Mix thread only; newest first, so every bus comes before its parent */
+  ga_Bus* buses; /* All buses, newest first (main thread only; freed with the mixer) */
+  gc_int32 numBuses;
+};
+
+/*********/
+/*  Bus  */
+/*********/
+/* Ducking envelope: a bus ducks while its sidechain's peak is above the threshold (-40 dBFS in
+   16-bit sample scale), moving towards the duck gain with one-pole attack/release times */
+#define GA_BUS_DUCK_THRESHOLD 328.0f
+#define GA_BUS_DUCK_ATTACK_SECONDS 0.02f
+#define GA_BUS_DUCK_RELEASE_SECONDS 0.3f
+
+struct ga_Bus {
+  ga_Mixer* mixer;
+  ga_Bus* parent; /* 0 mixes into the mixer's output */
+  ga_Bus* next; /* Next in the mixer's list of all buses (main thread only) */
+  gc_int32 id;
+  gc_Link mixLink;
+  /* Mixer-side state, updated from the command queue (mix thread only) */
+  gc_float32* buffer; /* Interleaved stereo float samples routed to the bus during the current mix */
+  gc_float32 gain;
+  gc_int32 filterType;
+  gc_float32 filterCutoff;
+  gc_float32 filterQ;
+  gc_int32 filterDirty; /* Coefficients are recomputed on the next mix */
+  gc_float32 filterCoeffs[5]; /* b0, b1, b2, a1, a2 */
+  gc_float32 filterState[4]; /* Two delay elements per channel */
+  ga_Bus* duckSource;
+  gc_float32 duckGain;
+  gc_float32 duckLevel; /* Current duck multiplier (1 when not ducked) */
+  gc_float32 mixGain; /* Total gain applied at the end of the last mix; < 0 before the first */
+  gc_float32 peak; /* Peak output level of the last mix, for buses ducked by this one */
 };
 
 
 struct ga_StreamManager {
   gc_Link streamList;
   gc_Mutex* streamListMutex;
+  gc_Event* bufferEvent; /* Signaled when a stream falls below its low-watermark */
 };
 
 struct ga_BufferedStream {
   gc_Link* streamLink;
+  ga_StreamManager* mgr;
   ga_SampleSource* innerSrc;
   gc_CircBuffer* buffer;
   gc_Mutex* produceMutex;
@@ -238,6 +331,95 @@ struct ga_BufferedStream {
   gc_int32 bufferSize;
 };
 
+/*****************/
+/*  Mix Kernels  */
+/*****************/
+/** Queues a handle command for the mix thread (main thread only; never blocks).
+ *
+ *  \ingroup internal
+ */
+void gaX_mixer_push_command(ga_Mixer* in_mixer, ga_Handle* in_handle, gc_int32 in_type,
+                            gc_int32 in_param, gc_float32 in_value);
+
+/** Queues a bus command (or a handle command that refers to a bus) for the mix thread.
+ *
+ *  \ingroup internal
+ */
+void gaX_mixer_push_bus_command(ga_Mixer* in_mixer, ga_Handle* in_handle, ga_Bus* in_bus,
+                                gc_int32 in_type, gc_int32 in_param, gc_float32 in_value);
+
+/** Accumulates 16-bit stereo samples into a stereo float mix bus, ramping the
+ *  per-channel gains by in_step* per frame (SSE2/AVX2 when available).
+ *
+ *  \ingroup internal
+ */
+void gaX_mix_stereo_s16(gc_float32* io_dst, const gc_int16* in_src, gc_int32 in_numSamples,
+                        gc_float32 in_gainL, gc_float32 in_gainR,
+                        gc_float32 in_stepL, gc_float32 in_stepR);
+
+/** Accumulates 16-bit mono samples into both channels of a stereo float mix bus.
+ *
+ *  \ingroup internal
+ */
+void gaX_mix_mono_s16(gc_float32* io_dst, const gc_int16* in_src, gc_int32 in_numSamples,
+                      gc_float32 in_gainL, gc_float32 in_gainR,
+                      gc_float32 in_stepL, gc_float32 in_stepR);
+
+/** Clamps and converts float mix bus samples to 16-bit samples.
+ *
+ *  \ingroup internal
+ */
+void gaX_mix_convert_s16(gc_int16* out_dst, const gc_float32* in_src, gc_int32 in_count);
+
+/** Computes biquad coefficients (b0, b1, b2, a1, a2) for a bus filter type.
+ *
+ *  \ingroup internal
+ */
+void gaX_bus_filter_coeffs(gc_int32 in_type, gc_float32 in_cutoff, gc_float32 in_q,
+                           gc_int32 in_sampleRate, gc_float32* out_coeffs);
+
+/** Filters a stereo float bus in place, carrying the delay state across buffers.
+ *
+ *  \ingroup internal
+ */
+void gaX_bus_filter(gc_float32* io_buffer, gc_int32 in_numSamples,
+                    const gc_float32* in_coeffs, gc_float32* io_state);
+
+/** Accumulates a stereo float bus into another with a gain ramped by in_step per frame, and
+ *  clears the source bus for the next mix.
+ *
+ *  \ingroup internal
+ *  \return Peak absolute level of the accumulated samples.
+ */
+gc_float32 gaX_bus_accumulate(gc_float32* io_dst, gc_float32* io_src, gc_int32 in_numSamples,
+                              gc_float32 in_gain, gc_float32 in_step);
+
+/** Builds the polyphase filter table; called when a mixer is created.
+ *
+ *  \ingroup internal
+ */
+void gaX_resample_init();
+
+/** Number of source frames in the interpolation window for a resample quality.
+ *
+ *  \ingroup internal
+ */
+gc_int32 gaX_resample_taps(gc_int32 in_quality);
+
+/** Resamples 16-bit mono or stereo frames into a stereo float mix bus.
+ *
+ *  Output frame k interpolates between window frames taps/2-1 and taps/2, where the
+ *  window starts at source frame (in_pos + k * in_step) >> 32 (32.32 fixed point).
+ *
+ *  \ingroup internal
+ *  \return Source position following the last output frame.
+ */
+gc_uint64 gaX_resample_mix_s16(gc_float32* io_dst, const gc_int16* in_src, gc_int32 in_srcChannels,
+                               gc_int32 in_numSamples, gc_uint64 in_pos, gc_uint64 in_step,
+                               gc_int32 in_quality,
+                               gc_float32 in_gainL, gc_float32 in_gainR,
+                               gc_float32 in_stepL, gc_float32 in_stepR);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
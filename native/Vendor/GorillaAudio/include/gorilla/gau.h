@@ -55,12 +55,26 @@ gau_Manager* gau_manager_create();
 /** Creates an audio manager (customizable).
 *
 *  \ingroup gau_Manager
+*  \return The new manager. 0 if the device could not be opened.
 */
 gau_Manager* gau_manager_create_custom(gc_int32 in_devType,
                                        gc_int32 in_threadPolicy,
                                        gc_int32 in_numBuffers,
                                        gc_int32 in_bufferSamples);
 
+/** Creates an audio manager that writes its mixed output to a WAV file.
+*
+*  \ingroup gau_Manager
+*  \param in_fileFlags Bitmask of GA_DEVICE_FILE_FLAG_* values, passed to ga_device_open_file().
+*  \return The new manager. 0 if the file could not be created.
+*  \see ga_device_open_file
+*/
+gau_Manager* gau_manager_create_file(const char* in_filename,
+                                     gc_int32 in_fileFlags,
+                                     gc_int32 in_threadPolicy,
+                                     gc_int32 in_numBuffers,
+                                     gc_int32 in_bufferSamples);
+
 /** Updates an audio manager.
  *
  *  \ingroup gau_Manager
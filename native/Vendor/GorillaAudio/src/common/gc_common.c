@@ -4,6 +4,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define GCX_MEMORY_BARRIER() MemoryBarrier()
+#elif defined(__GNUC__)
+#define GCX_MEMORY_BARRIER() __sync_synchronize()
+#else
+#define GCX_MEMORY_BARRIER()
+#endif
+
 /* System Functions */
 gc_SystemOps* gcX_ops = 0;
 
@@ -49,6 +59,7 @@ gc_CircBuffer* gc_buffer_create(gc_uint32 in_size)
 }
 gc_result gc_buffer_destroy(gc_CircBuffer* in_buffer)
 {
+  gcX_ops->freeFunc(in_buffer->data);
   gcX_ops->freeFunc(in_buffer);
   return GC_SUCCESS;
 }
@@ -109,6 +120,7 @@ gc_result gc_buffer_write(gc_CircBuffer* in_buffer, void* in_data,
     memcpy(&b->data[nextFree], in_data, maxBytes);
     memcpy(&b->data[0], (char*)in_data + maxBytes, in_numBytes - maxBytes);
   }
+  GCX_MEMORY_BARRIER(); /* Data must be visible before the consumer sees it as available */
   b->nextFree += in_numBytes;
   return GC_SUCCESS;
 }
@@ -125,6 +137,7 @@ gc_int32 gc_buffer_getAvail(gc_CircBuffer* in_buffer, gc_uint32 in_numBytes,
   gc_uint32 maxBytes = size - nextAvail;
   if(bytesAvailable < in_numBytes)
     return -1;
+  GCX_MEMORY_BARRIER(); /* Data must not be read before the producer published it */
   if(maxBytes >= in_numBytes)
   {
     *out_dataA = &b->data[nextAvail];
@@ -161,12 +174,14 @@ void gc_buffer_read(gc_CircBuffer* in_buffer, void* in_data,
 void gc_buffer_produce(gc_CircBuffer* in_buffer, gc_uint32 in_numBytes)
 {
   /* producer-only call */
+  GCX_MEMORY_BARRIER();
   in_buffer->nextFree += in_numBytes;
 }
 
 void gc_buffer_consume(gc_CircBuffer* in_buffer, gc_uint32 in_numBytes)
 {
   /* consumer-only call */
+  GCX_MEMORY_BARRIER();
   in_buffer->nextAvail += in_numBytes;
 }
 
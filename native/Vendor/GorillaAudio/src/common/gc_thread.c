@@ -120,10 +120,12 @@ void gc_thread_sleep(gc_uint32 in_ms)
 }
 void gc_thread_destroy(gc_Thread* in_thread)
 {
+  /* The thread must have finished (see gc_thread_join); only its resources are released */
   LinuxThreadData* threadData = (LinuxThreadData*)in_thread->threadObj;
   pthread_mutex_destroy(&threadData->suspendMutex);
-  pthread_exit(&threadData->thread);
   pthread_attr_destroy(&threadData->attr);
+  gcX_ops->freeFunc(threadData);
+  gcX_ops->freeFunc(in_thread);
 }
 
 #else
@@ -188,3 +190,104 @@ void gc_mutex_unlock(gc_Mutex* in_mutex)
 #else
 #error Mutex class not yet defined for this platform
 #endif /* _WIN32 */
+
+/* Event Functions */
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+gc_Event* gc_event_create()
+{
+  gc_Event* ret = gcX_ops->allocFunc(sizeof(gc_Event));
+  ret->event = gcX_ops->allocFunc(sizeof(HANDLE));
+  *(HANDLE*)ret->event = CreateEvent(0, FALSE, FALSE, 0);
+  return ret;
+}
+void gc_event_destroy(gc_Event* in_event)
+{
+  CloseHandle(*(HANDLE*)in_event->event);
+  gcX_ops->freeFunc(in_event->event);
+  gcX_ops->freeFunc(in_event);
+}
+void gc_event_signal(gc_Event* in_event)
+{
+  SetEvent(*(HANDLE*)in_event->event);
+}
+gc_int32 gc_event_wait(gc_Event* in_event, gc_uint32 in_timeoutMs)
+{
+  return WaitForSingleObject(*(HANDLE*)in_event->event, in_timeoutMs) == WAIT_OBJECT_0 ? GC_TRUE : GC_FALSE;
+}
+
+#elif defined(__linux__) || defined(__APPLE__)
+
+#include <pthread.h>
+#include <errno.h>
+#include <sys/time.h>
+
+typedef struct LinuxEventData {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  gc_int32 signaled;
+} LinuxEventData;
+
+gc_Event* gc_event_create()
+{
+  gc_Event* ret = gcX_ops->allocFunc(sizeof(gc_Event));
+  LinuxEventData* eventData = (LinuxEventData*)gcX_ops->allocFunc(sizeof(LinuxEventData));
+  pthread_mutex_init(&eventData->mutex, NULL);
+  pthread_cond_init(&eventData->cond, NULL);
+  eventData->signaled = 0;
+  ret->event = eventData;
+  return ret;
+}
+void gc_event_destroy(gc_Event* in_event)
+{
+  LinuxEventData* eventData = (LinuxEventData*)in_event->event;
+  pthread_cond_destroy(&eventData->cond);
+  pthread_mutex_destroy(&eventData->mutex);
+  gcX_ops->freeFunc(eventData);
+  gcX_ops->freeFunc(in_event);
+}
+void gc_event_signal(gc_Event* in_event)
+{
+  LinuxEventData* eventData = (LinuxEventData*)in_event->event;
+  pthread_mutex_lock(&eventData->mutex);
+  eventData->signaled = 1;
+  pthread_cond_signal(&eventData->cond);
+  pthread_mutex_unlock(&eventData->mutex);
+}
+gc_int32 gc_event_wait(gc_Event* in_event, gc_uint32 in_timeoutMs)
+{
+  LinuxEventData* eventData = (LinuxEventData*)in_event->event;
+  gc_int32 ret;
+  pthread_mutex_lock(&eventData->mutex);
+  if(!eventData->signaled)
+  {
+    /* gettimeofday() rather than clock_gettime(), which older Mac OS X versions lack */
+    struct timeval now;
+    struct timespec deadline;
+    gettimeofday(&now, 0);
+    deadline.tv_sec = now.tv_sec + in_timeoutMs / 1000;
+    deadline.tv_nsec = now.tv_usec * 1000 + (in_timeoutMs % 1000) * 1000000;
+    if(deadline.tv_nsec >= 1000000000)
+    {
+      deadline.tv_sec += 1;
+      deadline.tv_nsec -= 1000000000;
+    }
+    while(!eventData->signaled)
+    {
+      if(pthread_cond_timedwait(&eventData->cond, &eventData->mutex, &deadline) == ETIMEDOUT)
+        break;
+    }
+  }
+  ret = eventData->signaled ? GC_TRUE : GC_FALSE;
+  eventData->signaled = 0;
+  pthread_mutex_unlock(&eventData->mutex);
+  return ret;
+}
+
+#else
+#error Event class not yet defined for this platform
+#endif /* _WIN32 */
@@ -0,0 +1,117 @@
+#include "gorilla/ga.h"
+
+#include "gorilla/devices/ga_file.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#pragma warning(disable:4996)
+#endif /* _WIN32 */
+
+/* Byte offsets of the size fields patched when the file is closed */
+#define GAX_WAV_RIFF_SIZE_OFFSET 4
+#define GAX_WAV_DATA_SIZE_OFFSET 40
+#define GAX_WAV_HEADER_SIZE 44
+
+/* Largest amount of sample data whose RIFF size (data plus header) fits the 32-bit size fields */
+#define GAX_WAV_MAX_DATA_SIZE (0xffffffffu - (GAX_WAV_HEADER_SIZE - 8))
+
+static void gaX_writeUint16(FILE* in_f, gc_uint16 in_value)
+{
+  gc_uint8 bytes[2];
+  bytes[0] = (gc_uint8)(in_value & 0xff);
+  bytes[1] = (gc_uint8)(in_value >> 8);
+  fwrite(bytes, 1, 2, in_f);
+}
+static void gaX_writeUint32(FILE* in_f, gc_uint32 in_value)
+{
+  gc_uint8 bytes[4];
+  bytes[0] = (gc_uint8)(in_value & 0xff);
+  bytes[1] = (gc_uint8)((in_value >> 8) & 0xff);
+  bytes[2] = (gc_uint8)((in_value >> 16) & 0xff);
+  bytes[3] = (gc_uint8)(in_value >> 24);
+  fwrite(bytes, 1, 4, in_f);
+}
+
+ga_DeviceImpl_File* gaX_device_open_file(const char* in_filename,
+                                         gc_int32 in_numBuffers,
+                                         gc_int32 in_numSamples,
+                                         ga_Format* in_format,
+                                         gc_int32 in_flags)
+{
+  ga_DeviceImpl_File* ret;
+  gc_int32 sampleSize = ga_format_sampleSize(in_format);
+  FILE* f = fopen(in_filename, "wb");
+  if(!f)
+    return 0;
+
+  ret = gcX_ops->allocFunc(sizeof(ga_DeviceImpl_File));
+  ret->devType = GA_DEVICE_TYPE_FILE;
+  ret->numBuffers = in_numBuffers;
+  ret->numSamples = in_numSamples;
+  memcpy(&ret->format, in_format, sizeof(ga_Format));
+  gaX_device_clock_init(&ret->clock);
+  ret->flags = in_flags;
+  ret->file = f;
+  ret->dataSize = 0;
+  ret->full = 0;
+
+  /* RIFF/WAVE header; sizes are patched on close */
+  fwrite("RIFF", 1, 4, f);
+  gaX_writeUint32(f, 0);
+  fwrite("WAVE", 1, 4, f);
+  fwrite("fmt ", 1, 4, f);
+  gaX_writeUint32(f, 16);
+  gaX_writeUint16(f, 1); /* PCM */
+  gaX_writeUint16(f, (gc_uint16)in_format->numChannels);
+  gaX_writeUint32(f, (gc_uint32)in_format->sampleRate);
+  gaX_writeUint32(f, (gc_uint32)(in_format->sampleRate * sampleSize));
+  gaX_writeUint16(f, (gc_uint16)sampleSize);
+  gaX_writeUint16(f, (gc_uint16)in_format->bitsPerSample);
+  fwrite("data", 1, 4, f);
+  gaX_writeUint32(f, 0);
+  return ret;
+}
+gc_int32 gaX_device_check_file(ga_DeviceImpl_File* in_device)
+{
+  if(in_device->flags & GA_DEVICE_FILE_FLAG_UNTHROTTLED)
+    return in_device->numBuffers;
+  return gaX_device_clock_check(&in_device->clock, (ga_Device*)in_device);
+}
+gc_int32 gaX_device_wait_file(ga_DeviceImpl_File* in_device, gc_uint32 in_timeoutMs)
+{
+  if(in_device->flags & GA_DEVICE_FILE_FLAG_UNTHROTTLED)
+    return in_device->numBuffers;
+  return gaX_device_clock_wait(&in_device->clock, (ga_Device*)in_device, in_timeoutMs);
+}
+gc_result gaX_device_queue_file(ga_DeviceImpl_File* in_device,
+                                void* in_buffer)
+{
+  ga_DeviceImpl_File* d = in_device;
+  gc_uint32 size = (gc_uint32)(d->numSamples * ga_format_sampleSize(&d->format));
+  gaX_device_clock_queue(&d->clock);
+  if(d->full)
+    return GC_ERROR_GENERIC;
+  if(size > GAX_WAV_MAX_DATA_SIZE - d->dataSize)
+  {
+    fprintf(stderr, "Gorilla: WAV output file reached the 4 GB size limit; no more audio will be recorded\n");
+    d->full = 1;
+    return GC_ERROR_GENERIC;
+  }
+  if(fwrite(in_buffer, 1, size, d->file) != (size_t)size)
+    return GC_ERROR_GENERIC;
+  d->dataSize += size;
+  return GC_SUCCESS;
+}
+gc_result gaX_device_close_file(ga_DeviceImpl_File* in_device)
+{
+  ga_DeviceImpl_File* d = in_device;
+  fseek(d->file, GAX_WAV_RIFF_SIZE_OFFSET, SEEK_SET);
+  gaX_writeUint32(d->file, GAX_WAV_HEADER_SIZE - 8 + d->dataSize);
+  fseek(d->file, GAX_WAV_DATA_SIZE_OFFSET, SEEK_SET);
+  gaX_writeUint32(d->file, d->dataSize);
+  fclose(d->file);
+  gcX_ops->freeFunc(d);
+  return GC_SUCCESS;
+}
@@ -0,0 +1,117 @@
+#include "gorilla/ga.h"
+
+#include "gorilla/devices/ga_null.h"
+
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+static gc_int64 gaX_clockMicroseconds()
+{
+#if defined(_WIN32)
+  LARGE_INTEGER freq;
+  LARGE_INTEGER counter;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&counter);
+  return (gc_int64)(counter.QuadPart / freq.QuadPart) * 1000000 +
+         (gc_int64)(counter.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+#elif defined(__APPLE__)
+  static mach_timebase_info_data_t timebase;
+  if(timebase.denom == 0)
+    mach_timebase_info(&timebase);
+  return (gc_int64)(mach_absolute_time() * timebase.numer / timebase.denom / 1000);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (gc_int64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+void gaX_device_clock_init(gaX_DeviceClock* in_clock)
+{
+  in_clock->startTime = 0;
+  in_clock->numQueued = 0;
+}
+gc_int32 gaX_device_clock_check(gaX_DeviceClock* in_clock, ga_Device* in_device)
+{
+  gaX_DeviceClock* c = in_clock;
+  ga_Device* d = in_device;
+  gc_int64 elapsedSamples;
+  gc_int64 numPlayed;
+  gc_int64 numPending;
+  if(c->numQueued == 0)
+    return d->numBuffers;
+  elapsedSamples = (gaX_clockMicroseconds() - c->startTime) * d->format.sampleRate / 1000000;
+  numPlayed = elapsedSamples / d->numSamples;
+  numPending = c->numQueued - numPlayed;
+  if(numPending <= 0)
+  {
+    /* Fell behind (underrun); restart the clock rather than letting the mixer catch up */
+    c->numQueued = 0;
+    return d->numBuffers;
+  }
+  return numPending >= d->numBuffers ? 0 : (gc_int32)(d->numBuffers - numPending);
+}
+gc_int32 gaX_device_clock_wait(gaX_DeviceClock* in_clock, ga_Device* in_device, gc_uint32 in_timeoutMs)
+{
+  gaX_DeviceClock* c = in_clock;
+  ga_Device* d = in_device;
+  gc_int64 nextFreeTime;
+  gc_int64 waitTime;
+  gc_int32 numFree = gaX_device_clock_check(c, d);
+  if(numFree)
+    return numFree;
+  /* The oldest pending buffer finishes playing once numQueued - numBuffers + 1 buffers have played */
+  nextFreeTime = c->startTime + (c->numQueued - d->numBuffers + 1) * d->numSamples * 1000000 / d->format.sampleRate;
+  waitTime = nextFreeTime - gaX_clockMicroseconds();
+  if(waitTime > (gc_int64)in_timeoutMs * 1000)
+    waitTime = (gc_int64)in_timeoutMs * 1000;
+  if(waitTime > 0)
+    gc_thread_sleep((gc_uint32)((waitTime + 999) / 1000));
+  return gaX_device_clock_check(c, d);
+}
+void gaX_device_clock_queue(gaX_DeviceClock* in_clock)
+{
+  if(in_clock->numQueued == 0)
+    in_clock->startTime = gaX_clockMicroseconds();
+  ++in_clock->numQueued;
+}
+
+ga_DeviceImpl_Null* gaX_device_open_null(gc_int32 in_numBuffers,
+                                         gc_int32 in_numSamples,
+                                         ga_Format* in_format)
+{
+  ga_DeviceImpl_Null* ret = gcX_ops->allocFunc(sizeof(ga_DeviceImpl_Null));
+  ret->devType = GA_DEVICE_TYPE_NULL;
+  ret->numBuffers = in_numBuffers;
+  ret->numSamples = in_numSamples;
+  memcpy(&ret->format, in_format, sizeof(ga_Format));
+  gaX_device_clock_init(&ret->clock);
+  return ret;
+}
+gc_int32 gaX_device_check_null(ga_DeviceImpl_Null* in_device)
+{
+  return gaX_device_clock_check(&in_device->clock, (ga_Device*)in_device);
+}
+gc_int32 gaX_device_wait_null(ga_DeviceImpl_Null* in_device, gc_uint32 in_timeoutMs)
+{
+  return gaX_device_clock_wait(&in_device->clock, (ga_Device*)in_device, in_timeoutMs);
+}
+gc_result gaX_device_queue_null(ga_DeviceImpl_Null* in_device,
+                                void* in_buffer)
+{
+  gaX_device_clock_queue(&in_device->clock);
+  return GC_SUCCESS;
+}
+gc_result gaX_device_close_null(ga_DeviceImpl_Null* in_device)
+{
+  gcX_ops->freeFunc(in_device);
+  return GC_SUCCESS;
+}
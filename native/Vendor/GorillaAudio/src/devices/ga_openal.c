@@ -117,6 +117,22 @@ gc_int32 gaX_device_check_openAl(ga_DeviceImpl_OpenAl* in_device)
   }
   return d->emptyBuffers;
 }
+gc_int32 gaX_device_wait_openAl(ga_DeviceImpl_OpenAl* in_device, gc_uint32 in_timeoutMs)
+{
+  /* OpenAL has no buffer-completion notification, so poll a few times per buffer duration */
+  ga_DeviceImpl_OpenAl* d = in_device;
+  gc_uint32 pollMs = d->numSamples * 1000 / d->format.sampleRate / 4;
+  gc_uint32 waited = 0;
+  gc_int32 numFree = gaX_device_check_openAl(d);
+  pollMs = pollMs > 0 ? pollMs : 1;
+  while(!numFree && waited < in_timeoutMs)
+  {
+    gc_thread_sleep(pollMs);
+    waited += pollMs;
+    numFree = gaX_device_check_openAl(d);
+  }
+  return numFree;
+}
 gc_result gaX_device_queue_openAl(ga_DeviceImpl_OpenAl* in_device,
                                   void* in_buffer)
 {
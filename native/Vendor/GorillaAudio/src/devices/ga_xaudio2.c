@@ -10,6 +10,33 @@
 #include <stdio.h>
 #include <assert.h>
 
+/* Voice callback (C-style COM object); only OnBufferEnd does anything */
+typedef struct gaX_XAudio2Callback {
+  IXAudio2VoiceCallback base;
+  gc_Event* bufferEvent;
+} gaX_XAudio2Callback;
+
+static void STDMETHODCALLTYPE gaX_xaudio2_onVoiceProcessingPassStart(IXAudio2VoiceCallback* in_this, UINT32 in_bytesRequired) {}
+static void STDMETHODCALLTYPE gaX_xaudio2_onVoiceProcessingPassEnd(IXAudio2VoiceCallback* in_this) {}
+static void STDMETHODCALLTYPE gaX_xaudio2_onStreamEnd(IXAudio2VoiceCallback* in_this) {}
+static void STDMETHODCALLTYPE gaX_xaudio2_onBufferStart(IXAudio2VoiceCallback* in_this, void* in_context) {}
+static void STDMETHODCALLTYPE gaX_xaudio2_onBufferEnd(IXAudio2VoiceCallback* in_this, void* in_context)
+{
+  gc_event_signal(((gaX_XAudio2Callback*)in_this)->bufferEvent);
+}
+static void STDMETHODCALLTYPE gaX_xaudio2_onLoopEnd(IXAudio2VoiceCallback* in_this, void* in_context) {}
+static void STDMETHODCALLTYPE gaX_xaudio2_onVoiceError(IXAudio2VoiceCallback* in_this, void* in_context, HRESULT in_error) {}
+
+static IXAudio2VoiceCallbackVtbl gaX_xaudio2_callbackVtbl = {
+  gaX_xaudio2_onVoiceProcessingPassStart,
+  gaX_xaudio2_onVoiceProcessingPassEnd,
+  gaX_xaudio2_onStreamEnd,
+  gaX_xaudio2_onBufferStart,
+  gaX_xaudio2_onBufferEnd,
+  gaX_xaudio2_onLoopEnd,
+  gaX_xaudio2_onVoiceError
+};
+
 ga_DeviceImpl_XAudio2* gaX_device_open_xaudio2(gc_int32 in_numBuffers, gc_int32 in_numSamples, ga_Format* in_format)
 {
   ga_DeviceImpl_XAudio2* ret = gcX_ops->allocFunc(sizeof(ga_DeviceImpl_XAudio2));
@@ -24,6 +51,11 @@ ga_DeviceImpl_XAudio2* gaX_device_open_xaudio2(gc_int32 in_numBuffers, gc_int32
   ret->nextBuffer = 0;
   ret->xa = 0;
   ret->master = 0;
+  ret->source = 0;
+  ret->bufferEvent = gc_event_create();
+  ret->callback = gcX_ops->allocFunc(sizeof(gaX_XAudio2Callback));
+  ((gaX_XAudio2Callback*)ret->callback)->base.lpVtbl = &gaX_xaudio2_callbackVtbl;
+  ((gaX_XAudio2Callback*)ret->callback)->bufferEvent = ret->bufferEvent;
 
   CoInitializeEx(NULL, COINIT_MULTITHREADED);
   result = XAudio2Create(&ret->xa, 0, XAUDIO2_DEFAULT_PROCESSOR);
@@ -44,7 +76,8 @@ ga_DeviceImpl_XAudio2* gaX_device_open_xaudio2(gc_int32 in_numBuffers, gc_int32
   fmt.nBlockAlign = fmt.nChannels * (fmt.wBitsPerSample / 8);
   fmt.nAvgBytesPerSec = fmt.nSamplesPerSec * fmt.nBlockAlign;
 
-  result = IXAudio2_CreateSourceVoice(ret->xa, &ret->source, &fmt, XAUDIO2_VOICE_NOPITCH, XAUDIO2_DEFAULT_FREQ_RATIO, 0, 0, 0);
+  result = IXAudio2_CreateSourceVoice(ret->xa, &ret->source, &fmt, XAUDIO2_VOICE_NOPITCH, XAUDIO2_DEFAULT_FREQ_RATIO,
+                                      (IXAudio2VoiceCallback*)ret->callback, 0, 0);
   if(FAILED(result))
     goto cleanup;
 
@@ -76,6 +109,8 @@ cleanup:
   if(ret->xa)
     IXAudio2_Release(ret->xa);
   CoUninitialize();
+  gc_event_destroy(ret->bufferEvent);
+  gcX_ops->freeFunc(ret->callback);
   gcX_ops->freeFunc(ret);
   return 0;
 }
@@ -98,6 +133,8 @@ gc_result gaX_device_close_xaudio2(ga_DeviceImpl_XAudio2* in_device)
 
   for(i = 0; i < in_device->numBuffers; ++i)
     gcX_ops->freeFunc(in_device->buffers[i]);
+  gc_event_destroy(in_device->bufferEvent);
+  gcX_ops->freeFunc(in_device->callback);
   in_device->devType = GA_DEVICE_TYPE_UNKNOWN;
   in_device->source = 0;
   in_device->master = 0;
@@ -113,6 +150,15 @@ gc_int32 gaX_device_check_xaudio2(ga_DeviceImpl_XAudio2* in_device)
   ret = in_device->numBuffers - state.BuffersQueued;
   return ret;
 }
+gc_int32 gaX_device_wait_xaudio2(ga_DeviceImpl_XAudio2* in_device, gc_uint32 in_timeoutMs)
+{
+  /* A buffer ending after the check leaves the event signaled, so the wakeup is never missed */
+  gc_int32 numFree = gaX_device_check_xaudio2(in_device);
+  if(numFree)
+    return numFree;
+  gc_event_wait(in_device->bufferEvent, in_timeoutMs);
+  return gaX_device_check_xaudio2(in_device);
+}
 gc_result gaX_device_queue_xaudio2(ga_DeviceImpl_XAudio2* in_device,
                                    void* in_buffer)
 {
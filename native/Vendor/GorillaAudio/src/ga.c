@@ -13,9 +13,13 @@
 #include "gorilla/devices/ga_xaudio2.h"
 #endif /* ENABLE_XAUDIO2 */
 
+#include "gorilla/devices/ga_null.h"
+#include "gorilla/devices/ga_file.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <assert.h>
 
 /* Version Functions */
@@ -91,9 +95,19 @@ ga_Device* ga_device_open(gc_int32 in_type,
     return 0;
 #endif /* ENABLE_XAUDIO2 */
   }
+  else if(in_type == GA_DEVICE_TYPE_NULL)
+    return (ga_Device*)gaX_device_open_null(in_numBuffers, in_numSamples, in_format);
   else
     return 0;
 }
+ga_Device* ga_device_open_file(const char* in_filename,
+                               gc_int32 in_numBuffers,
+                               gc_int32 in_numSamples,
+                               ga_Format* in_format,
+                               gc_int32 in_flags)
+{
+  return (ga_Device*)gaX_device_open_file(in_filename, in_numBuffers, in_numSamples, in_format, in_flags);
+}
 gc_result ga_device_close(ga_Device* in_device)
 {
   if(in_device->devType == GA_DEVICE_TYPE_OPENAL)
@@ -126,6 +140,10 @@ gc_result ga_device_close(ga_Device* in_device)
     return 0;
 #endif /* ENABLE_XAUDIO2 */
   }
+  else if(in_device->devType == GA_DEVICE_TYPE_NULL)
+    return gaX_device_close_null((ga_DeviceImpl_Null*)in_device);
+  else if(in_device->devType == GA_DEVICE_TYPE_FILE)
+    return gaX_device_close_file((ga_DeviceImpl_File*)in_device);
   return GC_ERROR_GENERIC;
 }
 gc_int32 ga_device_check(ga_Device* in_device)
@@ -157,8 +175,38 @@ gc_int32 ga_device_check(ga_Device* in_device)
     return GC_ERROR_GENERIC;
 #endif /* ENABLE_XAUDIO2 */
   }
+  else if(in_device->devType == GA_DEVICE_TYPE_NULL)
+    return gaX_device_check_null((ga_DeviceImpl_Null*)in_device);
+  else if(in_device->devType == GA_DEVICE_TYPE_FILE)
+    return gaX_device_check_file((ga_DeviceImpl_File*)in_device);
   return GC_ERROR_GENERIC;
 }
+gc_int32 ga_device_wait(ga_Device* in_device, gc_uint32 in_timeoutMs)
+{
+  if(in_device->devType == GA_DEVICE_TYPE_OPENAL)
+  {
+#ifdef ENABLE_OPENAL
+    ga_DeviceImpl_OpenAl* dev = (ga_DeviceImpl_OpenAl*)in_device;
+    return gaX_device_wait_openAl(dev, in_timeoutMs);
+#else
+    return GC_ERROR_GENERIC;
+#endif /* ENABLE_OPENAL */
+  }
+  else if(in_device->devType == GA_DEVICE_TYPE_XAUDIO2)
+  {
+#ifdef ENABLE_XAUDIO2
+    ga_DeviceImpl_XAudio2* dev = (ga_DeviceImpl_XAudio2*)in_device;
+    return gaX_device_wait_xaudio2(dev, in_timeoutMs);
+#else
+    return GC_ERROR_GENERIC;
+#endif /* ENABLE_XAUDIO2 */
+  }
+  else if(in_device->devType == GA_DEVICE_TYPE_NULL)
+    return gaX_device_wait_null((ga_DeviceImpl_Null*)in_device, in_timeoutMs);
+  else if(in_device->devType == GA_DEVICE_TYPE_FILE)
+    return gaX_device_wait_file((ga_DeviceImpl_File*)in_device, in_timeoutMs);
+  return ga_device_check(in_device);
+}
 gc_result ga_device_queue(ga_Device* in_device,
                           void* in_buffer)
 {
@@ -189,6 +237,10 @@ gc_result ga_device_queue(ga_Device* in_device,
     return GC_ERROR_GENERIC;
 #endif /* ENABLE_XAUDIO2 */
   }
+  else if(in_device->devType == GA_DEVICE_TYPE_NULL)
+    return gaX_device_queue_null((ga_DeviceImpl_Null*)in_device, in_buffer);
+  else if(in_device->devType == GA_DEVICE_TYPE_FILE)
+    return gaX_device_queue_file((ga_DeviceImpl_File*)in_device, in_buffer);
   return GC_ERROR_GENERIC;
 }
 
@@ -353,6 +405,8 @@ static ga_Memory* gaX_memory_create(void* in_data, gc_int32 in_size, gc_int32 in
   }
   else
     ret->data = in_data;
+  ret->freeFunc = 0;
+  ret->freeContext = 0;
   ret->refMutex = gc_mutex_create();
   ret->refCount = 1;
   return (ga_Memory*)ret;
@@ -361,6 +415,14 @@ ga_Memory* ga_memory_create(void* in_data, gc_int32 in_size)
 {
   return gaX_memory_create(in_data, in_size, 1);
 }
+ga_Memory* ga_memory_create_external(void* in_data, gc_int32 in_size,
+                                     ga_MemoryFreeFunc in_freeFunc, void* in_freeContext)
+{
+  ga_Memory* ret = gaX_memory_create(in_data, in_size, 0);
+  ret->freeFunc = in_freeFunc;
+  ret->freeContext = in_freeContext;
+  return ret;
+}
 ga_Memory* ga_memory_create_data_source(ga_DataSource* in_dataSource)
 {
   ga_Memory* ret = 0;
@@ -391,7 +453,11 @@ void* ga_memory_data(ga_Memory* in_mem)
 }
 static void gaX_memory_destroy(ga_Memory* in_mem)
 {
-  gcX_ops->freeFunc(in_mem->data);
+  if(in_mem->freeFunc)
+    in_mem->freeFunc(in_mem->data, in_mem->freeContext);
+  else
+    gcX_ops->freeFunc(in_mem->data);
+  gc_mutex_destroy(in_mem->refMutex);
   gcX_ops->freeFunc(in_mem);
 }
 void ga_memory_acquire(ga_Memory* in_mem)
@@ -534,7 +600,24 @@ void gaX_handle_init(ga_Handle* in_handle, ga_Mixer* in_mixer)
   h->gain = 1.0f;
   h->pitch = 1.0f;
   h->pan = 0.0f;
-  h->handleMutex = gc_mutex_create();
+  h->mixGainL = -1.0f;
+  h->mixGainR = -1.0f;
+  h->resampleFrac = 0;
+  h->resampleTaps = 0;
+  h->resampleHistoryCount = 0;
+  h->resamplePadding = 0;
+  h->playSerial = 1;
+  h->finished = 0;
+  h->mixReleased = 0;
+  h->mixState = GA_HANDLE_STATE_INITIAL;
+  h->mixSerial = 1;
+  h->mixGain = h->gain;
+  h->mixPitch = h->pitch;
+  h->mixPan = h->pan;
+  h->mixBus = 0;
+  h->mixLink.next = 0;
+  h->mixLink.prev = 0;
+  h->mixLink.data = 0;
 }
 
 ga_Handle* ga_handle_create(ga_Mixer* in_mixer,
@@ -543,12 +626,9 @@ ga_Handle* ga_handle_create(ga_Mixer* in_mixer,
   ga_Handle* h = (ga_Handle*)gcX_ops->allocFunc(sizeof(ga_Handle));
   ga_sample_source_acquire(in_sampleSrc);
   h->sampleSrc = in_sampleSrc;
-  h->finished = 0;
   gaX_handle_init(h, in_mixer);
 
-  gc_mutex_lock(in_mixer->mixMutex);
-  gc_list_link(&in_mixer->mixList, &h->mixLink, h);
-  gc_mutex_unlock(in_mixer->mixMutex);
+  gaX_mixer_push_command(in_mixer, h, GA_MIXER_COMMAND_LINK, 0, 0.0f);
 
   gc_mutex_lock(in_mixer->dispatchMutex);
   gc_list_link(&in_mixer->dispatchList, &h->dispatchLink, h);
@@ -558,10 +638,9 @@ ga_Handle* ga_handle_create(ga_Mixer* in_mixer,
 }
 gc_result ga_handle_destroy(ga_Handle* in_handle)
 {
-  /* Sets the destroyed state. Will be cleaned up once all threads ACK. */
-  gc_mutex_lock(in_handle->handleMutex);
+  /* Sets the destroyed state. Will be cleaned up once the mix thread ACKs. */
   in_handle->state = GA_HANDLE_STATE_DESTROYED;
-  gc_mutex_unlock(in_handle->handleMutex);
+  gaX_mixer_push_command(in_handle->mixer, in_handle, GA_MIXER_COMMAND_DESTROY, 0, 0.0f);
   return GC_SUCCESS;
 }
 gc_result gaX_handle_cleanup(ga_Handle* in_handle)
@@ -574,39 +653,43 @@ gc_result gaX_handle_cleanup(ga_Handle* in_handle)
 
 gc_result ga_handle_play(ga_Handle* in_handle)
 {
-  gc_mutex_lock(in_handle->handleMutex);
-  if(in_handle->state >= GA_HANDLE_STATE_FINISHED)
-  {
-    gc_mutex_unlock(in_handle->handleMutex);
+  if(ga_handle_finished(in_handle))
     return GC_ERROR_GENERIC;
-  }
   in_handle->state = GA_HANDLE_STATE_PLAYING;
-  gc_mutex_unlock(in_handle->handleMutex);
+  gaX_mixer_push_command(in_handle->mixer, in_handle, GA_MIXER_COMMAND_PLAY, 0, 0.0f);
   return GC_SUCCESS;
 }
 gc_result ga_handle_stop(ga_Handle* in_handle)
 {
-  gc_mutex_lock(in_handle->handleMutex);
-  if(in_handle->state >= GA_HANDLE_STATE_FINISHED)
-  {
-    gc_mutex_unlock(in_handle->handleMutex);
+  if(ga_handle_finished(in_handle))
     return GC_ERROR_GENERIC;
-  }
   in_handle->state = GA_HANDLE_STATE_STOPPED;
-  gc_mutex_unlock(in_handle->handleMutex);
+  gaX_mixer_push_command(in_handle->mixer, in_handle, GA_MIXER_COMMAND_STOP, 0, 0.0f);
+  return GC_SUCCESS;
+}
+gc_result ga_handle_restart(ga_Handle* in_handle)
+{
+  ga_Handle* h = in_handle;
+  if(ga_handle_destroyed(h) || !(ga_sample_source_flags(h->sampleSrc) & GA_FLAG_SEEKABLE))
+    return GC_ERROR_GENERIC;
+  /* The mix thread seeks the source and relinks the handle; an end flagged for the
+     previous play-through no longer matches the new serial */
+  ++h->playSerial;
+  h->state = GA_HANDLE_STATE_PLAYING;
+  gaX_mixer_push_command(h->mixer, h, GA_MIXER_COMMAND_RESTART, h->playSerial, 0.0f);
   return GC_SUCCESS;
 }
 gc_int32 ga_handle_playing(ga_Handle* in_handle)
 {
-  return in_handle->state == GA_HANDLE_STATE_PLAYING ? GC_TRUE : GC_FALSE;
+  return in_handle->state == GA_HANDLE_STATE_PLAYING && in_handle->finished != in_handle->playSerial ? GC_TRUE : GC_FALSE;
 }
 gc_int32 ga_handle_stopped(ga_Handle* in_handle)
 {
-  return in_handle->state == GA_HANDLE_STATE_STOPPED ? GC_TRUE : GC_FALSE;
+  return in_handle->state == GA_HANDLE_STATE_STOPPED && in_handle->finished != in_handle->playSerial ? GC_TRUE : GC_FALSE;
 }
 gc_int32 ga_handle_finished(ga_Handle* in_handle)
 {
-  return in_handle->state >= GA_HANDLE_STATE_FINISHED ? GC_TRUE : GC_FALSE;
+  return in_handle->state >= GA_HANDLE_STATE_FINISHED || in_handle->finished == in_handle->playSerial ? GC_TRUE : GC_FALSE;
 }
 gc_int32 ga_handle_destroyed(ga_Handle* in_handle)
 {
@@ -625,23 +708,13 @@ gc_result ga_handle_setParamf(ga_Handle* in_handle, gc_int32 in_param,
   ga_Handle* h = in_handle;
   switch(in_param)
   {
-  case GA_HANDLE_PARAM_GAIN:
-    gc_mutex_lock(h->handleMutex);
-    h->gain = in_value;
-    gc_mutex_unlock(h->handleMutex);
-    return GC_SUCCESS;
-  case GA_HANDLE_PARAM_PAN:
-    gc_mutex_lock(h->handleMutex);
-    h->pan = in_value;
-    gc_mutex_unlock(h->handleMutex);
-    return GC_SUCCESS;
-  case GA_HANDLE_PARAM_PITCH:
-    gc_mutex_lock(h->handleMutex);
-    h->pitch = in_value;
-    gc_mutex_unlock(h->handleMutex);
-    return GC_SUCCESS;
+  case GA_HANDLE_PARAM_GAIN: h->gain = in_value; break;
+  case GA_HANDLE_PARAM_PAN: h->pan = in_value; break;
+  case GA_HANDLE_PARAM_PITCH: h->pitch = in_value; break;
+  default: return GC_ERROR_GENERIC;
   }
-  return GC_ERROR_GENERIC;
+  gaX_mixer_push_command(h->mixer, h, GA_MIXER_COMMAND_PARAMF, in_param, in_value);
+  return GC_SUCCESS;
 }
 gc_result ga_handle_getParamf(ga_Handle* in_handle, gc_int32 in_param,
                               gc_float32* out_value)
@@ -663,8 +736,7 @@ gc_result ga_handle_setParami(ga_Handle* in_handle, gc_int32 in_param,
   switch(in_param)
   {
   case GA_HANDLE_PARAM_?:
-    gc_mutex_lock(h->handleMutex);
-    gc_mutex_unlock(h->handleMutex);
+    gaX_mixer_push_command(h->mixer, h, GA_MIXER_COMMAND_PARAMI, in_param, in_value);
     return GC_SUCCESS;
   }
   */
@@ -682,9 +754,21 @@ gc_result ga_handle_getParami(ga_Handle* in_handle, gc_int32 in_param,
   */
   return GC_ERROR_GENERIC;
 }
+gc_result ga_handle_setBus(ga_Handle* in_handle, ga_Bus* in_bus)
+{
+  ga_Handle* h = in_handle;
+  if(h->state == GA_HANDLE_STATE_DESTROYED)
+    return GC_ERROR_GENERIC;
+  if(in_bus && in_bus->mixer != h->mixer)
+    return GC_ERROR_GENERIC;
+  gaX_mixer_push_bus_command(h->mixer, h, in_bus, GA_MIXER_COMMAND_SET_BUS, 0, 0.0f);
+  return GC_SUCCESS;
+}
 gc_result ga_handle_seek(ga_Handle* in_handle, gc_int32 in_sampleOffset)
 {
   ga_sample_source_seek(in_handle->sampleSrc, in_sampleOffset);
+  /* Frames the mix thread still holds are from the old position */
+  gaX_mixer_push_command(in_handle->mixer, in_handle, GA_MIXER_COMMAND_SEEK, 0, 0.0f);
   return GC_SUCCESS;
 }
 gc_int32 ga_handle_tell(ga_Handle* in_handle, gc_int32 in_param)
@@ -707,147 +791,365 @@ void ga_handle_format(ga_Handle* in_handle, ga_Format* out_format)
 }
 
 /* Mixer Functions */
+/* Initial scratch capacity covers 16-bit stereo sources played up to this many times faster than
+   the mixer's rate (pitch * source rate / mixer rate); it only grows for sources beyond that */
+#define GA_MIXER_SCRATCH_PITCH_HEADROOM 8
+#define GA_MIXER_SCRATCH_SAMPLE_SIZE 4
+
 ga_Mixer* ga_mixer_create(ga_Format* in_format, gc_int32 in_numSamples)
 {
   ga_Mixer* ret = gcX_ops->allocFunc(sizeof(ga_Mixer));
   gc_int32 mixSampleSize;
   gc_list_head(&ret->dispatchList);
   gc_list_head(&ret->mixList);
+  gc_list_head(&ret->busList);
+  ret->buses = 0;
+  ret->numBuses = 0;
   ret->numSamples = in_numSamples;
   memcpy(&ret->format, in_format, sizeof(ga_Format));
-  ret->mixFormat.bitsPerSample = 32;
+  ret->mixFormat.bitsPerSample = 32; /* float */
   ret->mixFormat.numChannels = in_format->numChannels;
   ret->mixFormat.sampleRate = in_format->sampleRate;
   mixSampleSize = ga_format_sampleSize(&ret->mixFormat);
-  ret->mixBuffer = (gc_int32*)gcX_ops->allocFunc(in_numSamples * mixSampleSize);
+  ret->mixBuffer = (gc_float32*)gcX_ops->allocFunc(in_numSamples * mixSampleSize);
+  ret->scratchSize = in_numSamples * GA_MIXER_SCRATCH_PITCH_HEADROOM * GA_MIXER_SCRATCH_SAMPLE_SIZE;
+  ret->scratchBuffer = gcX_ops->allocFunc(ret->scratchSize);
+  ret->resampleQuality = GA_RESAMPLE_QUALITY_LINEAR;
+  gaX_resample_init();
   ret->dispatchMutex = gc_mutex_create();
-  ret->mixMutex = gc_mutex_create();
+  ret->commandQueue = gc_buffer_create(GA_MIXER_COMMAND_QUEUE_SIZE);
+  ret->pendingCommands = 0;
+  ret->numPendingCommands = 0;
+  ret->pendingCommandCapacity = 0;
   return ret;
 }
-ga_Format* ga_mixer_format(ga_Mixer* in_mixer)
+static void gaX_mixer_flush_commands(ga_Mixer* in_mixer)
 {
-  return &in_mixer->format;
+  /* Main thread only: moves commands that overflowed the queue into it, oldest first */
+  ga_Mixer* m = in_mixer;
+  gc_int32 numFlushed = 0;
+  while(numFlushed < m->numPendingCommands &&
+        gc_buffer_write(m->commandQueue, &m->pendingCommands[numFlushed], sizeof(ga_MixerCommand)) == GC_SUCCESS)
+    ++numFlushed;
+  if(!numFlushed)
+    return;
+  m->numPendingCommands -= numFlushed;
+  memmove(m->pendingCommands, &m->pendingCommands[numFlushed], m->numPendingCommands * sizeof(ga_MixerCommand));
 }
-gc_int32 ga_mixer_numSamples(ga_Mixer* in_mixer)
+void gaX_mixer_push_command(ga_Mixer* in_mixer, ga_Handle* in_handle, gc_int32 in_type,
+                            gc_int32 in_param, gc_float32 in_value)
 {
-  return in_mixer->numSamples;
+  gaX_mixer_push_bus_command(in_mixer, in_handle, 0, in_type, in_param, in_value);
+}
+void gaX_mixer_push_bus_command(ga_Mixer* in_mixer, ga_Handle* in_handle, ga_Bus* in_bus,
+                                gc_int32 in_type, gc_int32 in_param, gc_float32 in_value)
+{
+  /* Main thread only (single producer). Never blocks: if the mix thread has fallen behind, commands
+     are held until there is room, and flushed by later commands or ga_mixer_dispatch(). */
+  ga_Mixer* m = in_mixer;
+  ga_MixerCommand cmd;
+  cmd.handle = in_handle;
+  cmd.bus = in_bus;
+  cmd.type = in_type;
+  cmd.param = in_param;
+  cmd.value = in_value;
+  gaX_mixer_flush_commands(m);
+  if(!m->numPendingCommands && gc_buffer_write(m->commandQueue, &cmd, sizeof(ga_MixerCommand)) == GC_SUCCESS)
+    return;
+  if(m->numPendingCommands == m->pendingCommandCapacity)
+  {
+    m->pendingCommandCapacity = m->pendingCommandCapacity ? m->pendingCommandCapacity * 2 : 64;
+    m->pendingCommands = gcX_ops->reallocFunc(m->pendingCommands, m->pendingCommandCapacity * sizeof(ga_MixerCommand));
+  }
+  m->pendingCommands[m->numPendingCommands++] = cmd;
 }
-void gaX_mixer_mix_buffer(ga_Mixer* in_mixer,
-                          void* in_srcBuffer, gc_int32 in_srcSamples, ga_Format* in_srcFmt,
-                          gc_int32* in_dstBuffer, gc_int32 in_dstSamples, ga_Format* in_dstFmt,
-                          gc_float32 in_gain, gc_float32 in_pan, gc_float32 in_pitch)
-{
-  ga_Format* mixFmt = in_dstFmt;
-  gc_int32 mixerChannels = mixFmt->numChannels;
-  gc_int32 srcChannels = in_srcFmt->numChannels;
-  gc_float32 sampleScale = in_srcFmt->sampleRate / (gc_float32)mixFmt->sampleRate * in_pitch;
-  gc_int32* dst = in_dstBuffer;
-  gc_int32 numToFill = in_dstSamples;
-  gc_float32 fj = 0.0f;
-  gc_int32 j = 0;
-  gc_int32 i = 0;
-  gc_float32 pan = in_pan;
-  gc_float32 gain = in_gain;
-  gc_float32 srcSamplesRead = 0.0f;
-  gc_int32 sampleSize = ga_format_sampleSize(in_srcFmt);
-  pan = (pan + 1.0f) / 2.0f;
-  pan = pan > 1.0f ? 1.0f : pan;
-  pan = pan < 0.0f ? 0.0f : pan;
-
-  /* TODO: Support 8-bit/16-bit mono/stereo mixer format */
-  switch(in_srcFmt->bitsPerSample)
+static void gaX_mixer_apply_commands(ga_Mixer* in_mixer)
+{
+  /* Mix thread only (single consumer) */
+  ga_Mixer* m = in_mixer;
+  ga_MixerCommand cmd;
+  while(gc_buffer_bytesAvail(m->commandQueue) >= sizeof(ga_MixerCommand))
   {
-  case 16:
+    ga_Handle* h;
+    ga_Bus* b;
+    gc_Link* link;
+    gc_buffer_read(m->commandQueue, &cmd, sizeof(ga_MixerCommand));
+    gc_buffer_consume(m->commandQueue, sizeof(ga_MixerCommand));
+    h = cmd.handle;
+    b = cmd.bus;
+    switch(cmd.type)
     {
-      gc_int32 srcBytes = in_srcSamples * sampleSize;
-      const gc_int16* src = (const gc_int16*)in_srcBuffer;
-      while(i < numToFill * (gc_int32)mixerChannels && srcBytes >= 2 * srcChannels)
+    case GA_MIXER_COMMAND_LINK:
+      gc_list_link(&m->mixList, &h->mixLink, h);
+      break;
+    case GA_MIXER_COMMAND_DESTROY:
+      if(h->mixLink.next)
+        gc_list_unlink(&h->mixLink);
+      h->mixState = GA_HANDLE_STATE_DESTROYED;
+      h->mixReleased = 1; /* Handle must not be touched by the mix thread after this */
+      break;
+    case GA_MIXER_COMMAND_PLAY:
+      if(h->mixState < GA_HANDLE_STATE_FINISHED)
+        h->mixState = GA_HANDLE_STATE_PLAYING;
+      break;
+    case GA_MIXER_COMMAND_STOP:
+      if(h->mixState < GA_HANDLE_STATE_FINISHED)
+        h->mixState = GA_HANDLE_STATE_STOPPED;
+      break;
+    case GA_MIXER_COMMAND_PARAMF:
+      switch(cmd.param)
+      {
+      case GA_HANDLE_PARAM_GAIN: h->mixGain = cmd.value; break;
+      case GA_HANDLE_PARAM_PAN: h->mixPan = cmd.value; break;
+      case GA_HANDLE_PARAM_PITCH: h->mixPitch = cmd.value; break;
+      }
+      break;
+    case GA_MIXER_COMMAND_RESTART:
+      if(h->mixState == GA_HANDLE_STATE_DESTROYED)
+        break;
+      ga_sample_source_seek(h->sampleSrc, 0);
+      h->mixSerial = cmd.param;
+      h->mixState = GA_HANDLE_STATE_PLAYING;
+      h->mixGainL = -1.0f;
+      h->mixGainR = -1.0f;
+      h->resampleTaps = 0; /* Resets the resampler on the next mix */
+      if(!h->mixLink.next)
+        gc_list_link(&m->mixList, &h->mixLink, h);
+      break;
+    case GA_MIXER_COMMAND_SEEK:
+      h->resampleTaps = 0;
+      break;
+    case GA_MIXER_COMMAND_SET_BUS:
+      if(h->mixState != GA_HANDLE_STATE_DESTROYED)
+        h->mixBus = b;
+      break;
+    case GA_MIXER_COMMAND_BUS_LINK:
+      gc_list_link(&m->busList, &b->mixLink, b);
+      break;
+    case GA_MIXER_COMMAND_BUS_PARAMF:
+      switch(cmd.param)
+      {
+      case GA_BUS_PARAM_GAIN: b->gain = cmd.value; break;
+      case GA_BUS_PARAM_FILTER_CUTOFF: b->filterCutoff = cmd.value; b->filterDirty = 1; break;
+      case GA_BUS_PARAM_FILTER_Q: b->filterQ = cmd.value; b->filterDirty = 1; break;
+      case GA_BUS_PARAM_DUCK_GAIN: b->duckGain = cmd.value; break;
+      }
+      break;
+    case GA_MIXER_COMMAND_BUS_FILTER:
+      b->filterType = cmd.param;
+      b->filterDirty = 1;
+      break;
+    case GA_MIXER_COMMAND_BUS_DUCK:
+      b->duckSource = 0;
+      link = m->busList.next;
+      while(cmd.param && link != &m->busList)
       {
-        gc_int32 newJ, deltaSrcBytes;
-        dst[i] += (gc_int32)((gc_int32)src[j] * gain * (1.0f - pan) * 2);
-        dst[i + 1] += (gc_int32)((gc_int32)src[j + ((srcChannels == 1) ? 0 : 1)] * gain * pan * 2);
-        i += mixerChannels;
-        fj += sampleScale * srcChannels;
-        srcSamplesRead += sampleScale * srcChannels;
-        newJ = (gc_uint32)fj & (srcChannels == 1 ? ~0 : ~0x1);
-        deltaSrcBytes = (newJ - j) * 2;
-        j = newJ;
-        srcBytes -= deltaSrcBytes;
+        ga_Bus* source = (ga_Bus*)link->data;
+        link = link->next;
+        if(source->id == cmd.param)
+          b->duckSource = source;
       }
       break;
     }
   }
 }
+ga_Format* ga_mixer_format(ga_Mixer* in_mixer)
+{
+  return &in_mixer->format;
+}
+gc_int32 ga_mixer_numSamples(ga_Mixer* in_mixer)
+{
+  return in_mixer->numSamples;
+}
+gc_result ga_mixer_setResampleQuality(ga_Mixer* in_mixer, gc_int32 in_quality)
+{
+  if(in_quality < GA_RESAMPLE_QUALITY_LINEAR || in_quality > GA_RESAMPLE_QUALITY_POLYPHASE)
+    return GC_ERROR_GENERIC;
+  in_mixer->resampleQuality = in_quality;
+  return GC_SUCCESS;
+}
 void gaX_mixer_mix_handle(ga_Mixer* in_mixer, ga_Handle* in_handle, gc_int32 in_numSamples)
 {
   ga_Handle* h = in_handle;
 
   ga_Mixer* m = in_mixer;
   ga_SampleSource* ss = h->sampleSrc;
-  if(ga_sample_source_end(ss))
+  gc_int32 ended = ga_sample_source_end(ss);
+  /* Source frames past the window center have not been output yet; keep mixing until they have */
+  if(ended && (h->mixState != GA_HANDLE_STATE_PLAYING || !h->resampleTaps ||
+               h->resampleHistoryCount - h->resamplePadding <= h->resampleTaps / 2 - 1))
   {
     /* Stream is finished! */
-    gc_mutex_lock(h->handleMutex);
-    if(h->state < GA_HANDLE_STATE_FINISHED)
-      h->state = GA_HANDLE_STATE_FINISHED;
-    gc_mutex_unlock(h->handleMutex);
+    h->mixState = GA_HANDLE_STATE_FINISHED;
+    h->finished = h->mixSerial;
     return;
   }
   else
   {
-    if(h->state == GA_HANDLE_STATE_PLAYING)
+    if(h->mixState == GA_HANDLE_STATE_PLAYING)
     {
       ga_Format handleFormat;
+      gc_float32 gain, pan, pitch;
+      gc_float32 gainL, gainR, startGainL, startGainR, stepL, stepR;
+      gc_int32 srcChannels, srcSampleSize;
+      gc_float32 sampleScale;
+      gc_uint64 step;
+      gc_int32 quality, taps, center;
+      gc_int32 historyCount, needed, requested, numRead, consumed;
+      gc_int32 bufferSize;
+      gc_int32 unity, realign;
+      gc_int16* src;
+      gc_float32* dst = h->mixBus ? h->mixBus->buffer : &m->mixBuffer[0];
+
       ga_sample_source_format(ss, &handleFormat);
+      /* TODO: Support 8-bit sources and mono mixer format */
+      if(handleFormat.bitsPerSample != 16 || handleFormat.numChannels > 2 || m->format.numChannels != 2)
+        return;
+
+      gain = h->mixGain;
+      pan = h->mixPan;
+      pitch = h->mixPitch;
+
+      srcChannels = handleFormat.numChannels;
+      srcSampleSize = ga_format_sampleSize(&handleFormat);
+      sampleScale = handleFormat.sampleRate / (gc_float32)m->format.sampleRate * pitch;
+      step = (gc_uint64)((gc_float64)sampleScale * 4294967296.0);
+
+      /* Restart the resampler if the filter size changed (or on the first mix) */
+      quality = m->resampleQuality;
+      taps = gaX_resample_taps(quality);
+      center = taps / 2 - 1;
+      if(h->resampleTaps != taps)
+      {
+        h->resampleTaps = taps;
+        h->resampleFrac = 0;
+        h->resampleHistoryCount = center;
+        h->resamplePadding = 0;
+        memset(h->resampleHistory, 0, sizeof(h->resampleHistory));
+      }
+
+      /* At unity ratio with a fractional position left over from resampling, advance slightly
+         less than one frame per sample so the buffer ends on a whole frame and the next can
+         take the unity path again */
+      unity = sampleScale == 1.0f && h->resampleFrac == 0;
+      realign = sampleScale == 1.0f && h->resampleFrac != 0;
+      if(realign)
+        step = (((gc_uint64)in_numSamples << 32) - h->resampleFrac + in_numSamples - 1) / in_numSamples;
+
+      /* Work out how many new source frames the window needs to cover the whole buffer */
+      historyCount = h->resampleHistoryCount;
+      if(unity)
+        needed = in_numSamples + center;
+      else
+      {
+        gc_uint64 lastPos = h->resampleFrac + (gc_uint64)(in_numSamples - 1) * step;
+        gc_int32 endFrame = (gc_int32)((lastPos + step) >> 32);
+        needed = (gc_int32)(lastPos >> 32) + taps;
+        needed = endFrame > needed ? endFrame : needed;
+      }
+      requested = needed > historyCount ? needed - historyCount : 0;
+      if(requested > 0 && !ended && !ga_sample_source_ready(ss, requested))
+        return;
+
+      /* Scratch buffer holds the history followed by the newly read frames */
+      bufferSize = (historyCount + requested) * srcSampleSize;
+      if(bufferSize > m->scratchSize)
+      {
+        /* Rare: only for extreme pitch/rate ratios; capacity is kept for later buffers */
+        gcX_ops->freeFunc(m->scratchBuffer);
+        m->scratchSize = bufferSize;
+        m->scratchBuffer = gcX_ops->allocFunc(bufferSize);
+      }
+      src = (gc_int16*)m->scratchBuffer;
+      memcpy(src, h->resampleHistory, historyCount * srcSampleSize);
+      numRead = requested > 0 && !ended ? ga_sample_source_read(ss, src + historyCount * srcChannels, requested, 0, 0) : 0;
+      if(numRead < requested)
+        memset(src + (historyCount + numRead) * srcChannels, 0, (requested - numRead) * srcSampleSize);
+
+      /* Channel gains, ramped from the previous buffer's to avoid zipper noise on changes */
+      pan = (pan + 1.0f) / 2.0f;
+      pan = pan > 1.0f ? 1.0f : pan;
+      pan = pan < 0.0f ? 0.0f : pan;
+      gainL = gain * (1.0f - pan) * 2;
+      gainR = gain * pan * 2;
+      startGainL = h->mixGainL < 0.0f ? gainL : h->mixGainL;
+      startGainR = h->mixGainR < 0.0f ? gainR : h->mixGainR;
+      stepL = (gainL - startGainL) / in_numSamples;
+      stepR = (gainR - startGainR) / in_numSamples;
+      h->mixGainL = gainL;
+      h->mixGainR = gainR;
+
+      if(unity)
       {
-        /* Check if we have enough samples to stream a full buffer */
-        gc_int32 srcSampleSize = ga_format_sampleSize(&handleFormat);
-        gc_int32 dstSampleSize = ga_format_sampleSize(&m->format);
-        gc_float32 oldPitch = h->pitch;
-        gc_float32 dstToSrc = handleFormat.sampleRate / (gc_float32)m->format.sampleRate * oldPitch;
-        gc_int32 requested = (gc_int32)(in_numSamples * dstToSrc);
-        requested = requested / dstToSrc < in_numSamples ? requested + 1 : requested;
-        if(requested > 0 && ga_sample_source_ready(ss, requested))
-        {
-          gc_float32 gain, pan, pitch;
-          gc_int32* dstBuffer;
-          gc_int32 dstSamples;
-
-          gc_mutex_lock(h->handleMutex);
-          gain = h->gain;
-          pan = h->pan;
-          pitch = h->pitch;
-          gc_mutex_unlock(h->handleMutex);
-
-          /* We avoided a mutex lock by using pitch to check if buffer has enough dst samples */
-          /* If it has changed since then, we re-test to make sure we still have enough samples */
-          if(oldPitch != pitch)
-          {
-            dstToSrc = handleFormat.sampleRate / (gc_float32)m->format.sampleRate * pitch;
-            requested = (gc_int32)(in_numSamples * dstToSrc);
-            requested = requested / dstToSrc < in_numSamples ? requested + 1 : requested;
-            if(!(requested > 0 && ga_sample_source_ready(ss, requested)))
-              return;
-          }
-
-          dstBuffer = &m->mixBuffer[0];
-          dstSamples = in_numSamples;
-          {
-            /* TODO: To optimize, we can refactor the _read() interface to be _mix(), avoiding this malloc/copy */
-            gc_int32 bufferSize = requested * srcSampleSize;
-            void* src = gcX_ops->allocFunc(bufferSize);
-            gc_int32 dstBytes = dstSamples * dstSampleSize;
-            gc_int32 numRead = 0;
-            numRead = ga_sample_source_read(ss, src, requested, 0, 0);
-            gaX_mixer_mix_buffer(in_mixer,
-                                 src, numRead, &handleFormat,
-                                 dstBuffer, dstSamples, &m->format,
-                                 gain, pan, pitch);
-            gcX_ops->freeFunc(src);
-          }
-        }
+        /* No resampling: frames are mixed straight from the window center */
+        if(srcChannels == 2)
+          gaX_mix_stereo_s16(dst, src + center * 2, in_numSamples, startGainL, startGainR, stepL, stepR);
+        else
+          gaX_mix_mono_s16(dst, src + center, in_numSamples, startGainL, startGainR, stepL, stepR);
+        consumed = in_numSamples;
       }
+      else
+      {
+        gc_uint64 endPos = gaX_resample_mix_s16(dst, src, srcChannels, in_numSamples,
+                                                h->resampleFrac, step, quality,
+                                                startGainL, startGainR, stepL, stepR);
+        consumed = (gc_int32)(endPos >> 32);
+        h->resampleFrac = realign ? 0 : (gc_uint32)endPos; /* Overshoot is under in_numSamples / 2^32 frames */
+      }
+
+      /* Keep the frames the window still needs, noting how many of them are padding after a short
+         read (padding only trails real frames once nothing more was read) */
+      h->resampleHistoryCount = historyCount + requested - consumed;
+      h->resamplePadding = (numRead > 0 ? 0 : h->resamplePadding) + requested - numRead;
+      if(h->resamplePadding > h->resampleHistoryCount)
+        h->resamplePadding = h->resampleHistoryCount;
+      memcpy(h->resampleHistory, src + consumed * srcChannels, h->resampleHistoryCount * srcSampleSize);
+    }
+  }
+}
+static void gaX_mixer_mix_buses(ga_Mixer* in_mixer)
+{
+  /* The bus list is newest first, and parents are created before their children, so every bus
+     has been accumulated into its parent before the parent itself is mixed */
+  ga_Mixer* m = in_mixer;
+  gc_int32 numSamples = m->numSamples;
+  gc_float32 bufferSeconds = numSamples / (gc_float32)m->format.sampleRate;
+  gc_float32 attack = (gc_float32)exp(-bufferSeconds / GA_BUS_DUCK_ATTACK_SECONDS);
+  gc_float32 release = (gc_float32)exp(-bufferSeconds / GA_BUS_DUCK_RELEASE_SECONDS);
+  gc_Link* link = m->busList.next;
+  while(link != &m->busList)
+  {
+    ga_Bus* b = (ga_Bus*)link->data;
+    gc_float32* dst = b->parent ? b->parent->buffer : m->mixBuffer;
+    gc_float32 gain, startGain;
+    link = link->next;
+
+    if(b->filterDirty)
+    {
+      if(b->filterType == GA_BUS_FILTER_NONE)
+        memset(b->filterState, 0, sizeof(b->filterState));
+      else
+        gaX_bus_filter_coeffs(b->filterType, b->filterCutoff, b->filterQ,
+                              m->format.sampleRate, b->filterCoeffs);
+      b->filterDirty = 0;
+    }
+    if(b->filterType != GA_BUS_FILTER_NONE)
+      gaX_bus_filter(b->buffer, numSamples, b->filterCoeffs, b->filterState);
+
+    if(b->duckSource)
+    {
+      gc_float32 target = b->duckSource->peak > GA_BUS_DUCK_THRESHOLD ? b->duckGain : 1.0f;
+      gc_float32 coeff = target < b->duckLevel ? attack : release;
+      b->duckLevel = target + (b->duckLevel - target) * coeff;
     }
+    else
+      b->duckLevel = 1.0f;
+
+    /* Ramped from the previous buffer's gain, like handle gains */
+    gain = b->gain * b->duckLevel;
+    startGain = b->mixGain < 0.0f ? gain : b->mixGain;
+    b->peak = gaX_bus_accumulate(dst, b->buffer, numSamples, startGain, (gain - startGain) / numSamples);
+    b->mixGain = gain;
   }
 }
 gc_result ga_mixer_mix(ga_Mixer* in_mixer, void* out_buffer)
@@ -859,6 +1161,7 @@ gc_result ga_mixer_mix(ga_Mixer* in_mixer, void* out_buffer)
   ga_Format* fmt = &m->format;
   gc_int32 mixSampleSize = ga_format_sampleSize(&m->mixFormat);
   memset(&m->mixBuffer[0], 0, m->numSamples * mixSampleSize);
+  gaX_mixer_apply_commands(m);
 
   link = m->mixList.next;
   while(link != &m->mixList)
@@ -867,13 +1170,10 @@ gc_result ga_mixer_mix(ga_Mixer* in_mixer, void* out_buffer)
     gc_Link* oldLink = link;
     link = link->next;
     gaX_mixer_mix_handle(m, (ga_Handle*)h, m->numSamples);
-    if(ga_handle_finished(h))
-    {
-      gc_mutex_lock(m->mixMutex);
+    if(h->finished == h->mixSerial)
       gc_list_unlink(oldLink);
-      gc_mutex_unlock(m->mixMutex);
-    }
   }
+  gaX_mixer_mix_buses(m);
 
   switch(fmt->bitsPerSample) /* mixBuffer will already be correct bps */
   {
@@ -882,21 +1182,14 @@ gc_result ga_mixer_mix(ga_Mixer* in_mixer, void* out_buffer)
       gc_int8* mix = (gc_int8*)out_buffer;
       for(i = 0; i < end; ++i)
       {
-        gc_int32 sample = m->mixBuffer[i];
+        gc_int32 sample = (gc_int32)m->mixBuffer[i];
         mix[i] = (gc_int8)(sample > -128 ? (sample < 127 ? sample : 127) : -128);
       }
       break;
     }
   case 16:
-    {
-      gc_int16* mix = (gc_int16*)out_buffer;
-      for(i = 0; i < end; ++i)
-      {
-        gc_int32 sample = m->mixBuffer[i];
-        mix[i] = (gc_int16)(sample > -32768 ? (sample < 32767 ? sample : 32767) : -32768);
-      }
-      break;
-    }
+    gaX_mix_convert_s16((gc_int16*)out_buffer, m->mixBuffer, end);
+    break;
   }
   return GC_SUCCESS;
 }
@@ -904,6 +1197,7 @@ gc_result ga_mixer_dispatch(ga_Mixer* in_mixer)
 {
   ga_Mixer* m = in_mixer;
   gc_Link* link = m->dispatchList.next;
+  gaX_mixer_flush_commands(m);
   while(link != &m->dispatchList)
   {
     gc_Link* oldLink = link;
@@ -913,7 +1207,7 @@ gc_result ga_mixer_dispatch(ga_Mixer* in_mixer)
     /* Remove finished handles and call callbacks */
     if(ga_handle_destroyed(oldHandle))
     {
-      if(!oldHandle->mixLink.next)
+      if(oldHandle->mixReleased)
       {
         /* NOTES ABOUT THREADING POLICY WITH REGARD TO LINKED LISTS: */
         /* Only a single thread may iterate through any list */
@@ -939,6 +1233,7 @@ gc_result ga_mixer_destroy(ga_Mixer* in_mixer)
   /* NOTE: Mixer/handles must no longer be in use on any thread when destroy is called */
   ga_Mixer* m = in_mixer;
   gc_Link* link;
+  ga_Bus* bus;
   link = m->dispatchList.next;
   while(link != &m->dispatchList)
   {
@@ -947,10 +1242,84 @@ gc_result ga_mixer_destroy(ga_Mixer* in_mixer)
     gaX_handle_cleanup(oldHandle);
   }
 
+  bus = m->buses;
+  while(bus)
+  {
+    ga_Bus* oldBus = bus;
+    bus = bus->next;
+    gcX_ops->freeFunc(oldBus->buffer);
+    gcX_ops->freeFunc(oldBus);
+  }
+
   gc_mutex_destroy(in_mixer->dispatchMutex);
-  gc_mutex_destroy(in_mixer->mixMutex);
+  gc_buffer_destroy(in_mixer->commandQueue);
+  gcX_ops->freeFunc(in_mixer->pendingCommands);
 
   gcX_ops->freeFunc(in_mixer->mixBuffer);
+  gcX_ops->freeFunc(in_mixer->scratchBuffer);
   gcX_ops->freeFunc(in_mixer);
   return GC_SUCCESS;
 }
+
+/* Bus Functions */
+ga_Bus* ga_bus_create(ga_Mixer* in_mixer, ga_Bus* in_parent)
+{
+  ga_Mixer* m = in_mixer;
+  ga_Bus* b;
+  gc_int32 bufferSize = m->numSamples * 2 * sizeof(gc_float32);
+  if(m->format.numChannels != 2 || (in_parent && in_parent->mixer != m))
+    return 0;
+  b = (ga_Bus*)gcX_ops->allocFunc(sizeof(ga_Bus));
+  b->mixer = m;
+  b->parent = in_parent;
+  b->id = ++m->numBuses;
+  b->mixLink.next = 0;
+  b->mixLink.prev = 0;
+  b->mixLink.data = 0;
+  b->buffer = (gc_float32*)gcX_ops->allocFunc(bufferSize);
+  memset(b->buffer, 0, bufferSize);
+  b->gain = 1.0f;
+  b->filterType = GA_BUS_FILTER_NONE;
+  b->filterCutoff = 1000.0f;
+  b->filterQ = 0.7071f;
+  b->filterDirty = 0;
+  memset(b->filterCoeffs, 0, sizeof(b->filterCoeffs));
+  memset(b->filterState, 0, sizeof(b->filterState));
+  b->duckSource = 0;
+  b->duckGain = 0.3f;
+  b->duckLevel = 1.0f;
+  b->mixGain = -1.0f;
+  b->peak = 0.0f;
+  b->next = m->buses;
+  m->buses = b;
+  gaX_mixer_push_bus_command(m, 0, b, GA_MIXER_COMMAND_BUS_LINK, 0, 0.0f);
+  return b;
+}
+gc_result ga_bus_setParamf(ga_Bus* in_bus, gc_int32 in_param, gc_float32 in_value)
+{
+  switch(in_param)
+  {
+  case GA_BUS_PARAM_GAIN:
+  case GA_BUS_PARAM_FILTER_CUTOFF:
+  case GA_BUS_PARAM_FILTER_Q:
+  case GA_BUS_PARAM_DUCK_GAIN:
+    gaX_mixer_push_bus_command(in_bus->mixer, 0, in_bus, GA_MIXER_COMMAND_BUS_PARAMF, in_param, in_value);
+    return GC_SUCCESS;
+  }
+  return GC_ERROR_GENERIC;
+}
+gc_result ga_bus_setFilter(ga_Bus* in_bus, gc_int32 in_filterType)
+{
+  if(in_filterType < GA_BUS_FILTER_NONE || in_filterType > GA_BUS_FILTER_HIGHPASS)
+    return GC_ERROR_GENERIC;
+  gaX_mixer_push_bus_command(in_bus->mixer, 0, in_bus, GA_MIXER_COMMAND_BUS_FILTER, in_filterType, 0.0f);
+  return GC_SUCCESS;
+}
+gc_result ga_bus_setDuckSource(ga_Bus* in_bus, ga_Bus* in_source)
+{
+  if(in_source == in_bus || (in_source && in_source->mixer != in_bus->mixer))
+    return GC_ERROR_GENERIC;
+  gaX_mixer_push_bus_command(in_bus->mixer, 0, in_bus, GA_MIXER_COMMAND_BUS_DUCK,
+                             in_source ? in_source->id : 0, 0.0f);
+  return GC_SUCCESS;
+}
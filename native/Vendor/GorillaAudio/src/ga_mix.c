@@ -0,0 +1,403 @@
+#include "gorilla/ga.h"
+#include "gorilla/ga_internal.h"
+
+#include <math.h>
+
+/* Kernels used by the mixer to accumulate 16-bit PCM into the float mix bus, and to convert the bus
+   to the 16-bit device format.  The mix bus is interleaved stereo in 16-bit sample scale (not
+   normalized), so conversion is a clamp and truncation.
+
+   Gains ramp linearly over a buffer: the gain for frame k is (in_gain + in_step * k), evaluated the
+   same way in the scalar and vector paths so that they produce identical output.
+
+   Submix buses use the same layout and scale; they are filtered in place and then accumulated into
+   their parent bus (or the mix bus). */
+
+#if defined(__AVX2__)
+#define GAX_MIX_AVX2
+#include <immintrin.h>
+#endif /* __AVX2__ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GAX_MIX_SSE2
+#include <emmintrin.h>
+#endif /* SSE2 */
+
+#define GAX_MIX_S16_MIN -32768.0f
+#define GAX_MIX_S16_MAX 32767.0f
+#define GAX_MIX_DENORMAL_FLOOR 1e-10
+
+static void gaX_mix_stereo_s16_scalar(gc_float32* io_dst, const gc_int16* in_src,
+                                      gc_int32 in_first, gc_int32 in_end,
+                                      gc_float32 in_gainL, gc_float32 in_gainR,
+                                      gc_float32 in_stepL, gc_float32 in_stepR)
+{
+  gc_int32 k;
+  for(k = in_first; k < in_end; ++k)
+  {
+    gc_float32 fk = (gc_float32)k;
+    io_dst[k * 2] += (gc_float32)in_src[k * 2] * (in_gainL + in_stepL * fk);
+    io_dst[k * 2 + 1] += (gc_float32)in_src[k * 2 + 1] * (in_gainR + in_stepR * fk);
+  }
+}
+static void gaX_mix_mono_s16_scalar(gc_float32* io_dst, const gc_int16* in_src,
+                                    gc_int32 in_first, gc_int32 in_end,
+                                    gc_float32 in_gainL, gc_float32 in_gainR,
+                                    gc_float32 in_stepL, gc_float32 in_stepR)
+{
+  gc_int32 k;
+  for(k = in_first; k < in_end; ++k)
+  {
+    gc_float32 fk = (gc_float32)k;
+    gc_float32 sample = (gc_float32)in_src[k];
+    io_dst[k * 2] += sample * (in_gainL + in_stepL * fk);
+    io_dst[k * 2 + 1] += sample * (in_gainR + in_stepR * fk);
+  }
+}
+
+void gaX_mix_stereo_s16(gc_float32* io_dst, const gc_int16* in_src, gc_int32 in_numSamples,
+                        gc_float32 in_gainL, gc_float32 in_gainR,
+                        gc_float32 in_stepL, gc_float32 in_stepR)
+{
+  gc_int32 k = 0;
+#if defined(GAX_MIX_AVX2)
+  {
+    /* 4 frames (8 floats) per vector */
+    __m256 gain = _mm256_setr_ps(in_gainL, in_gainR, in_gainL, in_gainR, in_gainL, in_gainR, in_gainL, in_gainR);
+    __m256 step = _mm256_setr_ps(in_stepL, in_stepR, in_stepL, in_stepR, in_stepL, in_stepR, in_stepL, in_stepR);
+    __m256 index = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f);
+    __m256 four = _mm256_set1_ps(4.0f);
+    for(; k + 4 <= in_numSamples; k += 4)
+    {
+      __m128i s16 = _mm_loadu_si128((const __m128i*)(in_src + k * 2));
+      __m256 s = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(s16));
+      __m256 g = _mm256_add_ps(gain, _mm256_mul_ps(step, index));
+      __m256 d = _mm256_loadu_ps(io_dst + k * 2);
+      _mm256_storeu_ps(io_dst + k * 2, _mm256_add_ps(d, _mm256_mul_ps(s, g)));
+      index = _mm256_add_ps(index, four);
+    }
+  }
+#elif defined(GAX_MIX_SSE2)
+  {
+    /* 4 frames per iteration, as two vectors of 2 frames */
+    __m128 gain = _mm_setr_ps(in_gainL, in_gainR, in_gainL, in_gainR);
+    __m128 step = _mm_setr_ps(in_stepL, in_stepR, in_stepL, in_stepR);
+    __m128 indexLo = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+    __m128 indexHi = _mm_setr_ps(2.0f, 2.0f, 3.0f, 3.0f);
+    __m128 four = _mm_set1_ps(4.0f);
+    for(; k + 4 <= in_numSamples; k += 4)
+    {
+      __m128i s16 = _mm_loadu_si128((const __m128i*)(in_src + k * 2));
+      __m128 sLo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16));
+      __m128 sHi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16));
+      __m128 gLo = _mm_add_ps(gain, _mm_mul_ps(step, indexLo));
+      __m128 gHi = _mm_add_ps(gain, _mm_mul_ps(step, indexHi));
+      __m128 dLo = _mm_loadu_ps(io_dst + k * 2);
+      __m128 dHi = _mm_loadu_ps(io_dst + k * 2 + 4);
+      _mm_storeu_ps(io_dst + k * 2, _mm_add_ps(dLo, _mm_mul_ps(sLo, gLo)));
+      _mm_storeu_ps(io_dst + k * 2 + 4, _mm_add_ps(dHi, _mm_mul_ps(sHi, gHi)));
+      indexLo = _mm_add_ps(indexLo, four);
+      indexHi = _mm_add_ps(indexHi, four);
+    }
+  }
+#endif
+  gaX_mix_stereo_s16_scalar(io_dst, in_src, k, in_numSamples, in_gainL, in_gainR, in_stepL, in_stepR);
+}
+
+void gaX_mix_mono_s16(gc_float32* io_dst, const gc_int16* in_src, gc_int32 in_numSamples,
+                      gc_float32 in_gainL, gc_float32 in_gainR,
+                      gc_float32 in_stepL, gc_float32 in_stepR)
+{
+  gc_int32 k = 0;
+#if defined(GAX_MIX_AVX2)
+  {
+    /* 8 mono samples per iteration, duplicated into 8 stereo frames */
+    __m256 gain = _mm256_setr_ps(in_gainL, in_gainR, in_gainL, in_gainR, in_gainL, in_gainR, in_gainL, in_gainR);
+    __m256 step = _mm256_setr_ps(in_stepL, in_stepR, in_stepL, in_stepR, in_stepL, in_stepR, in_stepL, in_stepR);
+    __m256 indexLo = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f);
+    __m256 indexHi = _mm256_setr_ps(4.0f, 4.0f, 5.0f, 5.0f, 6.0f, 6.0f, 7.0f, 7.0f);
+    __m256 eight = _mm256_set1_ps(8.0f);
+    __m256i dupLo = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    __m256i dupHi = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+    for(; k + 8 <= in_numSamples; k += 8)
+    {
+      __m128i s16 = _mm_loadu_si128((const __m128i*)(in_src + k));
+      __m256 s = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(s16));
+      __m256 sLo = _mm256_permutevar8x32_ps(s, dupLo);
+      __m256 sHi = _mm256_permutevar8x32_ps(s, dupHi);
+      __m256 gLo = _mm256_add_ps(gain, _mm256_mul_ps(step, indexLo));
+      __m256 gHi = _mm256_add_ps(gain, _mm256_mul_ps(step, indexHi));
+      __m256 dLo = _mm256_loadu_ps(io_dst + k * 2);
+      __m256 dHi = _mm256_loadu_ps(io_dst + k * 2 + 8);
+      _mm256_storeu_ps(io_dst + k * 2, _mm256_add_ps(dLo, _mm256_mul_ps(sLo, gLo)));
+      _mm256_storeu_ps(io_dst + k * 2 + 8, _mm256_add_ps(dHi, _mm256_mul_ps(sHi, gHi)));
+      indexLo = _mm256_add_ps(indexLo, eight);
+      indexHi = _mm256_add_ps(indexHi, eight);
+    }
+  }
+#elif defined(GAX_MIX_SSE2)
+  {
+    /* 4 mono samples per iteration, duplicated into 4 stereo frames */
+    __m128 gain = _mm_setr_ps(in_gainL, in_gainR, in_gainL, in_gainR);
+    __m128 step = _mm_setr_ps(in_stepL, in_stepR, in_stepL, in_stepR);
+    __m128 indexLo = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+    __m128 indexHi = _mm_setr_ps(2.0f, 2.0f, 3.0f, 3.0f);
+    __m128 four = _mm_set1_ps(4.0f);
+    for(; k + 4 <= in_numSamples; k += 4)
+    {
+      __m128i s16 = _mm_loadl_epi64((const __m128i*)(in_src + k));
+      __m128 s = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16));
+      __m128 sLo = _mm_unpacklo_ps(s, s);
+      __m128 sHi = _mm_unpackhi_ps(s, s);
+      __m128 gLo = _mm_add_ps(gain, _mm_mul_ps(step, indexLo));
+      __m128 gHi = _mm_add_ps(gain, _mm_mul_ps(step, indexHi));
+      __m128 dLo = _mm_loadu_ps(io_dst + k * 2);
+      __m128 dHi = _mm_loadu_ps(io_dst + k * 2 + 4);
+      _mm_storeu_ps(io_dst + k * 2, _mm_add_ps(dLo, _mm_mul_ps(sLo, gLo)));
+      _mm_storeu_ps(io_dst + k * 2 + 4, _mm_add_ps(dHi, _mm_mul_ps(sHi, gHi)));
+      indexLo = _mm_add_ps(indexLo, four);
+      indexHi = _mm_add_ps(indexHi, four);
+    }
+  }
+#endif
+  gaX_mix_mono_s16_scalar(io_dst, in_src, k, in_numSamples, in_gainL, in_gainR, in_stepL, in_stepR);
+}
+
+void gaX_mix_convert_s16(gc_int16* out_dst, const gc_float32* in_src, gc_int32 in_count)
+{
+  gc_int32 i = 0;
+#if defined(GAX_MIX_AVX2)
+  {
+    __m256 lo = _mm256_set1_ps(GAX_MIX_S16_MIN);
+    __m256 hi = _mm256_set1_ps(GAX_MIX_S16_MAX);
+    for(; i + 8 <= in_count; i += 8)
+    {
+      __m256 s = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in_src + i), lo), hi);
+      __m256i s32 = _mm256_cvttps_epi32(s);
+      __m128i s16 = _mm_packs_epi32(_mm256_castsi256_si128(s32), _mm256_extracti128_si256(s32, 1));
+      _mm_storeu_si128((__m128i*)(out_dst + i), s16);
+    }
+  }
+#elif defined(GAX_MIX_SSE2)
+  {
+    __m128 lo = _mm_set1_ps(GAX_MIX_S16_MIN);
+    __m128 hi = _mm_set1_ps(GAX_MIX_S16_MAX);
+    for(; i + 8 <= in_count; i += 8)
+    {
+      __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in_src + i), lo), hi);
+      __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in_src + i + 4), lo), hi);
+      __m128i s16 = _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b));
+      _mm_storeu_si128((__m128i*)(out_dst + i), s16);
+    }
+  }
+#endif
+  for(; i < in_count; ++i)
+  {
+    gc_float32 sample = in_src[i];
+    sample = sample > GAX_MIX_S16_MIN ? (sample < GAX_MIX_S16_MAX ? sample : GAX_MIX_S16_MAX) : GAX_MIX_S16_MIN;
+    out_dst[i] = (gc_int16)sample;
+  }
+}
+
+/* Buses */
+
+void gaX_bus_filter_coeffs(gc_int32 in_type, gc_float32 in_cutoff, gc_float32 in_q,
+                           gc_int32 in_sampleRate, gc_float32* out_coeffs)
+{
+  /* RBJ cookbook low/high-pass, normalized by a0 */
+  const gc_float64 pi = 3.14159265358979323846;
+  gc_float64 maxCutoff = in_sampleRate * 0.49;
+  gc_float64 cutoff = in_cutoff < 10.0f ? 10.0 : (in_cutoff > maxCutoff ? maxCutoff : in_cutoff);
+  gc_float64 q = in_q < 0.1f ? 0.1 : in_q;
+  gc_float64 w0 = 2.0 * pi * cutoff / in_sampleRate;
+  gc_float64 cosw0 = cos(w0);
+  gc_float64 alpha = sin(w0) / (2.0 * q);
+  gc_float64 a0 = 1.0 + alpha;
+  gc_float64 b0, b1;
+  if(in_type == GA_BUS_FILTER_HIGHPASS)
+  {
+    b0 = (1.0 + cosw0) / 2.0;
+    b1 = -(1.0 + cosw0);
+  }
+  else
+  {
+    b0 = (1.0 - cosw0) / 2.0;
+    b1 = 1.0 - cosw0;
+  }
+  out_coeffs[0] = (gc_float32)(b0 / a0);
+  out_coeffs[1] = (gc_float32)(b1 / a0);
+  out_coeffs[2] = (gc_float32)(b0 / a0);
+  out_coeffs[3] = (gc_float32)(-2.0 * cosw0 / a0);
+  out_coeffs[4] = (gc_float32)((1.0 - alpha) / a0);
+}
+
+void gaX_bus_filter(gc_float32* io_buffer, gc_int32 in_numSamples,
+                    const gc_float32* in_coeffs, gc_float32* io_state)
+{
+  /* Transposed direct form II, one pass per channel */
+  gc_float32 b0 = in_coeffs[0];
+  gc_float32 b1 = in_coeffs[1];
+  gc_float32 b2 = in_coeffs[2];
+  gc_float32 a1 = in_coeffs[3];
+  gc_float32 a2 = in_coeffs[4];
+  gc_int32 c, k;
+  for(c = 0; c < 2; ++c)
+  {
+    gc_float32 z1 = io_state[c * 2];
+    gc_float32 z2 = io_state[c * 2 + 1];
+    gc_float32* buf = io_buffer + c;
+    for(k = 0; k < in_numSamples; ++k)
+    {
+      gc_float32 x = buf[k * 2];
+      gc_float32 y = b0 * x + z1;
+      z1 = b1 * x - a1 * y + z2;
+      z2 = b2 * x - a2 * y;
+      buf[k * 2] = y;
+    }
+    /* Drop decayed tails before they become denormal (the bus is in 16-bit sample scale) */
+    io_state[c * 2] = fabs(z1) < GAX_MIX_DENORMAL_FLOOR ? 0.0f : z1;
+    io_state[c * 2 + 1] = fabs(z2) < GAX_MIX_DENORMAL_FLOOR ? 0.0f : z2;
+  }
+}
+
+gc_float32 gaX_bus_accumulate(gc_float32* io_dst, gc_float32* io_src, gc_int32 in_numSamples,
+                              gc_float32 in_gain, gc_float32 in_step)
+{
+  gc_int32 k = 0;
+  gc_float32 peak = 0.0f;
+#if defined(GAX_MIX_SSE2)
+  {
+    __m128 gain = _mm_set1_ps(in_gain);
+    __m128 step = _mm_set1_ps(in_step);
+    __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 zero = _mm_setzero_ps();
+    __m128 peak4 = zero;
+    gc_float32 lanes[4];
+    for(; k + 2 <= in_numSamples; k += 2)
+    {
+      __m128 fk = _mm_set_ps((gc_float32)(k + 1), (gc_float32)(k + 1), (gc_float32)k, (gc_float32)k);
+      __m128 s = _mm_mul_ps(_mm_loadu_ps(io_src + k * 2), _mm_add_ps(gain, _mm_mul_ps(step, fk)));
+      _mm_storeu_ps(io_dst + k * 2, _mm_add_ps(_mm_loadu_ps(io_dst + k * 2), s));
+      _mm_storeu_ps(io_src + k * 2, zero);
+      peak4 = _mm_max_ps(peak4, _mm_and_ps(s, absMask));
+    }
+    _mm_storeu_ps(lanes, peak4);
+    peak = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+    peak = lanes[2] > peak ? lanes[2] : peak;
+    peak = lanes[3] > peak ? lanes[3] : peak;
+  }
+#endif
+  for(; k < in_numSamples; ++k)
+  {
+    gc_float32 g = in_gain + in_step * (gc_float32)k;
+    gc_float32 l = io_src[k * 2] * g;
+    gc_float32 r = io_src[k * 2 + 1] * g;
+    io_dst[k * 2] += l;
+    io_dst[k * 2 + 1] += r;
+    io_src[k * 2] = 0.0f;
+    io_src[k * 2 + 1] = 0.0f;
+    l = l < 0.0f ? -l : l;
+    r = r < 0.0f ? -r : r;
+    peak = l > peak ? l : peak;
+    peak = r > peak ? r : peak;
+  }
+  return peak;
+}
+
+/* Resampling */
+
+static gc_float32 gaX_polyphase[GA_RESAMPLE_POLYPHASE_PHASES][GA_RESAMPLE_POLYPHASE_TAPS];
+static gc_int32 gaX_polyphaseReady = 0;
+
+void gaX_resample_init()
+{
+  /* Blackman-windowed sinc, one row of taps per fractional phase, each row normalized to unity gain */
+  const gc_float64 pi = 3.14159265358979323846;
+  gc_int32 center = GA_RESAMPLE_POLYPHASE_TAPS / 2 - 1;
+  gc_int32 p, i;
+  if(gaX_polyphaseReady)
+    return;
+  for(p = 0; p < GA_RESAMPLE_POLYPHASE_PHASES; ++p)
+  {
+    gc_float64 frac = p / (gc_float64)GA_RESAMPLE_POLYPHASE_PHASES;
+    gc_float64 sum = 0.0;
+    for(i = 0; i < GA_RESAMPLE_POLYPHASE_TAPS; ++i)
+    {
+      gc_float64 x = i - center - frac;
+      gc_float64 w = (x + GA_RESAMPLE_POLYPHASE_TAPS / 2.0) / GA_RESAMPLE_POLYPHASE_TAPS;
+      gc_float64 sinc = x == 0.0 ? 1.0 : sin(pi * x) / (pi * x);
+      gc_float64 window = 0.42 - 0.5 * cos(2.0 * pi * w) + 0.08 * cos(4.0 * pi * w);
+      gaX_polyphase[p][i] = (gc_float32)(sinc * window);
+      sum += gaX_polyphase[p][i];
+    }
+    for(i = 0; i < GA_RESAMPLE_POLYPHASE_TAPS; ++i)
+      gaX_polyphase[p][i] = (gc_float32)(gaX_polyphase[p][i] / sum);
+  }
+  gaX_polyphaseReady = 1;
+}
+
+gc_int32 gaX_resample_taps(gc_int32 in_quality)
+{
+  switch(in_quality)
+  {
+  case GA_RESAMPLE_QUALITY_CUBIC: return 4;
+  case GA_RESAMPLE_QUALITY_POLYPHASE: return GA_RESAMPLE_POLYPHASE_TAPS;
+  default: return 2;
+  }
+}
+
+/* Interpolates one channel of the window starting at in_src (frames in_stride samples apart) */
+static gc_float32 gaX_resample_interpolate(const gc_int16* in_src, gc_int32 in_stride,
+                                           gc_uint32 in_frac, gc_int32 in_quality)
+{
+  gc_float32 t = (gc_float32)in_frac * (1.0f / 4294967296.0f);
+  switch(in_quality)
+  {
+  case GA_RESAMPLE_QUALITY_CUBIC:
+    {
+      /* Catmull-Rom between the middle two of four frames */
+      gc_float32 p0 = in_src[0];
+      gc_float32 p1 = in_src[in_stride];
+      gc_float32 p2 = in_src[in_stride * 2];
+      gc_float32 p3 = in_src[in_stride * 3];
+      return p1 + 0.5f * t * (p2 - p0 + t * (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3 + t * (3.0f * (p1 - p2) + p3 - p0)));
+    }
+  case GA_RESAMPLE_QUALITY_POLYPHASE:
+    {
+      const gc_float32* coeffs = gaX_polyphase[in_frac >> (32 - GA_RESAMPLE_POLYPHASE_PHASE_BITS)];
+      gc_float32 sum = 0.0f;
+      gc_int32 i;
+      for(i = 0; i < GA_RESAMPLE_POLYPHASE_TAPS; ++i)
+        sum += in_src[i * in_stride] * coeffs[i];
+      return sum;
+    }
+  default:
+    {
+      gc_float32 a = in_src[0];
+      gc_float32 b = in_src[in_stride];
+      return a + (b - a) * t;
+    }
+  }
+}
+
+gc_uint64 gaX_resample_mix_s16(gc_float32* io_dst, const gc_int16* in_src, gc_int32 in_srcChannels,
+                               gc_int32 in_numSamples, gc_uint64 in_pos, gc_uint64 in_step,
+                               gc_int32 in_quality,
+                               gc_float32 in_gainL, gc_float32 in_gainR,
+                               gc_float32 in_stepL, gc_float32 in_stepR)
+{
+  gc_uint64 pos = in_pos;
+  gc_int32 k;
+  for(k = 0; k < in_numSamples; ++k)
+  {
+    gc_float32 fk = (gc_float32)k;
+    const gc_int16* window = in_src + (gc_int32)(pos >> 32) * in_srcChannels;
+    gc_uint32 frac = (gc_uint32)pos;
+    gc_float32 left = gaX_resample_interpolate(window, in_srcChannels, frac, in_quality);
+    gc_float32 right = in_srcChannels == 1 ? left : gaX_resample_interpolate(window + 1, in_srcChannels, frac, in_quality);
+    io_dst[k * 2] += left * (in_gainL + in_stepL * fk);
+    io_dst[k * 2 + 1] += right * (in_gainR + in_stepR * fk);
+    pos += in_step;
+  }
+  return pos;
+}
@@ -136,6 +136,7 @@ ga_StreamManager* ga_stream_manager_create()
 {
   ga_StreamManager* ret = (ga_StreamManager*)gcX_ops->allocFunc(sizeof(ga_StreamManager));
   ret->streamListMutex = gc_mutex_create();
+  ret->bufferEvent = gc_event_create();
   gc_list_head(&ret->streamList);
   return ret;
 }
@@ -150,6 +151,7 @@ gaX_StreamLink* gaX_stream_manager_add(ga_StreamManager* in_mgr, ga_BufferedStre
   streamLink->stream = in_stream;
   gc_list_link(&in_mgr->streamList, (gc_Link*)streamLink, streamLink);
   gc_mutex_unlock(in_mgr->streamListMutex);
+  gc_event_signal(in_mgr->bufferEvent); /* Fill the new stream right away */
   return streamLink;
 }
 void ga_stream_manager_buffer(ga_StreamManager* in_mgr)
@@ -171,6 +173,10 @@ void ga_stream_manager_buffer(ga_StreamManager* in_mgr)
     }
   }
 }
+gc_int32 ga_stream_manager_wait(ga_StreamManager* in_mgr, gc_uint32 in_timeoutMs)
+{
+  return gc_event_wait(in_mgr->bufferEvent, in_timeoutMs);
+}
 void ga_stream_manager_destroy(ga_StreamManager* in_mgr)
 {
   gc_Link* link;
@@ -182,6 +188,7 @@ void ga_stream_manager_destroy(ga_StreamManager* in_mgr)
     gaX_stream_link_release(oldLink);
   }
   gc_mutex_destroy(in_mgr->streamListMutex);
+  gc_event_destroy(in_mgr->bufferEvent);
   gcX_ops->freeFunc(in_mgr);
 }
 
@@ -200,6 +207,7 @@ ga_BufferedStream* ga_stream_create(ga_StreamManager* in_mgr, ga_SampleSource* i
   ret->tell = 0;
   ret->end = 0;
   ret->bufferSize = in_bufferSize;
+  ret->mgr = in_mgr;
   ret->flags = ga_sample_source_flags(in_sampleSrc);
   assert(ret->flags & GA_FLAG_THREADSAFE);
   ret->produceMutex = gc_mutex_create();
@@ -266,6 +274,7 @@ void ga_stream_produce(ga_BufferedStream* in_stream)
       s->tell = samplePos;
       s->seek = -1;
       s->nextSample = samplePos;
+      s->end = 0;
       ga_sample_source_seek(s->innerSrc, samplePos);
       gc_buffer_consume(s->buffer, gc_buffer_bytesAvail(s->buffer)); /* Clear buffer */
       gauX_tell_jump_clear(&s->tellJumps); /* Clear tell-jump list */
@@ -325,6 +334,10 @@ gc_int32 ga_stream_read(ga_BufferedStream* in_stream, void* in_dst, gc_int32 in_
     gc_buffer_consume(b, totalBytes);
   }
 
+  /* Wake the stream manager once the buffer drops below its low-watermark */
+  if(!s->end && samplesConsumed > 0 && gc_buffer_bytesAvail(b) < (gc_uint32)s->bufferSize / 2)
+    gc_event_signal(s->mgr->bufferEvent);
+
   /* Update the tell pos */
   gc_mutex_lock(s->seekMutex);
   s->tell += samplesConsumed;
@@ -338,6 +351,8 @@ gc_int32 ga_stream_ready(ga_BufferedStream* in_stream, gc_int32 in_numSamples)
 {
   ga_BufferedStream* s = in_stream;
   gc_int32 avail = gc_buffer_bytesAvail(s->buffer);
+  if(s->seek >= 0)
+    return 0; /* Buffered samples are from before the seek */
   return s->end || avail >= in_numSamples * ga_format_sampleSize(&s->format) && avail > s->bufferSize / 2.0f;
 }
 gc_int32 ga_stream_end(ga_BufferedStream* in_stream)
@@ -345,7 +360,7 @@ gc_int32 ga_stream_end(ga_BufferedStream* in_stream)
   ga_BufferedStream* s = in_stream;
   gc_CircBuffer* b = s->buffer;
   gc_int32 bytesAvail = gc_buffer_bytesAvail(b);
-  return s->end && bytesAvail == 0;
+  return s->end && bytesAvail == 0 && s->seek < 0;
 }
 gc_int32 ga_stream_seek(ga_BufferedStream* in_stream, gc_int32 in_sampleOffset)
 {
@@ -353,6 +368,7 @@ gc_int32 ga_stream_seek(ga_BufferedStream* in_stream, gc_int32 in_sampleOffset)
   gc_mutex_lock(s->seekMutex);
   s->seek = in_sampleOffset;
   gc_mutex_unlock(s->seekMutex);
+  gc_event_signal(s->mgr->bufferEvent);
   return 0;
 }
 gc_int32 ga_stream_tell(ga_BufferedStream* in_stream, gc_int32* out_totalSamples)
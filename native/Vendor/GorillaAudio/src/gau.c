@@ -17,6 +17,10 @@
 #endif /* __linux__ */
 
 /* High-Level Manager */
+/* Longest the background threads wait for work, bounding how long they take to notice shutdown */
+#define GAU_MIX_WAIT_TIMEOUT_MS 20
+#define GAU_STREAM_WAIT_TIMEOUT_MS 50
+
 typedef struct gau_Manager {
   gc_int32 threadPolicy;
   gc_Thread* mixThread;
@@ -37,13 +41,15 @@ static gc_int32 gauX_mixThreadFunc(void* in_context)
   gc_int32 sampleSize = ga_format_sampleSize(&ctx->format);
   while(!ctx->killThreads)
   {
-    gc_int32 numToQueue = ga_device_check(ctx->device);
-    while(numToQueue--)
+    /* Wakes as soon as the device frees a buffer */
+    gc_int32 numToQueue = ga_device_wait(ctx->device, GAU_MIX_WAIT_TIMEOUT_MS);
+    if(numToQueue < 0)
+      gc_thread_sleep(GAU_MIX_WAIT_TIMEOUT_MS);
+    while(numToQueue-- > 0)
     {
       ga_mixer_mix(m, ctx->mixBuffer);
       ga_device_queue(ctx->device, ctx->mixBuffer);
     }
-    gc_thread_sleep(5);
   }
   return 0;
 }
@@ -53,8 +59,9 @@ static gc_int32 gauX_streamThreadFunc(void* in_context)
   ga_StreamManager* mgr = ctx->streamMgr;
   while(!ctx->killThreads)
   {
+    /* Wakes when a stream drops below its low-watermark; the timeout retries streams whose source wasn't ready */
     ga_stream_manager_buffer(mgr);
-    gc_thread_sleep(50);
+    ga_stream_manager_wait(mgr, GAU_STREAM_WAIT_TIMEOUT_MS);
   }
   return 0;
 }
@@ -64,10 +71,12 @@ gau_Manager* gau_manager_create()
   ret = gau_manager_create_custom(GA_DEVICE_TYPE_DEFAULT, GAU_THREAD_POLICY_SINGLE, 4, 512);
   return ret;
 }
-gau_Manager* gau_manager_create_custom(gc_int32 in_devType,
-                                       gc_int32 in_threadPolicy,
-                                       gc_int32 in_numBuffers,
-                                       gc_int32 in_bufferSamples)
+static gau_Manager* gauX_manager_create(gc_int32 in_devType,
+                                        const char* in_filename,
+                                        gc_int32 in_fileFlags,
+                                        gc_int32 in_threadPolicy,
+                                        gc_int32 in_numBuffers,
+                                        gc_int32 in_bufferSamples)
 {
   gau_Manager* ret = gcX_ops->allocFunc(sizeof(gau_Manager));
 
@@ -81,8 +90,15 @@ gau_Manager* gau_manager_create_custom(gc_int32 in_devType,
   ret->format.bitsPerSample = 16;
   ret->format.numChannels = 2;
   ret->format.sampleRate = 44100;
-  ret->device = ga_device_open(in_devType, in_numBuffers, in_bufferSamples, &ret->format);
-  assert(ret->device);
+  if(in_filename)
+    ret->device = ga_device_open_file(in_filename, in_numBuffers, in_bufferSamples, &ret->format, in_fileFlags);
+  else
+    ret->device = ga_device_open(in_devType, in_numBuffers, in_bufferSamples, &ret->format);
+  if(!ret->device)
+  {
+    gcX_ops->freeFunc(ret);
+    return 0;
+  }
 
   /* Initialize mixer */
   ret->mixer = ga_mixer_create(&ret->format, in_bufferSamples);
@@ -108,6 +124,21 @@ gau_Manager* gau_manager_create_custom(gc_int32 in_devType,
 
   return ret;
 }
+gau_Manager* gau_manager_create_custom(gc_int32 in_devType,
+                                       gc_int32 in_threadPolicy,
+                                       gc_int32 in_numBuffers,
+                                       gc_int32 in_bufferSamples)
+{
+  return gauX_manager_create(in_devType, 0, 0, in_threadPolicy, in_numBuffers, in_bufferSamples);
+}
+gau_Manager* gau_manager_create_file(const char* in_filename,
+                                     gc_int32 in_fileFlags,
+                                     gc_int32 in_threadPolicy,
+                                     gc_int32 in_numBuffers,
+                                     gc_int32 in_bufferSamples)
+{
+  return gauX_manager_create(GA_DEVICE_TYPE_FILE, in_filename, in_fileFlags, in_threadPolicy, in_numBuffers, in_bufferSamples);
+}
 void gau_manager_update(gau_Manager* in_mgr)
 {
   if(in_mgr->threadPolicy == GAU_THREAD_POLICY_SINGLE)